@@ -2925,3 +2925,5 @@
  */
 #define DEBUG_IO PD0
 #define DEBUG_ISR_CPU_USAGE
+// DWT cycle probes on the hot paths, M2001 and SYS_ID_SUBSCRIBE_PROFILE report them
+//#define HOT_PATH_PROFILER
@@ -1605,7 +1605,7 @@
   //#define STATUS_ALT_FAN_BITMAP     // Use the alternative fan bitmap
   //#define STATUS_FAN_FRAMES 3       // :[0,1,2,3,4] Number of fan animation frames
   //#define STATUS_HEAT_PERCENT       // Show heating in a progress bar
-  //#define BOOT_MARLIN_LOGO_ANIMATED // Animated Marlin logo. Costs ~‭3260 (or ~940) bytes of PROGMEM.
+  //#define BOOT_MARLIN_LOGO_ANIMATED // Animated Marlin logo. Costs ~3260 (or ~940) bytes of PROGMEM.
 
   // Frivolous Game Options
   //#define MARLIN_BRICKOUT
@@ -2024,6 +2024,11 @@
   //#define ARC_P_CIRCLES           // Enable the 'P' parameter to specify complete circles
   //#define CNC_WORKSPACE_PLANES    // Allow G2/G3 to operate in XY, ZX, or YZ planes
   //#define SF_ARC_FIX              // Enable only if using SkeinForge with "Arc Point" fillet procedure
+  //#define ARC_NATIVE_MOVES        // Plan XY arcs as a few arc blocks, the shaper moves follow their chords
+  #if ENABLED(ARC_NATIVE_MOVES)
+    #define ARC_CHORD_TOLERANCE 0.005 // (mm) Largest distance of a chord from the arc
+    #define ARC_BLOCK_CHORDS       16 // Most chords in one arc block
+  #endif
 #endif
 
 // Support for G5 with XYZE destination and IJPQ offsets. Requires ~2666 bytes.
@@ -2126,7 +2131,15 @@
 #define BUFSIZE 4
 
 #define AXIS_SIZE 4
+// Motion, in ms, handed to the input shaper ahead of the steppers. The window
+// follows the time between incoming blocks between MIN_TIME and MAX, MIN_TIME
+// is where it starts. Below FLOOR blocks still being planned are handed over
+// with a stop, above it that waits for more G-code unless none is coming in
+// for INPUT_IDLE ms.
 #define SHAPED_WAITING_MIN_TIME 20
+#define SHAPED_WAITING_FLOOR_TIME 4
+#define SHAPED_WAITING_MAX_TIME 40
+#define SHAPED_INPUT_IDLE_TIME 100
 
 // Transmission to Host Buffer Size
 // To save 386 bytes of PROGMEM (and TX_BUFFER_SIZE+3 bytes of RAM) set to 0.
@@ -133,6 +133,12 @@ uint8_t adc_pins[] = {
   #if ENABLED(FILAMENT_WIDTH_SENSOR)
     FILWIDTH_PIN,
   #endif
+  #ifdef FILAMENT0_ADC_PIN
+    FILAMENT0_ADC_PIN,
+  #endif
+  #ifdef FILAMENT1_ADC_PIN
+    FILAMENT1_ADC_PIN,
+  #endif
 };
 
 enum TEMP_PINS : char {
@@ -162,12 +168,37 @@ enum TEMP_PINS : char {
   #endif
   #if ENABLED(FILAMENT_WIDTH_SENSOR)
     FILWIDTH,
+  #endif
+  #ifdef FILAMENT0_ADC_PIN
+    FILAMENT0,
+  #endif
+  #ifdef FILAMENT1_ADC_PIN
+    FILAMENT1,
   #endif
     ADC_PIN_COUNT
 };
 
+// Mean of the last half of the DMA ring for each pin
 uint16_t HAL_adc_results[ADC_PIN_COUNT];
 
+/*
+ * ADC1 converts the scan of adc_pins without a break and the DMA writes the
+ * scans into a ring of 2 * HAL_ADC_DMA_SCANS of them. The half and full
+ * transfer IRQs sum the half just written into the window sums, until the
+ * temperature ISR asks for the window to be closed.
+ */
+#define HAL_ADC_DMA_SCANS         16
+// A window nobody closes starts over before its sums can overflow
+#define HAL_ADC_WINDOW_MAX_SCANS  65536UL
+
+static uint16_t adc_dma_buf[2 * HAL_ADC_DMA_SCANS][ADC_PIN_COUNT];
+static uint32_t adc_acc[ADC_PIN_COUNT];
+static uint32_t adc_acc_scans;
+static uint32_t adc_window[ADC_PIN_COUNT];
+static uint32_t adc_window_scans;
+static volatile bool adc_close_request = false;
+static volatile bool adc_window_done = false;
+
 
 // --------------------------------------------------------------------------
 // Function prototypes
@@ -267,54 +298,113 @@ extern "C" {
 // --------------------------------------------------------------------------
 // ADC
 // --------------------------------------------------------------------------
-// Init the AD in continuous capture mode
-void HAL_adc_init(void) {
-  // configure the ADC
-  adc.calibrate();
-  adc.setSampleRate(ADC_SMPR_41_5); // ?
-  adc.setPins(adc_pins, ADC_PIN_COUNT);
-  adc.setDMA(HAL_adc_results, (uint16_t)ADC_PIN_COUNT, (uint32_t)(DMA_MINC_MODE | DMA_CIRC_MODE), (void (*)())NULL);
-  adc.setScanMode();
-  adc.setContinuous();
-  adc.startConversion();
+static void adc_dma_irq(void) {
+  uint8_t bits = dma_get_isr_bits(DMA1, DMA_CH1);
+  dma_clear_isr_bits(DMA1, DMA_CH1);
+  if (!(bits & (DMA_ISR_HTIF | DMA_ISR_TCIF))) return;
+
+  // The DMA goes on in the other half while this one is summed
+  uint16_t (*scan)[ADC_PIN_COUNT] = &adc_dma_buf[(bits & DMA_ISR_TCIF) ? HAL_ADC_DMA_SCANS : 0];
+  for (uint8_t i = 0; i < ADC_PIN_COUNT; i++) {
+    uint32_t sum = 0;
+    for (uint8_t s = 0; s < HAL_ADC_DMA_SCANS; s++)
+      sum += scan[s][i] & 0xFFF;
+    HAL_adc_results[i] = sum / HAL_ADC_DMA_SCANS;
+    adc_acc[i] += sum;
+  }
+  adc_acc_scans += HAL_ADC_DMA_SCANS;
+
+  bool close = adc_close_request && !adc_window_done;
+  if (close || adc_acc_scans >= HAL_ADC_WINDOW_MAX_SCANS) {
+    for (uint8_t i = 0; i < ADC_PIN_COUNT; i++) {
+      if (close) adc_window[i] = adc_acc[i];
+      adc_acc[i] = 0;
+    }
+    if (close) {
+      adc_window_scans = adc_acc_scans;
+      adc_close_request = false;
+      adc_window_done = true;
+    }
+    adc_acc_scans = 0;
+  }
 }
 
-void HAL_adc_start_conversion(const uint8_t adc_pin) {
-  TEMP_PINS pin_index = TEMP_0;
+static uint8_t adc_pin_index(const uint8_t adc_pin) {
   switch (adc_pin) {
     #if HAS_TEMP_ADC_0
-      case TEMP_0_PIN: pin_index = TEMP_0; break;
+      case TEMP_0_PIN: return TEMP_0;
     #endif
     #if HAS_HEATED_BED
-      case TEMP_BED_PIN: pin_index = TEMP_BED; break;
+      case TEMP_BED_PIN: return TEMP_BED;
     #endif
     #if HAS_HEATED_CHAMBER
-      case TEMP_CHAMBER_PIN: pin_index = TEMP_CHAMBER; break;
+      case TEMP_CHAMBER_PIN: return TEMP_CHAMBER;
     #endif
     #if HAS_TEMP_ADC_1
-      case TEMP_1_PIN: pin_index = TEMP_1; break;
+      case TEMP_1_PIN: return TEMP_1;
     #endif
     #if HAS_TEMP_ADC_2
-      case TEMP_2_PIN: pin_index = TEMP_2; break;
+      case TEMP_2_PIN: return TEMP_2;
     #endif
     #if HAS_TEMP_ADC_3
-      case TEMP_3_PIN: pin_index = TEMP_3; break;
+      case TEMP_3_PIN: return TEMP_3;
     #endif
     #if HAS_TEMP_ADC_4
-      case TEMP_4_PIN: pin_index = TEMP_4; break;
+      case TEMP_4_PIN: return TEMP_4;
     #endif
     #if HAS_TEMP_ADC_5
-      case TEMP_5_PIN: pin_index = TEMP_5; break;
+      case TEMP_5_PIN: return TEMP_5;
     #endif
     #if ENABLED(FILAMENT_WIDTH_SENSOR)
-      case FILWIDTH_PIN: pin_index = FILWIDTH; break;
+      case FILWIDTH_PIN: return FILWIDTH;
+    #endif
+    #ifdef FILAMENT0_ADC_PIN
+      case FILAMENT0_ADC_PIN: return FILAMENT0;
+    #endif
+    #ifdef FILAMENT1_ADC_PIN
+      case FILAMENT1_ADC_PIN: return FILAMENT1;
     #endif
   }
-  HAL_adc_result = HAL_adc_results[(int)pin_index] & 0xFFF;
-  if (adc_pin == TEMP_BED_PIN || adc_pin == TEMP_CHAMBER_PIN) {
-    HAL_adc_result = HAL_adc_result >> 2;  // shift to get 10 bits only.
-  }
+  return 0;
+}
+
+// Init the AD in continuous capture mode
+void HAL_adc_init(void) {
+  // configure the ADC
+  adc.calibrate();
+  // 252 cycles of the 20 MHz ADC clock a conversion, a scan of all pins some 13 kHz
+  adc.setSampleRate(ADC_SMPR_239_5);
+  adc.setPins(adc_pins, ADC_PIN_COUNT);
+  adc.setDMA(&adc_dma_buf[0][0], (uint16_t)(2 * HAL_ADC_DMA_SCANS * ADC_PIN_COUNT),
+             (uint32_t)(DMA_MINC_MODE | DMA_CIRC_MODE | DMA_HALF_TRNS | DMA_TRNS_CMPLT), adc_dma_irq);
+  adc.setScanMode();
+  adc.setContinuous();
+  adc.startConversion();
+}
+
+void HAL_adc_start_conversion(const uint8_t adc_pin) {
+  HAL_adc_result = HAL_adc_results[adc_pin_index(adc_pin)];
+}
+
+uint16_t HAL_adc_read(const uint8_t adc_pin) {
+  return HAL_adc_results[adc_pin_index(adc_pin)];
+}
+
+void HAL_adc_close_window(void) {
+  adc_close_request = true;
+}
+
+bool HAL_adc_window_ready(void) {
+  return adc_window_done;
+}
+
+uint32_t HAL_adc_window_mean(const uint8_t adc_pin, const uint32_t mul) {
+  if (!adc_window_scans) return 0;
+  return (uint64_t)adc_window[adc_pin_index(adc_pin)] * mul / adc_window_scans;
+}
 
+void HAL_adc_window_release(void) {
+  adc_window_done = false;
 }
 
 uint16_t HAL_adc_get_result(void) {
@@ -274,6 +274,10 @@ uint8_t eeprom_read_byte(uint8_t *pos);
 void eeprom_read_block(void *__dst, const void *__src, size_t __n);
 void eeprom_update_block(const void *__src, void *__dst, size_t __n);
 
+// Settings image of the flash EEPROM emulation, a data flash page less its header
+#include "../../../../snapmaker/module/flash_eeprom.h"
+#define MARLIN_EEPROM_SIZE (DATA_FLASH_PAGE_SIZE - FLASH_EEPROM_HEAD_WORDS * 4)
+
 //
 // ADC
 //
@@ -290,6 +294,21 @@ void HAL_adc_start_conversion(const uint8_t adc_pin);
 
 uint16_t HAL_adc_get_result(void);
 
+// Mean of the last 16 conversions of a pin, without waiting
+uint16_t HAL_adc_read(const uint8_t adc_pin);
+
+/*
+ * The DMA IRQ sums every conversion of the scan. HAL_adc_close_window()
+ * ends the window at the next half of the DMA ring, then the means of the
+ * window times mul are there until HAL_adc_window_release().
+ */
+#define HAL_ADC_DMA_OVERSAMPLE
+
+void HAL_adc_close_window(void);
+bool HAL_adc_window_ready(void);
+uint32_t HAL_adc_window_mean(const uint8_t adc_pin, const uint32_t mul);
+void HAL_adc_window_release(void);
+
 /* Todo: Confirm none of this is needed.
 uint16_t HAL_getAdcReading(uint8_t chan);
 
@@ -38,61 +38,42 @@
 
 #include <flash_stm32.h>
 #include <EEPROM.h>
-
-// Store settings in the last two pages
-// Flash pages must be erased before writing, so keep track.
-bool firstWrite = false;
-uint32_t pageBase = EEPROM_START_ADDRESS;
-
-#define HAL_GD32F1_EEPROM_SIZE 4096
-char HAL_GD32F1_eeprom_content[HAL_GD32F1_EEPROM_SIZE];
-
+#include "../../../../snapmaker/module/flash_eeprom.h"
+
+// Store settings in the two data flash pages of the EEPROM area, changed
+// words are appended to the valid page, see flash_eeprom.h
+#define HAL_GD32F1_EEPROM_SIZE MARLIN_EEPROM_SIZE
+static uint32_t HAL_GD32F1_eeprom_words[HAL_GD32F1_EEPROM_SIZE / 4];
+char * const HAL_GD32F1_eeprom_content = (char *)HAL_GD32F1_eeprom_words;
+static FlashEeprom flash_eeprom;
+static bool flash_eeprom_ready = false;
+
+static void flash_eeprom_init() {
+  if (!flash_eeprom_ready) {
+    flash_eeprom.init(EEPROM_START_ADDRESS, DATA_FLASH_PAGE_SIZE, (uint8_t *)HAL_GD32F1_eeprom_words, HAL_GD32F1_EEPROM_SIZE);
+    flash_eeprom_ready = true;
+  }
+}
 
 bool PersistentStore::access_start() {
-  uint32_t Address;
-  uint16_t *pBuff;
-  Address = pageBase;
-  pBuff = (uint16_t*)HAL_GD32F1_eeprom_content;
-  for (int i=0;i<HAL_GD32F1_EEPROM_SIZE;i=i+2) {
-      *pBuff++ = *((uint16_t*)Address);
-      Address += 2;
-  }
-  firstWrite = true;
+  flash_eeprom_init();
+  flash_eeprom.load(HAL_GD32F1_EEPROM_SIZE);
   return true;
 }
 
 bool PersistentStore::load(uint32_t len) {
-  uint32_t Address;
-  uint8_t *pBuff;
-  Address = pageBase;
-  pBuff = (uint8_t*)HAL_GD32F1_eeprom_content;
-  for (uint32_t i=0; i<len; i++) {
-      *pBuff++ = *((uint8_t*)Address);
-      Address++;
-  }
+  flash_eeprom_init();
+  flash_eeprom.load(len);
   return true;
 }
 
 bool PersistentStore::access_finish() {
-  uint32_t Address;
-  uint16_t *pu16value;
-
-
-  Address = pageBase;
-  pu16value = (uint16_t*)HAL_GD32F1_eeprom_content;
-  FLASH_Unlock();
-  FLASH_ErasePage(EEPROM_PAGE0_BASE);
-  FLASH_ErasePage(EEPROM_PAGE1_BASE);
-  for (int i=0;i<HAL_GD32F1_EEPROM_SIZE;i=i+2) {
-    FLASH_ProgramHalfWord(Address, *pu16value++);
-    Address += 2;
-  }
-  FLASH_Lock();
-  return true;
-
+  flash_eeprom_init();
+  return flash_eeprom.save();
 }
 
 bool PersistentStore::write_data(int &pos, const uint8_t *value, const size_t size, uint16_t *crc) {
+  if (pos < 0 || pos + size > capacity()) return true;
   int bytewritten = 0;
   int bytetowrite = size;
   uint8_t* Buff = (uint8_t *)value;
@@ -106,6 +87,7 @@ bool PersistentStore::write_data(int &pos, const uint8_t *value, const size_t si
 }
 
 bool PersistentStore::read_data(int &pos, uint8_t* value, const size_t size, uint16_t *crc, const bool writing/*=true*/) {
+  if (pos < 0 || pos + size > capacity()) return true;
   for (uint16_t i = 0; i < size; i++) {
     uint8_t c = HAL_GD32F1_eeprom_content[pos + i];
     if (writing) value[i] = c;
@@ -115,7 +97,7 @@ bool PersistentStore::read_data(int &pos, uint8_t* value, const size_t size, uin
   return false;
 }
 
-size_t PersistentStore::capacity() { return 4095; }
+size_t PersistentStore::capacity() { return HAL_GD32F1_EEPROM_SIZE - 1; }
 
 #endif // EEPROM_SETTINGS && EEPROM FLASH
 #endif // __GD32F1__
@@ -0,0 +1,155 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/**
+ * Stub HAL for host (Linux) builds of the motion core, see snapmaker/host.
+ * Timers keep the GD32 rates so step times come out in the same ticks,
+ * everything that touches hardware is a no-op.
+ */
+
+#define CPU_32_BIT
+
+#include <stdint.h>
+#include <Arduino.h>
+
+#include "../shared/math_32bit.h"
+#include "../../inc/MarlinConfigPre.h"
+
+// --------------------------------------------------------------------------
+// Timers
+// --------------------------------------------------------------------------
+
+#define FORCE_INLINE __attribute__((always_inline)) inline
+
+typedef uint16_t hal_timer_t;
+#define HAL_TIMER_TYPE_MAX 0xFFFF
+
+#define HAL_TIMER_RATE         uint32_t(F_CPU)
+
+#define STEP_TIMER_NUM 5
+#define TEMP_TIMER_NUM 2
+#define PULSE_TIMER_NUM STEP_TIMER_NUM
+
+#define TEMP_TIMER_PRESCALE     1000
+#define TEMP_TIMER_FREQUENCY    1000
+
+#define STEPPER_TIMER_PRESCALE 40
+#define STEPPER_TIMER_RATE     (HAL_TIMER_RATE / STEPPER_TIMER_PRESCALE)
+#define STEPPER_TIMER_TICKS_PER_US ((STEPPER_TIMER_RATE) / 1000000)
+#define STEPPER_TIMER_TICKS_PER_MS ((STEPPER_TIMER_RATE) / 1000)
+
+#define PULSE_TIMER_RATE       STEPPER_TIMER_RATE
+#define PULSE_TIMER_PRESCALE   STEPPER_TIMER_PRESCALE
+#define PULSE_TIMER_TICKS_PER_US STEPPER_TIMER_TICKS_PER_US
+
+#define ENABLE_STEPPER_DRIVER_INTERRUPT()
+#define DISABLE_STEPPER_DRIVER_INTERRUPT()
+#define STEPPER_ISR_ENABLED() false
+#define ENABLE_TEMPERATURE_INTERRUPT()
+#define DISABLE_TEMPERATURE_INTERRUPT()
+
+#define HAL_timer_get_count(timer_num) 0
+#define HAL_timer_set_compare(timer_num, compare)
+#define HAL_timer_isr_prologue(timer_num)
+#define HAL_timer_isr_epilogue(timer_num)
+
+#define HAL_TEMP_TIMER_ISR() extern "C" void tempTC_Handler(void)
+#define HAL_STEP_TIMER_ISR() extern "C" void stepTC_Handler(void)
+
+// --------------------------------------------------------------------------
+// Fast I/O
+// --------------------------------------------------------------------------
+
+#define READ(IO)              LOW
+#define WRITE(IO,V)           NOOP
+#define TOGGLE(IO)            NOOP
+#define WRITE_VAR(IO,V)       NOOP
+#define OUT_WRITE(IO,V)       NOOP
+#define SET_INPUT(IO)         NOOP
+#define SET_INPUT_PULLUP(IO)  NOOP
+#define SET_OUTPUT(IO)        NOOP
+#define SET_PWM(IO)           NOOP
+#define GET_INPUT(IO)         true
+#define GET_OUTPUT(IO)        false
+#define GET_TIMER(IO)         false
+#define PWM_PIN(P)            false
+#define USEABLE_HARDWARE_PWM(P) false
+#define extDigitalRead(IO)    digitalRead(IO)
+#define extDigitalWrite(IO,V) digitalWrite(IO,V)
+
+// --------------------------------------------------------------------------
+// Misc
+// --------------------------------------------------------------------------
+
+#define HAL_ADC_RESOLUTION  12
+#define HAL_ADC_RANGE _BV(HAL_ADC_RESOLUTION)
+
+// Serial output goes to stdout, nothing is ever received
+class HostSerial {
+  public:
+    void begin(const long) {}
+    void end() {}
+    bool connected() { return true; }
+    int available() { return 0; }
+    int peek() { return -1; }
+    int read() { return -1; }
+    void flush() {}
+    void flushTX() {}
+    size_t write(const uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+    template <typename... Args> void print(Args...) {}
+    template <typename... Args> void println(Args...) {}
+    template <typename... Args> void printf(Args...) {}
+};
+
+extern HostSerial MSerial1;
+
+#define MYSERIAL0 MSerial1
+#define MYSERIAL1 MSerial1
+#define NUM_SERIAL 1
+
+#define CRITICAL_SECTION_START
+#define CRITICAL_SECTION_END
+#define ISRS_ENABLED() true
+#define ENABLE_ISRS()
+#define DISABLE_ISRS()
+#define cli()
+#define sei()
+
+#define square(x) ((x)*(x))
+
+#ifndef strncpy_P
+  #define strncpy_P(dest, src, num) strncpy((dest), (src), (num))
+#endif
+#ifndef PGMSTR
+  #define PGMSTR(NAM,STR) const char NAM[] = STR
+#endif
+
+typedef int8_t pin_t;
+
+#define GET_PIN_MAP_PIN(index) index
+#define GET_PIN_MAP_INDEX(pin) pin
+#define PARSED_PIN_INDEX(code, dval) parser.intval(code, dval)
+
+inline void watchdog_refresh() {}
+inline void HAL_init() {}
+inline int freeMemory() { return 0; }
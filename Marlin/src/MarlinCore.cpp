@@ -72,6 +72,7 @@
 #include "../snapmaker/module/bed_control.h"
 #include "../snapmaker/module/filament_sensor.h"
 #include "../snapmaker/module/print_control.h"
+#include "../snapmaker/module/inactive_x.h"
 #include "../snapmaker/module/system.h"
 
 #if HAS_TOUCH_BUTTONS
@@ -1690,7 +1691,7 @@ AT_END_OF_TEXT void setup() {
   marlin_state = MF_RUNNING;
 
   SETUP_LOG("setup() completed.");
-  BaseType_t ret = xTaskCreate((TaskFunction_t)marlin_loop, "marlin_loop", 1024, NULL, 5, &thandle_marlin);
+  BaseType_t ret = xTaskCreate((TaskFunction_t)marlin_loop, "marlin_loop", 1024, NULL, 3, &thandle_marlin);
   if (ret != pdPASS) {
     SERIAL_ECHO("Failed to create marlin_loop!\n");
   }
@@ -1761,6 +1762,8 @@ void marlin_loop() {
 
     TERN_(HAS_TFT_LVGL_UI, printer_state_polling());
 
+    inactive_x.loop();
+
     calibtration.loop();
   }
 }
@@ -117,6 +117,7 @@
 
       idex_set_parked(true);
       set_duplication_enabled(false);
+      axisManager.input_shaper_select(axisManager.input_shaper_profile_of(active_extruder));
 
       #ifdef EVENT_GCODE_IDEX_AFTER_MODECHANGE
         gcode.process_subcommands_now_P(PSTR(EVENT_GCODE_IDEX_AFTER_MODECHANGE));
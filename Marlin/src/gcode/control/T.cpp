@@ -22,6 +22,7 @@
 
 #include "../gcode.h"
 #include "../../module/tool_change.h"
+#include "../../../../snapmaker/module/tool_lookahead.h"
 
 #if EITHER(HAS_MULTI_EXTRUDER, DEBUG_LEVELING_FEATURE)
   #include "../../module/motion.h"
@@ -61,10 +62,13 @@ void GcodeSuite::T(const int8_t tool_index) {
     }
   #endif
 
+  const uint8_t old_tool = active_extruder;
+  const millis_t start_ms = millis();
   tool_change(tool_index
     #if HAS_MULTI_EXTRUDER
       ,  TERN(PARKING_EXTRUDER, false, tool_index == active_extruder) // For PARKING_EXTRUDER motion is decided in tool_change()
       || parser.boolval('S')
     #endif
   );
+  tool_lookahead.tool_changed(old_tool, millis() - start_ms);
 }
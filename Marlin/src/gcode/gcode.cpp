@@ -1023,6 +1023,8 @@ void GcodeSuite::process_parsed_command(const bool no_ok/*=false*/) {
 
       case 1999: M1999(); break;                                  // M1999: Restart the machine
       case 2000: M2000(); break;
+      case 2001: M2001(); break;
+      case 2002: M2002(); break;
       case 2020: M2020(); break;
       case 593: M593(); break;
 
@@ -1073,7 +1075,13 @@ void GcodeSuite::process_next_command() {
 
   if (DEBUGGING(ECHO)) {
     SERIAL_ECHO_START();
-    SERIAL_ECHOLN(command.buffer);
+    if (command.buffer[0] == GCODE_BIN_MARK) {
+      char text[MAX_CMD_SIZE];
+      gcode_bin_to_text(command.buffer, text, sizeof(text));
+      SERIAL_ECHOLN(text);
+    }
+    else
+      SERIAL_ECHOLN(command.buffer);
     #if ENABLED(M100_FREE_MEMORY_DUMPER)
       SERIAL_ECHOPAIR("slot:", queue.ring_buffer.index_r);
       M100_dump_routine(PSTR("   Command Queue:"), (const char*)&queue.ring_buffer, sizeof(queue.ring_buffer));
@@ -1126,6 +1126,8 @@ private:
   static void M101();
   static void M1999();
   static void M2000();
+  static void M2001();
+  static void M2002();
   static void M2020();
   static void M593();
   static void T(const int8_t tool_index);
@@ -40,6 +40,48 @@
   #define N_ARC_CORRECTION 1
 #endif
 
+#if ENABLED(ARC_NATIVE_MOVES)
+  /**
+   * apply_motion_limits only clamps the ends of an arc block, while its chords
+   * follow the arc. The chords stay inside the circle, so when the box around
+   * the circle is within the soft endstops no chord can leave them. Otherwise
+   * the arc is segmented, which clamps every segment. In full control mode
+   * the box also keeps clear of the other X carriage, as apply_motion_limits
+   * does for a single target.
+   */
+  static bool arc_within_soft_endstops(const float center_x, const float center_y, const float radius) {
+    #if HAS_SOFTWARE_ENDSTOPS
+      if (!soft_endstop._enabled) return true;
+      if (axis_was_homed(X_AXIS)) {
+        #if ENABLED(MIN_SOFTWARE_ENDSTOP_X)
+          if (center_x - radius < soft_endstop.min.x) return false;
+        #endif
+        #if ENABLED(MAX_SOFTWARE_ENDSTOP_X)
+          if (center_x + radius > soft_endstop.max.x) return false;
+        #endif
+        if (dual_x_carriage_mode == DXC_FULL_CONTROL_MODE) {
+          if (active_extruder) {
+            if (center_x - radius < x_position() + EXTRUDERS_MIN_DISTANCE) return false;
+          } else {
+            if (center_x + radius > x2_position() - EXTRUDERS_MIN_DISTANCE) return false;
+          }
+        }
+      }
+      if (axis_was_homed(Y_AXIS)) {
+        #if ENABLED(MIN_SOFTWARE_ENDSTOP_Y)
+          if (center_y - radius < soft_endstop.min.y) return false;
+        #endif
+        #if ENABLED(MAX_SOFTWARE_ENDSTOP_Y)
+          if (center_y + radius > soft_endstop.max.y) return false;
+        #endif
+      }
+    #else
+      UNUSED(center_x); UNUSED(center_y); UNUSED(radius);
+    #endif
+    return true;
+  }
+#endif
+
 /**
  * Plan an arc in 2 dimensions, with optional linear motion in a 3rd dimension
  *
@@ -144,6 +186,62 @@ void plan_arc(
 
   const feedRate_t scaled_fr_mm_s = MMS_SCALED(feedrate_mm_s);
 
+  #if ENABLED(ARC_NATIVE_MOVES)
+    /**
+     * An XY arc goes to the planner as a few arc blocks instead of a block per
+     * segment. A block turns at most a quarter, so its start and end differ,
+     * and holds up to ARC_BLOCK_CHORDS chords. The shaper moves of the block
+     * follow the chords, which are within ARC_CHORD_TOLERANCE of the arc.
+     * The blocks join along the tangent, so the speed is only planned at the
+     * ends of the arc.
+     */
+    if (p_axis == X_AXIS && q_axis == Y_AXIS && radius > ARC_CHORD_TOLERANCE
+      && arc_within_soft_endstops(center_P, center_Q, radius)
+    ) {
+      const float chord_theta = 2 * ACOS(1 - (ARC_CHORD_TOLERANCE) / radius);
+      const uint16_t chords = _MAX(uint16_t(CEIL(ABS(angular_travel) / chord_theta)), min_segments),
+                     blocks = _MAX(CEIL(float(chords) / (ARC_BLOCK_CHORDS)), CEIL(ABS(angular_travel) / RADIANS(90)));
+      const uint8_t block_chords = CEIL(float(chords) / blocks);
+      const float theta_per_block = angular_travel / blocks,
+                  mm_per_block = mm_of_travel / blocks;
+      #if HAS_Z_AXIS
+        const float linear_per_block = linear_travel / blocks;
+      #endif
+      #if HAS_EXTRUDERS
+        const float extruder_per_block = extruder_travel / blocks;
+      #endif
+
+      xyze_pos_t raw = current_position;
+      ab_float_t block_rvec = rvec;
+      millis_t next_idle_ms = millis() + 200UL;
+      for (uint16_t i = 1; i < blocks; i++) {
+        thermalManager.manage_heater();
+        if (ELAPSED(millis(), next_idle_ms)) {
+          next_idle_ms = millis() + 200UL;
+          idle();
+        }
+
+        const float cos_Ti = cos(i * theta_per_block), sin_Ti = sin(i * theta_per_block);
+        const ab_float_t next_rvec = { -offset[0] * cos_Ti + offset[1] * sin_Ti, -offset[0] * sin_Ti - offset[1] * cos_Ti };
+        raw.x = center_P + next_rvec.a;
+        raw.y = center_Q + next_rvec.b;
+        TERN_(HAS_Z_AXIS, raw.z += linear_per_block);
+        TERN_(HAS_EXTRUDERS, raw.e += extruder_per_block);
+
+        apply_motion_limits(raw);
+        if (!planner.buffer_arc(raw, block_rvec, theta_per_block, block_chords, scaled_fr_mm_s, active_extruder, mm_per_block)) break;
+        block_rvec = next_rvec;
+      }
+
+      // The last block ends on the target
+      raw = cart;
+      apply_motion_limits(raw);
+      planner.buffer_arc(raw, block_rvec, theta_per_block, block_chords, scaled_fr_mm_s, active_extruder, mm_per_block);
+      current_position = raw;
+      return;
+    }
+  #endif
+
   // Start with a nominal segment length
   float seg_length = (
     #ifdef ARC_SEGMENTS_PER_R
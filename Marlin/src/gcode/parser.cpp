@@ -62,6 +62,7 @@ uint16_t GCodeParser::codenum;
   // Optimized Parameters
   uint32_t GCodeParser::codebits;  // found bits
   uint8_t GCodeParser::param[26];  // parameter offsets from command_ptr
+  bool GCodeParser::binary_values; // param offsets point at floats
 #else
   char *GCodeParser::command_args; // start of parameters
 #endif
@@ -82,6 +83,7 @@ void GCodeParser::reset() {
   TERN_(USE_GCODE_SUBCODES, subcode = 0); // No command sub-code
   #if ENABLED(FASTER_GCODE_PARSER)
     codebits = 0;                       // No codes yet
+    binary_values = false;              // Values are text
     //ZERO(param);                      // No parameters (should be safe to comment out this line)
   #endif
 }
@@ -120,6 +122,11 @@ void GCodeParser::parse(char *p) {
     return c;
   };
 
+  #if ENABLED(FASTER_GCODE_PARSER)
+    // Pre-parsed by the binary G-code transport, no text to scan
+    if (*p == GCODE_BIN_MARK) return parse_binary(p);
+  #endif
+
   // Skip spaces
   while (*p == ' ') ++p;
 
@@ -363,6 +370,25 @@ void GCodeParser::parse(char *p) {
   }
 }
 
+#if ENABLED(FASTER_GCODE_PARSER)
+
+  /**
+   * Take a command decoded by gcode_bin_decode():
+   *   GCODE_BIN_MARK, letter, codenum (LE16), count, count * { letter, float }
+   * Parameter offsets point at the float of each letter.
+   */
+  void GCodeParser::parse_binary(char *p) {
+    command_ptr = p;
+    command_letter = p[1];
+    codenum = (uint8_t)p[2] | (uint8_t)p[3] << 8;
+    binary_values = true;
+    char *v = p + GCODE_BIN_HEAD_SIZE;
+    for (uint8_t count = p[4]; count; count--, v += GCODE_BIN_VALUE_SIZE)
+      set(v[0], v + 1);
+  }
+
+#endif
+
 #if ENABLED(CNC_COORDINATE_SYSTEMS)
 
   // Parse the next parameter as a new command
@@ -28,6 +28,7 @@
  */
 
 #include "../inc/MarlinConfig.h"
+#include "../../../snapmaker/protocol/gcode_binary.h"
 
 //#define DEBUG_GCODE_PARSER
 #if ENABLED(DEBUG_GCODE_PARSER)
@@ -62,6 +63,8 @@ private:
   #if ENABLED(FASTER_GCODE_PARSER)
     static uint32_t codebits;       // Parameters pre-scanned
     static uint8_t param[26];       // For A-Z, offsets into command args
+    static bool binary_values;      // Values are floats of a pre-parsed command, see gcode_binary.h
+    static void parse_binary(char *p);
   #else
     static char *command_args;      // Args start here, for slow scan
   #endif
@@ -149,7 +152,7 @@ public:
       if (b) {
         if (param[ind]) {
           char * const ptr = command_ptr + param[ind];
-          value_ptr = valid_number(ptr) ? ptr : nullptr;
+          value_ptr = (binary_values || valid_number(ptr)) ? ptr : nullptr;
         }
         else
           value_ptr = nullptr;
@@ -259,6 +262,13 @@ public:
   // Float removes 'E' to prevent scientific notation interpretation
   static inline float value_float() {
     if (value_ptr) {
+      #if ENABLED(FASTER_GCODE_PARSER)
+        if (binary_values) {
+          float ret;
+          memcpy(&ret, value_ptr, sizeof(ret));
+          return ret;
+        }
+      #endif
       char *e = value_ptr;
       for (;;) {
         const char c = *e;
@@ -277,8 +287,14 @@ public:
   }
 
   // Code value as a long or ulong
-  static inline int32_t value_long() { return value_ptr ? strtol(value_ptr, nullptr, 10) : 0L; }
-  static inline uint32_t value_ulong() { return value_ptr ? strtoul(value_ptr, nullptr, 10) : 0UL; }
+  static inline int32_t value_long() {
+    if (TERN0(FASTER_GCODE_PARSER, binary_values)) return value_ptr ? (int32_t)value_float() : 0L;
+    return value_ptr ? strtol(value_ptr, nullptr, 10) : 0L;
+  }
+  static inline uint32_t value_ulong() {
+    if (TERN0(FASTER_GCODE_PARSER, binary_values)) return value_ptr ? (uint32_t)(int32_t)value_float() : 0UL;
+    return value_ptr ? strtoul(value_ptr, nullptr, 10) : 0UL;
+  }
 
   // Code value for use as time
   static inline millis_t value_millis() { return value_ulong(); }
@@ -37,6 +37,8 @@ GCodeQueue queue;
 #include "../MarlinCore.h"
 #include "../core/bug_on.h"
 #include "../../../snapmaker/module/print_control.h"
+#include "../../../snapmaker/module/tool_lookahead.h"
+#include "../../../snapmaker/debug/profiler.h"
 #if ENABLED(PRINTER_EVENT_LEDS)
   #include "../feature/leds/printer_event_leds.h"
 #endif
@@ -556,6 +558,7 @@ void GCodeQueue::get_hmi_commands() {
     ring_buffer.commands[ring_buffer.index_w].skip_ok = true;
     ring_buffer.advance_pos(ring_buffer.index_w, 1);
   }
+  tool_lookahead.update();
 }
 
 #if ENABLED(SDSUPPORT)
@@ -647,6 +650,8 @@ void GCodeQueue::advance() {
   // Return if the G-code buffer is empty
   if (ring_buffer.empty()) return;
 
+  PROFILE_SCOPE(PROFILE_GCODE_ADVANCE);
+
   #if ENABLED(SDSUPPORT)
 
     if (card.flag.saving) {
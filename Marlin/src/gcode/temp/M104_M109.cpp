@@ -38,6 +38,7 @@
 
 #include "../../MarlinCore.h" // for startOrResumeJob, etc.
 #include "../../../../snapmaker/module/print_control.h"
+#include "../../../../snapmaker/module/tool_lookahead.h"
 #if ENABLED(PRINTJOB_TIMER_AUTOSTART)
   #include "../../module/printcounter.h"
   #if ENABLED(CANCEL_OBJECTS)
@@ -151,10 +152,12 @@ void GcodeSuite::M104_M109(const bool isM109) {
     got_temp = no_wait_for_cooling || (isM109 && parser.seenval('R'));
     if (got_temp) temp = parser.value_celsius();
 
+    const millis_t start_ms = millis();
     (void)thermalManager.wait_for_hotend(target_extruder, no_wait_for_cooling, time_windown, temp_windown);
     if (idex_is_duplicating()) {
       (void)thermalManager.wait_for_hotend(!target_extruder, no_wait_for_cooling, time_windown, temp_windown);
     }
+    tool_lookahead.heat_waited(millis() - start_ms);
   }
 }
 
@@ -28,7 +28,11 @@
 #include "MarlinConfigPre.h"
 
 #ifndef __MARLIN_DEPS__
-  #include "../HAL/HAL_GD32F1/HAL.h"
+  #ifdef __PLAT_LINUX__
+    #include "../HAL/LINUX/HAL.h"
+  #else
+    #include "../HAL/HAL_GD32F1/HAL.h"
+  #endif
 #endif
 
 #include "../pins/pins.h"
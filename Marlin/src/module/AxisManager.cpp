@@ -20,6 +20,7 @@
  */
 
 #include "AxisManager.h"
+#include "motion.h"
 #include "shaper/MoveQueue.h"
 #include "../gcode/gcode.h"
 
@@ -40,36 +41,47 @@ static const char *dbg_name[SHAPER_DBG_MAX] = {
   "NOT_ENOUGH_FUNC_LIST_RESC",
   "CALC_STEP_TIMEOUT_COUNT",
   "CALC_STEP_TIME",
-  "ABORT_END_BLOCK"
+  "ABORT_END_BLOCK",
+  "STEP_QUEUE_UNDERRUN",
+  "STEP_QUEUE_ISR_CALC"
 };
 
 
-void AxisManager::input_shaper_reset() {
-
-  AxisInputShaper::axis_input_shaper_x.type = (InputShaperType)DEFAULT_IS_TYPE;
-  AxisInputShaper::axis_input_shaper_x.frequency = DEFAULT_IS_FREQ;
-  AxisInputShaper::axis_input_shaper_x.zeta = DEFAULT_IS_DAMP;
-
-  AxisInputShaper::axis_input_shaper_y.type = (InputShaperType)DEFAULT_IS_TYPE;
-  AxisInputShaper::axis_input_shaper_y.frequency = DEFAULT_IS_FREQ;
-  AxisInputShaper::axis_input_shaper_y.zeta = DEFAULT_IS_DAMP;
-
+// From the stepper ISR when the async X axis stops, done or aborted
+void AxisManager::T0_T1_move_end() {
+  inactive_x_step_pos += T0_T1_execute_steps;
+  if (T0_T1_execute_steps == T0_T1_calc_steps)
+    inactive_extruder_x = T0_T1_target_pos;
+  else
+    inactive_extruder_x = T0_T1_start_pos + T0_T1_execute_steps / planner.settings.axis_steps_per_mm[X_AXIS];
+  T0_T1_simultaneously_move = false;
 }
 
-ErrCode AxisManager::input_shaper_set(int axis, int type, float freq, float dampe)  {
+static AxisInputShaper *input_shaper_of(int axis) {
+  return axis == X_AXIS ? &AxisInputShaper::axis_input_shaper_x : &AxisInputShaper::axis_input_shaper_y;
+}
 
-  if ((axis != X_AXIS && axis != Y_AXIS) || freq == 0 || (InputShaperType)type > InputShaperType::zvddd) return E_PARAM;
+void AxisManager::input_shaper_reset() {
+  for (uint8_t p = 0; p < SHAPER_PROFILE_COUNT; p++) {
+    for (int i = X_AXIS; i <= Y_AXIS; i++) {
+      shaper_profiles[p][i].type = DEFAULT_IS_TYPE;
+      shaper_profiles[p][i].freq = DEFAULT_IS_FREQ;
+      shaper_profiles[p][i].zeta = DEFAULT_IS_DAMP;
+    }
+  }
+  input_shaper_load();
+}
 
-  AxisInputShaper* axis_input_shaper = axisManager.axis[axis].axis_input_shaper;
-  if (freq != axis_input_shaper->frequency || dampe != axis_input_shaper->zeta || type != (int)axis_input_shaper->type) {
-    axis_input_shaper->setConfig(type, freq, dampe);
-    planner.synchronize();
-    axisManager.initAxisShaper();
-    axisManager.abort();
+// The shapers take the settings of the selected profile, in use from the next initAxisShaper()
+void AxisManager::input_shaper_load() {
+  for (int i = X_AXIS; i <= Y_AXIS; i++) {
+    const shaper_config_t &config = shaper_profiles[shaper_profile][i];
+    input_shaper_of(i)->setConfig(config.type, config.freq, config.zeta);
   }
-  LOG_I("setting: axis: %d type: %s, frequency: %lf, zeta: %lf\n", axis, input_shaper_type_name[type], freq, dampe);
+}
 
-  return E_SUCCESS;
+ErrCode AxisManager::input_shaper_set(int axis, int type, float freq, float dampe)  {
+  return input_shaper_profile_set(shaper_profile, axis, type, freq, dampe);
 }
 
 ErrCode AxisManager::input_shaper_get(int axis, int &type, float &freq, float &dampe) {
@@ -85,11 +97,87 @@ ErrCode AxisManager::input_shaper_get(int axis, int &type, float &freq, float &d
   return E_SUCCESS;
 }
 
+// A profile other than the selected one is only stored, it is used once a tool change or M605 selects it
+ErrCode AxisManager::input_shaper_profile_set(uint8_t profile, int axis, int type, float freq, float dampe) {
+
+  if (profile >= SHAPER_PROFILE_COUNT || (axis != X_AXIS && axis != Y_AXIS) || freq == 0 || (InputShaperType)type > InputShaperType::zvddd) return E_PARAM;
+
+  shaper_config_t &config = shaper_profiles[profile][axis];
+  config.type = type;
+  config.freq = freq;
+  config.zeta = dampe;
+
+  if (profile == shaper_profile) {
+    AxisInputShaper* axis_input_shaper = input_shaper_of(axis);
+    if (freq != axis_input_shaper->frequency || dampe != axis_input_shaper->zeta || type != (int)axis_input_shaper->type) {
+      axis_input_shaper->setConfig(type, freq, dampe);
+      planner.synchronize();
+      axisManager.initAxisShaper();
+      axisManager.abort();
+    }
+  }
+  LOG_I("setting: profile: %d axis: %d type: %s, frequency: %lf, zeta: %lf\n", profile, axis, input_shaper_type_name[type], freq, dampe);
+
+  return E_SUCCESS;
+}
+
+ErrCode AxisManager::input_shaper_profile_get(uint8_t profile, int axis, int &type, float &freq, float &dampe) {
+
+  if (profile >= SHAPER_PROFILE_COUNT || (axis != X_AXIS && axis != Y_AXIS)) return E_PARAM;
+
+  const shaper_config_t &config = shaper_profiles[profile][axis];
+  type = config.type;
+  freq = config.freq;
+  dampe = config.zeta;
+
+  return E_SUCCESS;
+}
+
+// Profile of a tool in the current carriage mode
+uint8_t AxisManager::input_shaper_profile_of(uint8_t tool) {
+  #if ENABLED(DUAL_X_CARRIAGE)
+    if (dual_x_carriage_mode == DXC_DUPLICATION_MODE) return SHAPER_PROFILE_DUPLICATION;
+    if (dual_x_carriage_mode == DXC_MIRRORED_MODE) return SHAPER_PROFILE_MIRRORED;
+  #endif
+  return tool ? 1 : 0;
+}
+
+/*
+ Switch the shapers to a profile. The callers, tool_change() and M605, have
+ synchronized the planner already, so the restart of the shaper only drops
+ the empty move padding the end of the last block and costs no motion.
+ The blocks queued after it must not be dropped with the abort, so wait for
+ shaped_loop() to finish it.
+*/
+void AxisManager::input_shaper_select(uint8_t profile) {
+  if (profile >= SHAPER_PROFILE_COUNT || profile == shaper_profile) return;
+
+  shaper_profile = profile;
+  bool changed = false;
+  for (int i = X_AXIS; i <= Y_AXIS; i++) {
+    const shaper_config_t &config = shaper_profiles[profile][i];
+    AxisInputShaper* axis_input_shaper = input_shaper_of(i);
+    if (config.freq != axis_input_shaper->frequency || config.zeta != axis_input_shaper->zeta || config.type != (uint8_t)axis_input_shaper->type) {
+      axis_input_shaper->setConfig(config.type, config.freq, config.zeta);
+      changed = true;
+    }
+  }
+  LOG_I("input shaper profile: %d, changed: %d\n", profile, changed);
+
+  if (changed) {
+    planner.synchronize();
+    initAxisShaper();
+    abort();
+    planner.synchronize();
+  }
+}
+
 void AxisManager::show_debug_info() {
   LOG_I("debug info for input shaper:\n");
   for (int i = 0; i < SHAPER_DBG_MAX; i++) {
     LOG_I("[%s] = %d\n", dbg_name[i], counts[i]);
   }
+  LOG_I("step queue: %d/%d, min %d\n", getAxisStepperSize(), AXIS_STEPPER_SIZE - 1, axis_stepper_min_size);
 }
 
 
@@ -97,6 +185,7 @@ void AxisManager::reset_debug_info() {
   for (int i = 0; i < SHAPER_DBG_MAX; i++) {
     counts[i] = 0;
   }
+  axis_stepper_min_size = AXIS_STEPPER_SIZE;
 }
 
 void GcodeSuite::M593() {
@@ -111,6 +200,45 @@ void GcodeSuite::M593() {
         axisManager.reset_debug_info();
         return;
     }
+
+    // J<stages> Q<ramp>: S-curve acceleration, J0 for the trapezoid
+    if (parser.seen('J')) {
+        uint8_t stages = parser.value_byte();
+        float ramp = parser.floatval('Q', moveQueue.s_curve_ramp);
+        planner.synchronize();
+        moveQueue.setSCurve(stages, ramp);
+        LOG_I("S-curve stages: %d, ramp: %lf\n", moveQueue.s_curve_stages, moveQueue.s_curve_ramp);
+        return;
+    }
+
+    // S<profile>: X and Y of a profile other than the selected one, stored until a tool change selects it
+    if (parser.seen('S') && parser.value_byte() != axisManager.shaper_profile) {
+        const uint8_t profile = parser.value_byte();
+        bool x = parser.seen('X');
+        bool y = parser.seen('Y');
+        if (!x && !y) {
+            x = true;
+            y = true;
+        }
+        for (int i = X_AXIS; i <= Y_AXIS; i++) {
+            if (!(i == X_AXIS ? x : y)) {
+                continue;
+            }
+            int type;
+            float frequency, zeta;
+            if (axisManager.input_shaper_profile_get(profile, i, type, frequency, zeta) != E_SUCCESS) {
+                LOG_I("input shaper profile %d does not exist\n", profile);
+                return;
+            }
+            frequency = parser.floatval('F', frequency);
+            zeta = parser.floatval('D', zeta);
+            type = parser.intval('P', type);
+            if (axisManager.input_shaper_profile_set(profile, i, type, frequency, zeta) != E_SUCCESS) {
+                LOG_I("%c input shaper setting failed, frequency cannot be zero or type error!!!\n", i == X_AXIS ? 'X' : 'Y');
+            }
+        }
+        return;
+    }
     // if (axisManager.req_update_shaped) {
     //     LOG_I("Send too many\n");
     //     return;
@@ -178,6 +306,11 @@ void GcodeSuite::M593() {
     }
     LOG_I("update: %d\n", update);
     if (update) {
+        // The selected profile keeps what the shapers run
+        for (int i = X_AXIS; i <= Y_AXIS; i++) {
+            AxisInputShaper* axis_input_shaper = axisManager.axis[i].axis_input_shaper;
+            axisManager.shaper_profiles[axisManager.shaper_profile][i] = { (uint8_t)axis_input_shaper->type, axis_input_shaper->frequency, axis_input_shaper->zeta };
+        }
         planner.synchronize();
         axisManager.initAxisShaper();
         axisManager.abort();
@@ -295,8 +428,8 @@ FORCE_INLINE bool Axis::generateEAxisFuncParams(uint8_t block_index, uint8_t mov
             time_double_t end_t = move->start_t + zero_t;
             func_manager.addFuncParamsExtend(a, b, c, type, end_t, y2);
 
-            y2 = move->end_pos_e + delta_e + eda;
-            dy = move->end_pos_e - move->start_pos_e + eda - zero_pos;
+            y2 = move->end_pos_e() + delta_e + eda;
+            dy = move->end_pos_e() - move->start_pos_e + eda - zero_pos;
             x2 = move->t - zero_t;
             dx = move->t - zero_t;
 
@@ -309,11 +442,11 @@ FORCE_INLINE bool Axis::generateEAxisFuncParams(uint8_t block_index, uint8_t mov
                 type = dy > 0 ? 1 : -1;
             }
 
-            end_t = move->end_t;
+            end_t = move->end_t();
             func_manager.addFuncParamsExtend(a, b, c, type, end_t, y2);
         } else {
-            y2 = move->end_pos_e + delta_e + eda;
-            dy = move->end_pos_e - move->start_pos_e + eda;
+            y2 = move->end_pos_e() + delta_e + eda;
+            dy = move->end_pos_e() - move->start_pos_e + eda;
             x2 = move->t;
             dx = move->t;
 
@@ -326,7 +459,7 @@ FORCE_INLINE bool Axis::generateEAxisFuncParams(uint8_t block_index, uint8_t mov
             } else {
                 type = dy > 0 ? 1 : -1;
             }
-            time_double_t end_t = move->end_t;
+            time_double_t end_t = move->end_t();
             func_manager.addFuncParamsExtend(a, b, c, type, end_t, y2);
         }
 
@@ -368,8 +501,8 @@ FORCE_INLINE bool Axis::generateAxisFuncParams(uint8_t move_start, uint8_t move_
 
 
 // FORCE_INLINE void Axis::generateLineFuncParams(Move* move) {
-//     float y2 = move->end_pos[axis];
-//     float dy = move->end_pos[axis] - move->start_pos[axis];
+//     float y2 = move->end_pos(axis);
+//     float dy = move->end_pos(axis) - move->start_pos[axis];
 //     float x2 = move->t;
 //     float dx = move->t;
 
@@ -383,7 +516,7 @@ FORCE_INLINE bool Axis::generateAxisFuncParams(uint8_t move_start, uint8_t move_
 //     } else {
 //         type = dy > 0 ? 1 : -1;
 //     }
-//     time_double_t end_t = move->end_t;
+//     time_double_t end_t = move->end_t();
 //     func_manager.addFuncParams(a, b, c, type, end_t, y2);
 // }
 
@@ -413,9 +546,7 @@ bool AxisManager::generateAllAxisFuncParams(uint8_t block_index, block_t* block)
     // LOG_I("start %d, end %d\n", move_start, move_end);
 
     for (int i = 0; i < AXIS_SIZE; ++i) {
-        if (i < 2 && axis[i].func_manager.getFreeSize() < 15) {
-            axisManager.counts[SHAPER_DBG_NOT_ENOUGH_FUNC_LIST_RESC]++;
-        } else if (i >= 2 && axis[i].func_manager.getFreeSize() < 4) {
+        if (axis[i].func_manager.getFreeSize() < getFuncParamsRoom(i, block)) {
             axisManager.counts[SHAPER_DBG_NOT_ENOUGH_FUNC_LIST_RESC]++;
         }
         if (!axis[i].generateFuncParams(block_index, move_start, move_end)) {
@@ -495,11 +626,15 @@ bool AxisManager::calcNextAxisStepper() {
 
         axis_stepper->axis = print_axis;
         axis_stepper->dir = print_dir;
-        axis_stepper->delta_time = min_print_time - print_time;
+        float delta_time = min_print_time - print_time;
+        axis_stepper->ticks = delta_time > 0 ? (uint32_t)(delta_time * STEPPER_TIMER_TICKS_PER_MS) : 0;
         axis_stepper->print_time = min_print_time;
 
         print_time = min_print_time;
 
+        // Publish the event only after it has been written, the stepper ISR
+        // may pop it as soon as the head moves
+        __asm__ __volatile__("" ::: "memory");
         axis_steppper_head = nextAxisStepper(axis_steppper_head);
 
         return true;
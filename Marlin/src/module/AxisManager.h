@@ -30,8 +30,31 @@
 
 #define T0_T1_AXIS_INDEX  (4)
 
-#define AXIS_STEPPER_SIZE 4
+// Step events are solved ahead of time by the temperature ISR and only popped
+// by the stepper ISR. Must be a power of 2, 128 events hold ~2ms at full speed
+#define AXIS_STEPPER_SIZE 128
 #define AXIS_STEPPER_MOD(n) ((n)&(AXIS_STEPPER_SIZE-1))
+// Free function params an axis keeps per move of the next block, and one more for Z and E
+#define FUNC_PARAMS_MOVE_ROOM_XY 8
+#define FUNC_PARAMS_MOVE_ROOM 1
+// Input shaper profiles: T0 and T1 in full control and auto park, then the
+// duplication and mirrored modes, which move both carriages
+#define SHAPER_PROFILE_DUPLICATION 2
+#define SHAPER_PROFILE_MIRRORED    3
+#define SHAPER_PROFILE_COUNT       4
+// The stepper ISR solves a step itself only when the queue drops below this
+#define AXIS_STEPPER_LOW_WATER 2
+// Step events the temperature ISR solves per tick at most, 16k events/s.
+// Faster streams get the rest from the stepper ISR as before.
+#define AXIS_STEPPER_PRODUCE_MAX 16
+// Steps closer than this to the previous one are output in the same ISR
+#define AXIS_STEPPER_ZERO_TICKS (STEPPER_TIMER_TICKS_PER_MS / 200)
+
+typedef struct {
+    uint8_t type;
+    float freq;
+    float zeta;
+} shaper_config_t;
 
 enum InputShaperDebugInfoType {
   SHAPER_DBG_EMPTY_MOVES_COUNT = 0,
@@ -41,6 +64,8 @@ enum InputShaperDebugInfoType {
   SHAPER_DBG_CALC_STEP_TIMEOUT_COUNT,
   SHAPER_DBG_CALC_STEP_TIME,
   SHAPER_DBG_ABORT_END_BLOCK,
+  SHAPER_DBG_STEP_QUEUE_UNDERRUN,
+  SHAPER_DBG_STEP_QUEUE_ISR_CALC,
 
   SHAPER_DBG_MAX
 };
@@ -48,10 +73,9 @@ enum InputShaperDebugInfoType {
 class AxisStepper {
   public:
     int8_t axis = -1;
-    int8_t last_axis = -1;
     int8_t dir = 0;
+    uint32_t ticks = 0;   // Timer ticks since the previous step event
     time_double_t print_time = 0;
-    float delta_time = 0;
 };
 
 class Axis {
@@ -139,14 +163,17 @@ class Axis {
     bool getNextStep();
     float getCurrentSpeedMMs();
 
-    FORCE_INLINE void generateLineFuncParams(Move* move) {
-        float y2 = move->end_pos[axis];
-        float dy = move->end_pos[axis] - move->start_pos[axis];
+    FORCE_INLINE void generateLineFuncParams(Move* move) { generateLineFuncParams(move, axis); }
+
+    // index is the axis slot of the move, the T0/T1 carriage moves in the X slot
+    FORCE_INLINE void generateLineFuncParams(Move* move, int index) {
+        float y2 = move->end_pos(index);
+        float dy = move->end_pos(index) - move->start_pos[index];
         float x2 = move->t;
         float dx = move->t;
 
-        float a = 0.5f * move->accelerate * move->axis_r[axis];
-        float c = move->start_pos[axis];
+        float a = 0.5f * move->accelerate * move->axis_r[index];
+        float c = move->start_pos[index];
         float b = dy / dx - a * x2;
 
         // LOG_I("a %f b %f c %f\r\n", a, b, c);
@@ -157,7 +184,7 @@ class Axis {
         } else {
             type = dy > 0 ? 1 : -1;
         }
-        time_double_t end_t = move->end_t;
+        time_double_t end_t = move->end_t();
         func_manager.addFuncParams(a, b, c, type, end_t, y2);
     }
 
@@ -176,6 +203,7 @@ class AxisManager {
     bool T0_T1_simultaneously_move_req = false;
     bool T0_T1_simultaneously_move = false;
     float T0_T1_target_pos;
+    float T0_T1_start_pos;
     int32_t T0_T1_execute_steps;
     int32_t T0_T1_calc_steps;
     int32_t inactive_x_step_pos;
@@ -197,6 +225,9 @@ class AxisManager {
     float shaped_left_delta = 0;
     float shaped_right_delta = 0;
     float shaped_delta_window = 0;
+    // X and Y settings per profile, the shapers run the one selected
+    shaper_config_t shaper_profiles[SHAPER_PROFILE_COUNT][2];
+    uint8_t shaper_profile = 0;
 
     // FuncManager Generate
     time_double_t min_last_time = 0;
@@ -208,9 +239,12 @@ class AxisManager {
     int8_t print_dir = 0;
     int current_steps[AXIS_SIZE];
 
+    // Single producer (calcNextAxisStepper) single consumer (stepper ISR)
     AxisStepper axis_steppers[AXIS_STEPPER_SIZE];
-    uint8_t axis_steppper_tail;
-    uint8_t axis_steppper_head;
+    volatile uint8_t axis_steppper_tail;
+    volatile uint8_t axis_steppper_head;
+    volatile bool axis_stepper_producing = false;
+    uint8_t axis_stepper_min_size = AXIS_STEPPER_SIZE;
 
     FORCE_INLINE uint8_t getAxisStepperSize() {
         return AXIS_STEPPER_MOD(axis_steppper_head - axis_steppper_tail);
@@ -230,8 +264,14 @@ class AxisManager {
     void input_shaper_reset();
     ErrCode input_shaper_set(int axis, int type, float freq, float dampe);
     ErrCode input_shaper_get(int axis, int &type, float &freq, float &dampe);
+    ErrCode input_shaper_profile_set(uint8_t profile, int axis, int type, float freq, float dampe);
+    ErrCode input_shaper_profile_get(uint8_t profile, int axis, int &type, float &freq, float &dampe);
+    uint8_t input_shaper_profile_of(uint8_t tool);
+    void input_shaper_select(uint8_t profile);
+    void input_shaper_load();
     void show_debug_info();
     void reset_debug_info();
+    void T0_T1_move_end();
 
     AxisManager() {};
 
@@ -298,6 +338,34 @@ class AxisManager {
         axis_steppper_head = 0;
     }
 
+    /*
+     Solve up to AXIS_STEPPER_PRODUCE_MAX step events, fewer if the queue fills.
+     Called from the temperature ISR, the stepper ISR preempts it and only pops.
+    */
+    void produceAxisSteppers() {
+        if (req_abort || axis_stepper_producing) {
+            return;
+        }
+        axis_stepper_producing = true;
+        for (uint8_t n = 0; n < AXIS_STEPPER_PRODUCE_MAX && !req_abort && calcNextAxisStepper(); n++) {
+        }
+        axis_stepper_producing = false;
+    }
+
+    /*
+     Solve one step event from the stepper ISR, unless the producer has been
+     preempted in the middle of solving one
+    */
+    FORCE_INLINE bool tryCalcNextAxisStepper() {
+        if (axis_stepper_producing) {
+            return false;
+        }
+        axis_stepper_producing = true;
+        bool ret = calcNextAxisStepper();
+        axis_stepper_producing = false;
+        return ret;
+    }
+
     void abort() {
         req_abort = true;
         moveQueue.reset();
@@ -311,6 +379,21 @@ class AxisManager {
 
     bool generateAllAxisFuncParams(uint8_t block_index, block_t* block);
 
+    // False while an axis lacks the room to take the block
+    bool hasFuncParamsRoom(const block_t* block) {
+        for (int i = 0; i < AXIS_SIZE; ++i) {
+            if (axis[i].func_manager.getFreeSize() < getFuncParamsRoom(i, block)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int getFuncParamsRoom(int i, const block_t* block) {
+        const int moves = moveQueue.getBlockMoveSize(block);
+        return i < 2 ? FUNC_PARAMS_MOVE_ROOM_XY * moves : FUNC_PARAMS_MOVE_ROOM * moves + 1;
+    }
+
     float getRemainingConsumeTime();
 
     bool tryAddMoveStart() {
@@ -356,13 +439,13 @@ class AxisManager {
 
         AxisStepper* current_stepper = &axis_steppers[axis_steppper_tail];
 
-        if (current_stepper->delta_time > 0.005) {
+        if (current_stepper->ticks > AXIS_STEPPER_ZERO_TICKS) {
             return false;
         }
 
         axis_stepper->axis = current_stepper->axis;
         axis_stepper->dir = current_stepper->dir;
-        axis_stepper->delta_time = current_stepper->delta_time;
+        axis_stepper->ticks = current_stepper->ticks;
         axis_stepper->print_time = current_stepper->print_time;
 
         if (axis_stepper->axis != T0_T1_AXIS_INDEX) {
@@ -374,14 +457,21 @@ class AxisManager {
     };
 
     FORCE_INLINE bool getNextAxisStepper(AxisStepper* axis_stepper) {
-        if (getAxisStepperSize() == 0 && !calcNextAxisStepper()) {
-            return false;
+        uint8_t size = getAxisStepperSize();
+        if (size < axis_stepper_min_size) {
+            axis_stepper_min_size = size;
+        }
+        if (size == 0) {
+            if (!tryCalcNextAxisStepper()) {
+                return false;
+            }
+            counts[SHAPER_DBG_STEP_QUEUE_UNDERRUN]++;
         }
 
         AxisStepper* current_stepper = &axis_steppers[axis_steppper_tail];
         axis_stepper->axis = current_stepper->axis;
         axis_stepper->dir = current_stepper->dir;
-        axis_stepper->delta_time = current_stepper->delta_time;
+        axis_stepper->ticks = current_stepper->ticks;
         axis_stepper->print_time = current_stepper->print_time;
 
         if (axis_stepper->axis != T0_T1_AXIS_INDEX) {
@@ -68,8 +68,11 @@
 #include "temperature.h"
 #include "../lcd/marlinui.h"
 #include "../gcode/parser.h"
+#include "../gcode/queue.h"
 #include "AxisManager.h"
+#include "shaper/ShapedWindow.h"
 #include "../../../../snapmaker/debug/debug.h"
+#include "../../../../snapmaker/debug/profiler.h"
 #include "../../../../snapmaker/module/print_control.h"
 #include "../../../../snapmaker/module/system.h"
 
@@ -225,6 +228,10 @@ uint32_t Planner::acceleration_long_cutoff;
 xyze_float_t Planner::previous_speed;
 float Planner::previous_nominal_speed_sqr;
 
+#if ENABLED(ARC_NATIVE_MOVES)
+  block_arc_t Planner::next_arc;
+#endif
+
 #if ENABLED(DISABLE_INACTIVE_EXTRUDER)
   last_move_t Planner::g_uc_extruder_last_move[E_STEPPERS] = { 0 };
 #endif
@@ -1299,6 +1306,25 @@ void Planner::recalculate() {
   recalculate_trapezoids();
 }
 
+// No G-code left to turn into blocks, waiting will not bring the next one
+static bool shaped_input_exhausted() {
+  if (shapedWindow.inputIdle(millis())) {
+    return true;
+  }
+  return !queue.has_commands_queued() && (!is_hmi_printing || print_control.buffer_is_empty());
+}
+
+void Planner::shaped_stats_reset() {
+  shapedWindow.resetStats();
+}
+
+void Planner::shaped_stats_report() {
+  const shaped_stats_t &stats = shapedWindow.stats;
+  LOG_I("shaper hand-off: %u blocks, %u deferred, %u starved, %u padded, %u underruns, min %.1f ms left, block gap %.2f ms\n",
+        stats.handovers, stats.deferred, stats.starved, stats.padding, stats.underruns, stats.min_remaining,
+        shapedWindow.arrival_gap);
+}
+
 void Planner::shaped_loop() {
     // if (xTaskGetCurrentTaskHandle() != thandle_marlin)
     //   return;
@@ -1317,12 +1343,13 @@ void Planner::shaped_loop() {
     }
 
     float remaining_consume_time = axisManager.getRemainingConsumeTime();
+    const float waiting_time = shapedWindow.waitingTime(nr_moves);
 
-    if (remaining_consume_time > SHAPED_WAITING_MIN_TIME) {
+    if (remaining_consume_time > waiting_time) {
       return;
     }
 
-    if (nr_moves < 6 && delay_before_delivering > SHAPED_WAITING_MIN_TIME) {
+    if (nr_moves < 6 && delay_before_delivering > waiting_time) {
         return;
     }
 
@@ -1336,6 +1363,8 @@ void Planner::shaped_loop() {
       return;
     }
 
+    PROFILE_SCOPE(PROFILE_SHAPED_LOOP);
+
     float planed_time = 0;
     while (index != planned_index) {
         block = &block_buffer[index];
@@ -1344,12 +1373,15 @@ void Planner::shaped_loop() {
               break;
             }
 
-            if (moveQueue.getFreeMoveSize() < 3) {
+            if (!moveQueue.hasBlockRoom(block)) {
               axisManager.counts[SHAPER_DBG_NOT_ENOUGH_MOVES_RESC]++;
               break;
             }
 
-            moveQueue.calculateMoves(block);
+            {
+              PROFILE_SCOPE(PROFILE_CALC_MOVES);
+              moveQueue.calculateMoves(block);
+            }
             block->shaper_data.is_create_move = true;
         }
         if (!block->shaper_data.is_zero_speed)
@@ -1360,9 +1392,13 @@ void Planner::shaped_loop() {
         index = next_block_index(index);
     }
 
-    float need_shaped_time = SHAPED_WAITING_MIN_TIME + axisManager.shaped_right_delta;
+    float need_shaped_time = waiting_time + axisManager.shaped_right_delta;
 
-    if (index != head_index && planed_time + remaining_consume_time < need_shaped_time) {
+    // Handing over the blocks still being planned ends the motion with a stop
+    const bool force_handover = shapedWindow.forceHandover(index != head_index, planed_time + remaining_consume_time,
+                                                           need_shaped_time, axisManager.shaped_right_delta,
+                                                           shaped_input_exhausted());
+    if (force_handover) {
         while (index != head_index) {
             block = &block_buffer[index];
             if (!block->shaper_data.is_create_move) {
@@ -1370,12 +1406,15 @@ void Planner::shaped_loop() {
                   break;
                 }
 
-                if (moveQueue.getFreeMoveSize() < 3) {
+                if (!moveQueue.hasBlockRoom(block)) {
                   axisManager.counts[SHAPER_DBG_NOT_ENOUGH_MOVES_RESC]++;
                   break;
                 }
 
-                moveQueue.calculateMoves(block);
+                {
+                  PROFILE_SCOPE(PROFILE_CALC_MOVES);
+                  moveQueue.calculateMoves(block);
+                }
                 block->shaper_data.is_create_move = true;
             }
 
@@ -1396,6 +1435,7 @@ void Planner::shaped_loop() {
               axisManager.counts[SHAPER_DBG_EMPTY_MOVES_COUNT]++;
             }
             axisManager.addEmptyMove();
+            shapedWindow.pad();
             block = &block_buffer[prev_block_index(index)];
             block->shaper_data.last_print_time += axisManager.shaped_left_delta;
         }
@@ -1406,11 +1446,19 @@ void Planner::shaped_loop() {
     shaped_index = block_buffer_shaped;
     planned_index = block_buffer_planned;
 
+    if (shaped_index != planned_index) {
+      shapedWindow.handover(remaining_consume_time);
+    }
+
     while (shaped_index != planned_index) {
         block = &block_buffer[shaped_index];
 
         if (!block->shaper_data.is_zero_speed)
         {
+          // A deep buffer can plan more blocks than the function lists hold, the rest waits
+          if (!axisManager.hasFuncParamsRoom(block)) {
+            break;
+          }
           if (!axisManager.generateAllAxisFuncParams(shaped_index, block)) {
             break;
           }
@@ -1418,6 +1466,7 @@ void Planner::shaped_loop() {
 
         // uint8_t move_index = moveQueue.calculateMoveStart(block->shaper_data.move_end, axisManager.shaped_delta);
         shaped_index = next_block_index(shaped_index);
+        shapedWindow.stats.handovers++;
     }
 
     // LOG_I("remainingConsumeTime: %lf, %d, %d, %d, %d\n", axisManager.getRemainingConsumeTime(), tail_index, shaped_index, planned_index, head_index);
@@ -1999,6 +2048,8 @@ bool Planner::_buffer_steps(const xyze_long_t &target
     delay_before_delivering = BLOCK_DELAY_FOR_1ST_MOVE;
   }
 
+  shapedWindow.arrival(millis());
+
   // Move buffer head
   block_buffer_head = next_buffer_head;
 
@@ -2217,6 +2268,8 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
 
   TERN_(LCD_SHOW_E_TOTAL, e_move_accumulator += steps_dist_mm.e);
 
+  TERN_(ARC_NATIVE_MOVES, block->arc = next_arc);
+
   if (true LINEAR_AXIS_GANG(
       && block->steps.a < MIN_STEPS_PER_SEGMENT,
       && block->steps.b < MIN_STEPS_PER_SEGMENT,
@@ -2227,6 +2280,7 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
     )
   ) {
     block->millimeters = TERN0(HAS_EXTRUDERS, ABS(steps_dist_mm.e));
+    TERN_(ARC_NATIVE_MOVES, block->arc.theta = 0);
   }
   else {
     if (millimeters)
@@ -2461,6 +2515,10 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
   // Linear axes first with less logic
   LOOP_LINEAR_AXES(i) {
     current_speed[i] = steps_dist_mm[i] * inverse_secs;
+    #if ENABLED(ARC_NATIVE_MOVES)
+      // The tangent of an arc turns, X and Y may move at the whole speed
+      if (block->arc.theta && (i == X_AXIS || i == Y_AXIS)) current_speed[i] = block->nominal_speed;
+    #endif
     const feedRate_t cs = ABS(current_speed[i]);
     feedRate_t max_fr;
                  // max_fr = settings.max_feedrate_mm_s[i];
@@ -2669,6 +2727,20 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
     NOMORE(block->acceleration, print_control.pnm_param.max_acc);
   }
 
+  #if ENABLED(ARC_NATIVE_MOVES)
+    if (block->arc.theta) {
+      // Any direction of the arc within the X and Y limits, the centripetal acceleration too
+      NOMORE(block->acceleration, _MIN(settings.max_acceleration_mm_per_s2[X_AXIS], settings.max_acceleration_mm_per_s2[Y_AXIS]));
+      const float centripetal_sqr = block->acceleration * block->arc.rvec.magnitude();
+      if (block->nominal_speed_sqr > centripetal_sqr) {
+        const float factor = SQRT(centripetal_sqr / block->nominal_speed_sqr);
+        block->nominal_speed *= factor;
+        block->nominal_speed_sqr = centripetal_sqr;
+        block->nominal_rate *= factor;
+      }
+    }
+  #endif
+
   if (settings.acceleration_to_deceleration_ratio > 20) {
     block->acceleration_to_deceleration = block->acceleration * settings.acceleration_to_deceleration_ratio * 0.01;
   } else {
@@ -2738,6 +2810,14 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
       #endif
     ;
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+      // An arc starts along its tangent, of the length of the arc in XY
+      if (block->arc.theta) {
+        unit_vec.x = -block->arc.rvec.y * block->arc.theta;
+        unit_vec.y = block->arc.rvec.x * block->arc.theta;
+      }
+    #endif
+
     /**
      * On CoreXY the length of the vector [A,B] is SQRT(2) times the length of the head movement vector [X,Y].
      * So taking Z and E into account, we cannot scale to a unit vector with "inverse_millimeters".
@@ -2877,6 +2957,15 @@ bool Planner::_populate_block(block_t * const block, bool split_move,
 
     prev_unit_vec = unit_vec;
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+      // The next block joins the tangent at the end of the arc
+      if (block->arc.theta) {
+        const float cos_T = cos(block->arc.theta), sin_T = sin(block->arc.theta);
+        prev_unit_vec.x = unit_vec.x * cos_T - unit_vec.y * sin_T;
+        prev_unit_vec.y = unit_vec.x * sin_T + unit_vec.y * cos_T;
+      }
+    #endif
+
   #endif
 
   #ifdef USE_CACHED_SQRT
@@ -3236,6 +3325,20 @@ bool Planner::buffer_line(const xyze_pos_t &cart, const_feedRate_t fr_mm_s, cons
   #endif
 } // buffer_line()
 
+#if ENABLED(ARC_NATIVE_MOVES)
+
+  bool Planner::buffer_arc(const xyze_pos_t &cart, const xy_float_t &rvec, const_float_t theta, const uint8_t chords,
+                           const_feedRate_t fr_mm_s, const uint8_t extruder, const_float_t millimeters) {
+    next_arc.theta = theta;
+    next_arc.rvec = rvec;
+    next_arc.chords = chords;
+    const bool queued = buffer_line(cart, fr_mm_s, extruder, millimeters);
+    next_arc.theta = 0;
+    return queued;
+  }
+
+#endif
+
 #if ENABLED(DIRECT_STEPPING)
 
   void Planner::buffer_page(const page_idx_t page_idx, const uint8_t extruder, const uint16_t num_steps) {
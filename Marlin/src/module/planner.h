@@ -180,6 +180,15 @@ typedef struct shaper_data_t {
 } shaper_data_t;
 
 
+#if ENABLED(ARC_NATIVE_MOVES)
+  // XY arc of a block, the moves of the block follow its chords
+  typedef struct block_arc_t {
+    float theta;                            // Angle of the arc in radians, CCW positive, 0 for a line
+    xy_float_t rvec;                        // Arc center to the start of the block in mm
+    uint8_t chords;
+  } block_arc_t;
+#endif
+
 /**
  * struct block_t
  *
@@ -206,6 +215,10 @@ typedef struct block_t {
   xyze_float_t axis_r;
   shaper_data_t shaper_data;
 
+  #if ENABLED(ARC_NATIVE_MOVES)
+    block_arc_t arc;
+  #endif
+
   union {
     abce_ulong_t steps;                     // Step count along each axis
     abce_long_t position;                   // New position to force when this sync block is executed
@@ -477,6 +490,9 @@ class Planner {
 
     static void shaped_loop();
 
+    static void shaped_stats_reset();
+    static void shaped_stats_report();
+
   private:
 
     /**
@@ -489,6 +505,11 @@ class Planner {
      */
     static float previous_nominal_speed_sqr;
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+      // Arc of the block buffer_arc() is adding, theta 0 otherwise
+      static block_arc_t next_arc;
+    #endif
+
     /**
      * Limit where 64bit math is necessary for acceleration calculation
      */
@@ -832,6 +853,15 @@ class Planner {
       OPTARG(SCARA_FEEDRATE_SCALING, const_float_t inv_duration=0.0)
     );
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+      /**
+       * Add an XY arc to the buffer as one block, millimeters is its length.
+       * The arc starts at the current position, rvec is from its center there.
+       */
+      static bool buffer_arc(const xyze_pos_t &cart, const xy_float_t &rvec, const_float_t theta, const uint8_t chords,
+                             const_feedRate_t fr_mm_s, const uint8_t extruder, const_float_t millimeters);
+    #endif
+
     #if ENABLED(DIRECT_STEPPING)
       static void buffer_page(const page_idx_t page_idx, const uint8_t extruder, const uint16_t num_steps);
     #endif
@@ -36,7 +36,7 @@
  */
 
 // Change EEPROM version if the structure changes
-#define EEPROM_VERSION "V86"
+#define EEPROM_VERSION "V87"
 #define EEPROM_OFFSET 100
 
 // Check the integrity of data offsets.
@@ -502,13 +502,15 @@ typedef struct SettingsDataStruct {
 
   float heat_bed_center_offset[2];
 
-  is_setting_t input_shaper[2];
+  is_setting_t input_shaper[2];                       // M593 S0 X Y
 
   uint8_t z_home_sg;
 
+  is_setting_t input_shaper_profiles[SHAPER_PROFILE_COUNT - 1][2];  // M593 S1-S3 X Y
+
 } SettingsData;
 
-//static_assert(sizeof(SettingsData) <= MARLIN_EEPROM_SIZE, "EEPROM too small to contain SettingsData!");
+static_assert(EEPROM_OFFSET + sizeof(SettingsData) <= MARLIN_EEPROM_SIZE - 1, "EEPROM too small to contain SettingsData!");
 
 MarlinSettings settings;
 
@@ -1380,17 +1382,15 @@ void MarlinSettings::postprocess() {
       is_setting_t input_shaper[2];
       _FIELD_TEST(input_shaper);
 
+      // S0 where the single X/Y shaper was, S1 - S3 at the end
       int type; float freq, damp;
-      axisManager.input_shaper_get(X_AXIS, type, freq, damp);
-      input_shaper[X_AXIS].axis = X_AXIS;
-      input_shaper[X_AXIS].type = type;
-      input_shaper[X_AXIS].freq = freq;
-      input_shaper[X_AXIS].dampe = damp;
-      axisManager.input_shaper_get(Y_AXIS, type, freq, damp);
-      input_shaper[Y_AXIS].axis = Y_AXIS;
-      input_shaper[Y_AXIS].type = type;
-      input_shaper[Y_AXIS].freq = freq;
-      input_shaper[Y_AXIS].dampe = damp;
+      LOOP_L_N(i, 2) {
+        axisManager.input_shaper_profile_get(0, i, type, freq, damp);
+        input_shaper[i].axis = i;
+        input_shaper[i].type = type;
+        input_shaper[i].freq = freq;
+        input_shaper[i].dampe = damp;
+      }
 
       EEPROM_WRITE(input_shaper);
     }
@@ -1459,6 +1459,25 @@ void MarlinSettings::postprocess() {
     {
       EEPROM_WRITE(print_control.z_home_sg);
     }
+
+    //
+    // Input shaper profiles S1 - S3
+    //
+    {
+      is_setting_t input_shaper_profiles[SHAPER_PROFILE_COUNT - 1][2];
+      _FIELD_TEST(input_shaper_profiles);
+
+      int type; float freq, damp;
+      LOOP_L_N(p, SHAPER_PROFILE_COUNT - 1) LOOP_L_N(i, 2) {
+        axisManager.input_shaper_profile_get(p + 1, i, type, freq, damp);
+        input_shaper_profiles[p][i].axis = i;
+        input_shaper_profiles[p][i].type = type;
+        input_shaper_profiles[p][i].freq = freq;
+        input_shaper_profiles[p][i].dampe = damp;
+      }
+
+      EEPROM_WRITE(input_shaper_profiles);
+    }
   }
 
   /**
@@ -1558,7 +1577,7 @@ void MarlinSettings::postprocess() {
 
     if (working_crc == stored_crc) {
       DEBUG_ECHO_MSG("Find the existing data");
-      _existing_data_len = i;
+      _existing_data_len = i + 1;     // Bytes read, the last one included
       return _existing_data_len;
     }
 
@@ -1574,6 +1593,8 @@ void MarlinSettings::postprocess() {
     reset();
 
     // Reset value update to eeprom buffer
+    eeprom_index = EEPROM_OFFSET;
+    working_crc = 0;
     _update_to_eeprom_buffer();
 
     // Use the existing valid data cover the reset value
@@ -1581,9 +1602,19 @@ void MarlinSettings::postprocess() {
     // and the new extend setting data have the reset value
     persistentStore.load(_existing_data_len + EEPROM_OFFSET + SETTING_DATA_HEADER_SIZE);
 
-    // Calculate the crc and write to flash
-    if (!EEPROM_START(EEPROM_OFFSET))
-      return false;
+    // Settings from before the input shaper profiles: S1 - S3 start as S0
+    if (_existing_data_len <= (int)(offsetof(SettingsData, input_shaper_profiles) - SETTING_DATA_HEADER_SIZE)) {
+      is_setting_t input_shaper[2];
+      eeprom_index = offsetof(SettingsData, input_shaper) + EEPROM_OFFSET;
+      EEPROM_READ_ALWAYS(input_shaper);
+      eeprom_index = offsetof(SettingsData, input_shaper_profiles) + EEPROM_OFFSET;
+      LOOP_L_N(p, SHAPER_PROFILE_COUNT - 1) EEPROM_WRITE(input_shaper);
+    }
+
+    // Calculate the crc and write to flash. EEPROM_START() would load the
+    // buffer from flash again and drop the new data.
+    eeprom_index = EEPROM_OFFSET;
+    working_crc = 0;
 
     char dump1[1];
     char dump2[2];
@@ -2420,13 +2451,11 @@ void MarlinSettings::postprocess() {
       _FIELD_TEST(input_shaper);
       EEPROM_READ(input_shaper);
 
-      AxisInputShaper::axis_input_shaper_x.type = (InputShaperType)input_shaper[0].type;
-      AxisInputShaper::axis_input_shaper_x.frequency = input_shaper[0].freq;
-      AxisInputShaper::axis_input_shaper_x.zeta = input_shaper[0].dampe;
-
-      AxisInputShaper::axis_input_shaper_y.type = (InputShaperType)input_shaper[1].type;
-      AxisInputShaper::axis_input_shaper_y.frequency = input_shaper[1].freq;
-      AxisInputShaper::axis_input_shaper_y.zeta = input_shaper[1].dampe;
+      LOOP_L_N(i, 2) {
+        axisManager.shaper_profiles[0][i].type = input_shaper[i].type;
+        axisManager.shaper_profiles[0][i].freq = input_shaper[i].freq;
+        axisManager.shaper_profiles[0][i].zeta = input_shaper[i].dampe;
+      }
 
     }
 
@@ -2497,6 +2526,22 @@ void MarlinSettings::postprocess() {
     {
       EEPROM_READ(print_control.z_home_sg);
     }
+
+    //
+    // Input shaper profiles S1 - S3
+    //
+    {
+      is_setting_t input_shaper_profiles[SHAPER_PROFILE_COUNT - 1][2];
+      _FIELD_TEST(input_shaper_profiles);
+      EEPROM_READ(input_shaper_profiles);
+
+      LOOP_L_N(p, SHAPER_PROFILE_COUNT - 1) LOOP_L_N(i, 2) {
+        axisManager.shaper_profiles[p + 1][i].type = input_shaper_profiles[p][i].type;
+        axisManager.shaper_profiles[p + 1][i].freq = input_shaper_profiles[p][i].freq;
+        axisManager.shaper_profiles[p + 1][i].zeta = input_shaper_profiles[p][i].dampe;
+      }
+      axisManager.input_shaper_load();
+    }
   }
 
   /**
@@ -4134,12 +4179,14 @@ void MarlinSettings::reset() {
 
     {
       int type; float freq, damp;
-      axisManager.input_shaper_get(X_AXIS, type, freq, damp);
-      SERIAL_ECHOPAIR_P("M593 X P", type, " F", freq, " D", damp);
-      SERIAL_EOL();
-      axisManager.input_shaper_get(Y_AXIS, type, freq, damp);
-      SERIAL_ECHOPAIR_P("M593 Y P", type, " F", freq, " D", damp);
-      SERIAL_EOL();
+      LOOP_L_N(p, SHAPER_PROFILE_COUNT) {
+        axisManager.input_shaper_profile_get(p, X_AXIS, type, freq, damp);
+        SERIAL_ECHOPAIR_P("M593 S", p, " X P", type, " F", freq, " D", damp);
+        SERIAL_EOL();
+        axisManager.input_shaper_profile_get(p, Y_AXIS, type, freq, damp);
+        SERIAL_ECHOPAIR_P("M593 S", p, " Y P", type, " F", freq, " D", damp);
+        SERIAL_EOL();
+      }
     }
 
     #if ENABLED(BACKLASH_GCODE)
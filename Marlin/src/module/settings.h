@@ -132,7 +132,7 @@ class MarlinSettings {
         return true;
       }
 
-      static void EEPROM_FINISH(void) { persistentStore.access_finish(); }
+      static void EEPROM_FINISH(void) { if (!persistentStore.access_finish()) eeprom_error = true; }
 
       template<typename T>
       static void EEPROM_SKIP(const T &VAR) { eeprom_index += sizeof(VAR); }
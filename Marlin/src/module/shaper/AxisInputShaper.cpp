@@ -286,17 +286,17 @@ FORCE_INLINE void AxisInputShaper::addFuncParamsToManager(FuncManager *func_mana
 
 float AxisInputShaper::calcPosition(int move_index, time_double_t time, int move_shaped_start, int move_shaped_end) {
     if (moveQueue.getMoveSize() == 0) {
-        LOG_I("moveQueue.getMoveSize() zero\n");
+        LOG_FAST_I("moveQueue.getMoveSize() zero\n");
         return 0;
     }
 
     if (!moveQueue.isBetween(move_index)) {
-        LOG_I("isb %d, %d, %d\n",move_index, moveQueue.move_tail, moveQueue.move_head);
+        LOG_FAST_I("isb %d, %d, %d\n", move_index, moveQueue.move_tail, moveQueue.move_head);
         return 0;
     }
 
     if (move_index == moveQueue.move_head) {
-        LOG_I("move_index == head\n");
+        LOG_FAST_I("move_index == head\n");
     }
 
     float res = 0;
@@ -315,7 +315,7 @@ FORCE_INLINE void AxisInputShaper::moveShaperWindowByIndex(FuncManager *func_man
 
     Move *move = &moveQueue.moves[move_shaped_start];
 
-    shaper_window.time = move->end_t - right_delta;
+    shaper_window.time = move->end_t() - right_delta;
 
     for (int i = n - 1; i >= 0; i--) {
         ShaperWindowParams &w_p = shaper_window.params[i];
@@ -378,7 +378,7 @@ bool AxisInputShaper::moveShaperWindowToNext(FuncManager *func_manager, uint8_t
     for (int i = 0; i < shaper_window.n; i++) {
         ShaperWindowParams &p = shaper_window.params[i];
 
-        float min_p_next_time = moveQueue.moves[p.move_index].end_t - p.time;
+        float min_p_next_time = moveQueue.moves[p.move_index].end_t() - p.time;
 
         if (min_p_next_time < min_next_time) {
             min_next_time = min_p_next_time;
@@ -388,7 +388,7 @@ bool AxisInputShaper::moveShaperWindowToNext(FuncManager *func_manager, uint8_t
 
     // Cumulative error of processing value
     zero_p = &shaper_window.params[shaper_window.zero_n];
-    zero_p->time = moveQueue.moves[zero_p->move_index].end_t;
+    zero_p->time = moveQueue.moves[zero_p->move_index].end_t();
 
     for (int i = 0; i < shaper_window.n; i++) {
         if (i == shaper_window.zero_n) {
@@ -43,59 +43,37 @@ float FuncManager::getPos(time_double_t time) {
     return getPosByFuncParams(time, func_start);
 }
 
+// Position at a time the kept segments still cover, from the one before the
+// segment in use to the last added
+bool FuncManager::getKeptPos(time_double_t time, float &pos) {
+    if (func_params_tail == func_params_head || time < tail_left_time || time > last_time) {
+        return false;
+    }
+    pos = getPos(time);
+    return true;
+}
+
 float FuncManager::getPosByFuncParams(time_double_t time, int func_params_use) {
     FuncParams& f_p = funcParams[func_params_use];
-    time_double_t left_time = func_params_use == func_params_tail ? 0 : funcParams[prevFuncParamsIndex(func_params_use)].right_time;
+    time_double_t left_time = func_params_use == func_params_tail ? tail_left_time : funcParams[prevFuncParamsIndex(func_params_use)].right_time;
     float t = time - left_time;
     return f_p.a * t * t + f_p.b * t + f_p.c;
 }
 
-FORCE_INLINE float FuncManager::getTimeByFuncParams(FuncParams* f_p, int8_t type, float pos, int func_params_use) {
-    float a = f_p->a;
-    float b = f_p->b;
-    float c = f_p->c;
-    c = c - pos;
-
-    if (IS_ZERO(a)) {
-        return -c / b;
-    }
-
-    float d2 = b * b - 4 * a * c;
-    if (d2 < 0) {
-        d2 = 0.0f;
-    }
-
-    float d = SQRT(d2);
-
-    if (type > 0) {
-        return (-b + d) / (2 * a);
-    } else {
-        return (-b - d) / (2 * a);
-    }
+FORCE_INLINE float FuncManager::getTimeByFuncParams(FuncParams* f_p, int8_t type, float pos, float seed) {
+    #ifdef STEP_TIME_KERNEL_NEWTON
+        return step_time_newton(f_p->a, f_p->b, f_p->c, type, pos, seed);
+    #else
+        return step_time_sqrt(f_p->a, f_p->b, f_p->c, type, pos);
+    #endif
 }
 
-FORCE_INLINE double FuncManager::getTimeByFuncParamsExtend(FuncParamsExtend* f_p, int8_t type, double pos, int func_params_use) {
-    double a = f_p->a;
-    double b = f_p->b;
-    double c = f_p->c;
-    c = c - pos;
-
-    if (IS_ZERO(a)) {
-        return -c / b;
-    }
-
-    double d2 = b * b - 4 * a * c;
-    if (d2 < 0) {
-        d2 = 0.0f;
-    }
-
-    double d = SQRT(d2);
-
-    if (type > 0) {
-        return (-b + d) / (2 * a);
-    } else {
-        return (-b - d) / (2 * a);
-    }
+FORCE_INLINE double FuncManager::getTimeByFuncParamsExtend(FuncParamsExtend* f_p, int8_t type, double pos, double seed) {
+    #ifdef STEP_TIME_KERNEL_NEWTON
+        return step_time_newton(f_p->a, f_p->b, f_p->c, type, pos, seed);
+    #else
+        return step_time_sqrt(f_p->a, f_p->b, f_p->c, type, pos);
+    #endif
 }
 
 void FuncManager::addFuncParams(float a, float b, float c, int type, time_double_t right_time, float right_pos) {
@@ -130,6 +108,10 @@ void FuncManager::addFuncParams(float a, float b, float c, int type, time_double
     }
 
 
+    #ifdef STEP_TIME_KERNEL_RECORD
+        LOG_I("fp: %d %d %d %.9g %.9g %.9g %.9g %.9g\n", axis, type, right_time.i, right_time.d, a, b, c, right_pos);
+    #endif
+
     FuncParams &f_p = funcParams[func_params_head];
     funcParamsTypes[func_params_head] = type;
 
@@ -158,7 +140,7 @@ void FuncManager::addFuncParams(float a, float b, float c, int type, time_double
     if (!last_is_zero && func_params_head == func_params_use) {
       extern uint32_t statistics_funcgen_runout_cnt;
       statistics_funcgen_runout_cnt++;
-      LOG_E("statistics_funcgen_runout_cnt on axi %d\r\n", axis);
+      LOG_FAST_E("statistics_funcgen_runout_cnt on axi %d\r\n", axis);
     }
 }
 
@@ -200,6 +182,10 @@ void FuncManager::addFuncParamsExtend(double a, double b, double c, int type, ti
     }
 
 
+    #ifdef STEP_TIME_KERNEL_RECORD
+        LOG_I("fp: %d %d %d %.9g %.17g %.17g %.17g %.17g\n", axis, type, right_time.i, right_time.d, a, b, c, right_pos);
+    #endif
+
     FuncParamsExtend &f_p = funcParamsExtend[func_params_head];
     funcParamsTypes[func_params_head] = type;
 
@@ -243,6 +229,7 @@ bool FuncManager::getNextPosTime(int delta_step, int8_t *dir, float& mm_to_step,
     FuncParams *func_params = &funcParams[func_params_use];
     int8_t type = funcParamsTypes[func_params_use];
 
+    int seed_func_params = func_params_use;
     int next_step = print_step;
     float next_pos = print_pos;
     while (func_params_use != func_params_head) {
@@ -264,6 +251,7 @@ bool FuncManager::getNextPosTime(int delta_step, int8_t *dir, float& mm_to_step,
         }
         func_params_use = nextFuncParamsIndex(func_params_use);
 
+        tail_left_time = left_time;
         left_time = func_params->right_time;
 
         func_params = &funcParams[func_params_use];
@@ -278,7 +266,9 @@ bool FuncManager::getNextPosTime(int delta_step, int8_t *dir, float& mm_to_step,
         return false;
     }
 
-    time_double_t next_time = left_time + getTimeByFuncParams(func_params, type, next_pos, func_params_use);
+    // The previous step seeds the solver while it stays on the same segment
+    float seed = seed_func_params == func_params_use ? (float)(print_time - left_time) : -1.0f;
+    time_double_t next_time = left_time + getTimeByFuncParams(func_params, type, next_pos, seed);
 
     print_time = next_time;
     print_pos = next_pos;
@@ -325,6 +315,7 @@ bool FuncManager::getNextPosTimeEextend(int delta_step, int8_t *dir, float& mm_t
     int8_t type = funcParamsTypes[func_params_use];
 
     int next_step = print_step;
+    int seed_func_params = func_params_use;
     double next_pos = print_pos_e;
     while (func_params_use != func_params_head) {
         if (type == 0) {
@@ -359,7 +350,8 @@ bool FuncManager::getNextPosTimeEextend(int delta_step, int8_t *dir, float& mm_t
         return false;
     }
 
-    time_double_t next_time = left_time + getTimeByFuncParamsExtend(func_params, type, next_pos, func_params_use);
+    double seed = seed_func_params == func_params_use ? (double)(print_time - left_time) : -1.0;
+    time_double_t next_time = left_time + getTimeByFuncParamsExtend(func_params, type, next_pos, seed);
 
     print_time = next_time;
     print_pos_e = next_pos;
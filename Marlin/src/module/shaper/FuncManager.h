@@ -23,6 +23,7 @@
 
 #include <cstdint>
 #include "TimeDouble.h"
+#include "StepTimeKernel.h"
 #include "../../MarlinCore.h"
 #include "../../../../snapmaker/debug/debug.h"
 
@@ -31,6 +32,13 @@
 #define FUNC_PARAMS_SIZE 512
 #define FUNC_PARAMS_MOD(n, size) ((n + size) % size)
 
+// Solve step times with a Newton step seeded from the previous step instead of
+// a square root per step, see StepTimeKernel.h and snapmaker/host/step_time_bench.cpp
+// #define STEP_TIME_KERNEL_NEWTON
+
+// Log every added segment as "fp: ..." so a move stream can be replayed on the host
+// #define STEP_TIME_KERNEL_RECORD
+
 class FuncParams {
   public:
     float a, b, c, right_pos;
@@ -125,6 +133,8 @@ class FuncManager {
 
     // Consume
     time_double_t left_time = 0;
+    // Left time of the kept segment before the one in use
+    time_double_t tail_left_time = 0;
     time_double_t print_time = 0;
     float print_pos = 0;
     double print_pos_e = 0;
@@ -174,6 +184,7 @@ class FuncManager {
         last_is_zero = false;
 
         left_time = 0;
+        tail_left_time = 0;
         print_time = 0;
         print_pos = 0;
         print_pos_e = E_START_POS;
@@ -214,6 +225,7 @@ class FuncManager {
     void addFuncParamsExtend(double a, double b, double c, int type, time_double_t right_time, double right_pos);
 
     float getPos(time_double_t time);
+    bool getKeptPos(time_double_t time, float &pos);
 
     float getY(float x, float a, float b, float c) {
         return a * sq(x) + b * x + c;
@@ -228,6 +240,6 @@ class FuncManager {
 
     float getPosByFuncParams(time_double_t time, int func_params_use);
 
-    FORCE_INLINE float getTimeByFuncParams(FuncParams* f_p, int8_t type, float pos, int func_params_use);
-    FORCE_INLINE double getTimeByFuncParamsExtend(FuncParamsExtend* f_p, int8_t type, double pos, int func_params_use);
+    FORCE_INLINE float getTimeByFuncParams(FuncParams* f_p, int8_t type, float pos, float seed);
+    FORCE_INLINE double getTimeByFuncParamsExtend(FuncParamsExtend* f_p, int8_t type, double pos, double seed);
 };
\ No newline at end of file
@@ -28,6 +28,19 @@ MoveQueue moveQueue;
 static xyze_float_t ZERO_AXIS_R = {0};
 
 void MoveQueue::calculateMoves(block_t* block) {
+    #ifdef SHAPER_RECORD_BLOCKS
+        #if ENABLED(ARC_NATIVE_MOVES)
+          LOG_I("blk: %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %d %.9g %.9g %.9g %d\n", block->millimeters, block->initial_speed,
+                block->final_speed, block->cruise_speed, block->acceleration, block->axis_r.x, block->axis_r.y,
+                block->axis_r.z, block->axis_r.e, TERN0(LIN_ADVANCE, block->use_advance_lead),
+                block->arc.theta, block->arc.rvec.x, block->arc.rvec.y, block->arc.chords);
+        #else
+          LOG_I("blk: %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %d\n", block->millimeters, block->initial_speed,
+                block->final_speed, block->cruise_speed, block->acceleration, block->axis_r.x, block->axis_r.y,
+                block->axis_r.z, block->axis_r.e, TERN0(LIN_ADVANCE, block->use_advance_lead));
+        #endif
+    #endif
+
     float millimeters = block->millimeters;
 
     float entry_speed = block->initial_speed / 1000.0f;
@@ -101,26 +114,34 @@ void MoveQueue::calculateMoves(block_t* block) {
     axis_r.z = block->axis_r.z;
     axis_r.e = block->axis_r.e;
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+        startArc(block);
+    #endif
+
     if (plateau == 0) {
         if (accelDistance > 0) {
-            addMove(entry_speed, cruise_speed, acceleration, accelDistance, axis_r, accelClocks);
+            addAccelMoves(entry_speed, cruise_speed, acceleration, accelDistance, axis_r, accelClocks);
         }
         if (decelDistance > 0) {
-            addMove(cruise_speed, leave_speed, -deceleration, decelDistance, axis_r, decelClocks);
+            addAccelMoves(cruise_speed, leave_speed, -deceleration, decelDistance, axis_r, decelClocks);
         }
     } else {
         if (accelDistance > 0) {
-            addMove(entry_speed, cruise_speed, acceleration, accelDistance, axis_r, accelClocks);
+            addAccelMoves(entry_speed, cruise_speed, acceleration, accelDistance, axis_r, accelClocks);
         }
 
         // LOG_I("p: %lf, s: %lf, t: %lf\n", plateau, cruise_speed, plateau / cruise_speed);
-        addMove(cruise_speed, cruise_speed, 0, plateau, axis_r, plateauClocks);
+        addPathMove(cruise_speed, cruise_speed, 0, plateau, axis_r, plateauClocks);
 
         if (decelDistance > 0) {
-            addMove(cruise_speed, leave_speed, -deceleration, decelDistance, axis_r, decelClocks);
+            addAccelMoves(cruise_speed, leave_speed, -deceleration, decelDistance, axis_r, decelClocks);
         }
     }
 
+    #if ENABLED(ARC_NATIVE_MOVES)
+        arc_chords = 0;
+    #endif
+
     block->shaper_data.block_time = accelClocks + plateauClocks + decelClocks;
 
     block->shaper_data.move_end = prevMoveIndex(move_head);
@@ -128,28 +149,148 @@ void MoveQueue::calculateMoves(block_t* block) {
     block->cruise_speed = cruise_speed * 1000;
 
     Move& end_move = moves[block->shaper_data.move_end];
-    for (int i = 0; i < AXIS_SIZE; ++i) {
-        float p1 = end_move.end_pos[i];
-        end_move.end_pos[i] = LROUND(end_move.end_pos[i]);
-        if (ABS(p1 - end_move.end_pos[i]) > 1) {
-            LOG_I("error LROUND: %lf, %lf\n", p1, end_move.end_pos[i]);
+    for (int i = 0; i < MOVE_POS_AXES; ++i) {
+        float p1 = end_move.end_pos(i);
+        if (ABS(p1 - LROUND(p1)) > 1) {
+            LOG_I("error LROUND: %lf, %lf\n", p1, (float)LROUND(p1));
         }
-        // if (i == 0 || i == 1) {
-            // LOG_I("%d %lf %lf\n", i, tmp, end_move.end_pos[i]);
-        // }
     }
-
     {
-        double p1 = end_move.end_pos_e;
-        end_move.end_pos_e = (int64_t)(end_move.end_pos_e + 0.5);
-        if (ABS(p1 - end_move.end_pos_e) > 1) {
-            LOG_I("error E LROUND: %lf, %lf\n", p1, end_move.end_pos_e);
+        double p1 = end_move.end_pos_e();
+        if (ABS(p1 - (int64_t)(p1 + 0.5)) > 1) {
+            LOG_I("error E LROUND: %lf, %lf\n", p1, (double)(int64_t)(p1 + 0.5));
+        }
+    }
+    end_move.end_rounded = true;
+
+    block->shaper_data.last_print_time = moves[block->shaper_data.move_end].end_t();
+}
+
+void MoveQueue::setSCurve(uint8_t stages, float ramp) {
+    s_curve_stages = _MIN(stages, S_CURVE_STAGES_MAX);
+    s_curve_ramp = constrain(ramp, 0.05f, 0.5f);
+}
+
+/*
+ One acceleration phase of a block, a single move or the stages of an
+ S-curve. A ramp stage takes the acceleration at its middle, so the speed
+ at its end is that of the linear ramp. The phase is point symmetric, so
+ the stages add up to the distance of the trapezoid, the last one takes
+ what is left to end on the planned speed and position.
+*/
+void MoveQueue::addAccelMoves(float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t) {
+    const uint8_t n = s_curve_stages;
+    const float stage_t = t * s_curve_ramp / n;
+    if (!n || stage_t < S_CURVE_MIN_STAGE_TIME) {
+        addPathMove(start_v, end_v, accelerate, distance, axis_r, t);
+        return;
+    }
+
+    const float peak = accelerate / (1 - s_curve_ramp);
+    const float hold_t = t - 2 * n * stage_t;
+    float v = start_v;
+    float left = distance;
+    for (int i = 0; i < 2 * n + 1; ++i) {
+        float a, dt;
+        if (i < n) {
+            a = peak * (2 * i + 1) / (2 * n);
+            dt = stage_t;
+        } else if (i == n) {
+            if (hold_t < EPSILON) {
+                continue;
+            }
+            a = peak;
+            dt = hold_t;
+        } else {
+            a = peak * (2 * (2 * n - i) + 1) / (2 * n);
+            dt = stage_t;
+        }
+
+        float next_v = v + a * dt;
+        float d = 0.5f * (v + next_v) * dt;
+        if (i == 2 * n) {
+            next_v = end_v;
+            d = left;
         }
+        addPathMove(v, next_v, a, d, axis_r, dt);
+        v = next_v;
+        left -= d;
     }
+}
 
-    block->shaper_data.last_print_time = moves[block->shaper_data.move_end].end_t;
+/*
+ A move along the path of the block. On an arc block it is split where it
+ crosses from one chord to the next, each piece moves along its chord.
+*/
+void MoveQueue::addPathMove(float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t) {
+    #if ENABLED(ARC_NATIVE_MOVES)
+        if (arc_chords) {
+            float v = start_v;
+            while (true) {
+                if (arc_chord_left < EPSILON && arc_chord + 1 < arc_chords) {
+                    nextArcChord();
+                }
+                if (distance <= arc_chord_left + EPSILON || arc_chord + 1 == arc_chords) {
+                    break;
+                }
+                // Time to the end of the chord, without the cancellation of a small acceleration
+                const float d = arc_chord_left;
+                const float dt = 2 * d / (v + SQRT(_MAX(sq(v) + 2 * accelerate * d, 0.0f)));
+                const float next_v = v + accelerate * dt;
+                addMove(v, next_v, accelerate, d, arc_axis_r, dt);
+                v = next_v;
+                distance -= d;
+                t -= dt;
+                arc_chord_left = 0;
+            }
+            addMove(v, end_v, accelerate, distance, arc_axis_r, t);
+            arc_chord_left -= distance;
+            return;
+        }
+    #endif
+    addMove(start_v, end_v, accelerate, distance, axis_r, t);
 }
 
+#if ENABLED(ARC_NATIVE_MOVES)
+
+    void MoveQueue::startArc(const block_t* block) {
+        arc_chords = block->arc.theta ? _MAX(block->arc.chords, 1) : 0;
+        if (!arc_chords) {
+            return;
+        }
+        const float phi = block->arc.theta / arc_chords;
+        arc_cos = cos(phi);
+        arc_sin = sin(phi);
+        arc_r0 = block->arc.rvec;
+        arc_r = arc_r0;
+        arc_pos.reset();
+        arc_end.set(block->axis_r.x * block->millimeters, block->axis_r.y * block->millimeters);
+        arc_chord_len = block->millimeters / arc_chords;
+        arc_axis_r.z = block->axis_r.z;
+        arc_axis_r.e = block->axis_r.e;
+        arc_chord = -1;
+        nextArcChord();
+    }
+
+    // Direction of the next chord in steps per mm of the arc, the last one ends on the block target
+    void MoveQueue::nextArcChord() {
+        ++arc_chord;
+        arc_r.set(arc_r.x * arc_cos - arc_r.y * arc_sin, arc_r.x * arc_sin + arc_r.y * arc_cos);
+        xy_float_t end;
+        if (arc_chord + 1 == arc_chords) {
+            end = arc_end;
+        } else {
+            end.set((arc_r.x - arc_r0.x) * planner.settings.axis_steps_per_mm[X_AXIS],
+                    (arc_r.y - arc_r0.y) * planner.settings.axis_steps_per_mm[Y_AXIS]);
+        }
+        arc_axis_r.x = (end.x - arc_pos.x) / arc_chord_len;
+        arc_axis_r.y = (end.y - arc_pos.y) / arc_chord_len;
+        arc_pos = end;
+        arc_chord_left = arc_chord_len;
+    }
+
+#endif
+
 void MoveQueue::setMove(uint8_t move_index, float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t, uint8_t flag) {
     Move &move = moves[move_index];
 
@@ -160,14 +301,14 @@ void MoveQueue::setMove(uint8_t move_index, float start_v, float end_v, float ac
     move.distance = distance;
 
     move.t = t;
+    move.end_rounded = false;
     move.axis_r[0] = axis_r.x;
     move.axis_r[1] = axis_r.y;
     move.axis_r[2] = axis_r.z;
     move.axis_r[3] = axis_r.e;
 
     Move& last_move = moves[prevMoveIndex(move_index)];
-    move.start_t = is_first ? 0 : last_move.end_t;
-    move.end_t = move.start_t + move.t;
+    move.start_t = is_first ? 0 : last_move.end_t();
 
     // LOG_I("move_index: %d %lf %d %lf\n", move_index, t, flag, move.start_t.toFloat());
 
@@ -176,28 +317,10 @@ void MoveQueue::setMove(uint8_t move_index, float start_v, float end_v, float ac
         // LOG_I("error v: %lf, %lf\n", last_end_v,  move.start_v);
     }
 
-    for (int i = 0; i < AXIS_SIZE; ++i) {
-
-        if (E_AXIS == i) {
-          move.start_pos[i] = is_first ? E_START_POS : last_move.end_pos[i];
-        }
-        else {
-          move.start_pos[i] = is_first ? 0 : last_move.end_pos[i];
-        }
-
-        // move.start_pos[i] = is_first ? 0 : last_move.end_pos[i];
-        move.end_pos[i] = move.start_pos[i] + move.distance * move.axis_r[i];
-
-        if (IS_ZERO(move.end_pos[i]) && !IS_ZERO(move.start_pos[i])) {
-            // LOG_I("debug1: %lf, %lf\n", move.start_pos[i], move.end_pos[i]);
-        }
-
-        if (i <= 1 && (move.end_pos[i] < -48000 || move.end_pos[i] > 48000)) {
-            // LOG_I("debug: %d, %lf, %lf\n", i, move.distance, move.end_pos[i]);
-        }
+    for (int i = 0; i < MOVE_POS_AXES; ++i) {
+        move.start_pos[i] = is_first ? (E_AXIS == i ? E_START_POS : 0) : last_move.end_pos(i);
     }
-    move.start_pos_e = is_first ? E_START_POS : last_move.end_pos_e;
-    move.end_pos_e = move.start_pos_e + move.distance * move.axis_r[E_AXIS];
+    move.start_pos_e = is_first ? E_START_POS : last_move.end_pos_e();
 
     is_first = false;
 
@@ -286,58 +409,11 @@ void MoveQueue::updateMoveTail(uint8_t index) {
     move_tail = index;
 };
 
-void MoveQueue::initMoveTimeAndPos(uint8_t move_shaped_start, uint8_t move_start, uint8_t move_shaped_end) {
-    float start_t = 0;
-    // float start_pos[AXIS_SIZE] = {0};
-
-    uint8_t index = move_start;
-    Move *move;
-    while (index != nextMoveIndex(move_shaped_end)) {
-        move = &moves[index];
-
-        move->start_t = start_t;
-        start_t += move->t;
-        move->end_t = start_t;
-
-//        for (int i = 0; i < AXIS_SIZE; ++i) {
-//            move->start_pos[i] = start_pos[i];
-//            start_pos[i] += move->distance * move->axis_r[i];
-//            move->end_pos[i] = start_pos[i];
-//        }
-
-        index = nextMoveIndex(index);
-    }
-
-    start_t = 0;
-
-//    for (int i = 0; i < AXIS_SIZE; ++i) {
-//        start_pos[i] = 0;
-//    }
-
-    index = prevMoveIndex(move_start);
-
-    while (index != prevMoveIndex(move_shaped_start)) {
-        move = &moves[index];
-
-        move->end_t = start_t;
-        start_t -= move->t;
-        move->start_t = start_t;
-
-//        for (int i = 0; i < AXIS_SIZE; ++i) {
-//            move->end_pos[i] = start_pos[i];
-//            start_pos[i] -= move->distance * move->axis_r[i];
-//            move->start_pos[i] = start_pos[i];
-//        }
-
-        index = prevMoveIndex(index);
-    }
-}
-
 float MoveQueue::getAxisPositionAcrossMoves(int move_index, int axis, time_double_t time, int move_shaped_start, int move_shaped_end) {
     while (time < moves[move_index].start_t && move_index != move_shaped_start) {
         move_index = prevMoveIndex(move_index);
     }
-    while (time > moves[move_index].end_t && move_index != move_shaped_end) {
+    while (time > moves[move_index].end_t() && move_index != move_shaped_end) {
         move_index = nextMoveIndex(move_index);
     }
 
@@ -24,33 +24,76 @@
 #include "../planner.h"
 #include "TimeDouble.h"
 
-#define MOVE_SIZE 64
+#ifndef MOVE_SIZE
+  #define MOVE_SIZE 64
+#endif
 #define MOVE_MOD(n) ((n + MOVE_SIZE)%MOVE_SIZE)
 
+// Axes with a float position in a move, E has a double one for linear advance
+#define MOVE_POS_AXES TERN(LIN_ADVANCE, E_AXIS, AXIS_SIZE)
+
 #define EMPTY_TIME 100
 
+/*
+ Jerk-limited (S-curve) acceleration. Each acceleration phase of a block
+ becomes constant acceleration stages that ramp up to a raised peak, hold
+ it and ramp down again, in the time and over the distance of the
+ trapezoid phase. The velocity at the stage ends is that of a linear
+ acceleration ramp, so the junction speeds, block times and end positions
+ of the planner stay as they are. Every stage is still a quadratic, so
+ the shaper and the step time solving are unchanged.
+
+ stages is the stages per ramp, 0 for the trapezoid. ramp is the part of
+ the phase each ramp takes, the peak is 1 / (1 - ramp) of the planned
+ acceleration.
+*/
+#define S_CURVE_STAGES_DEFAULT  0
+#define S_CURVE_STAGES_MAX      4
+#define S_CURVE_RAMP_DEFAULT    0.33f
+// Phases with shorter stages, in ms, stay a single move
+#define S_CURVE_MIN_STAGE_TIME  0.5f
+
 #define MOVE_FLAG_NORMAL 0
 #define MOVE_FLAG_START 1
 #define MOVE_FLAG_END 2
 
+// Log every block handed to calculateMoves() as "blk: ..." so a print can be
+// replayed by snapmaker/host/motion_replay
+// #define SHAPER_RECORD_BLOCKS
+
+/*
+ A move keeps its start only, the end position and time are worked out
+ from it the same way setMove() did when it stored them. The last move of
+ a block ends on whole steps.
+*/
 class Move {
   public:
     uint8_t flag = 0;
+    bool end_rounded = false;
 
     float start_v;
     float end_v;
     float t;
     float accelerate;
     float distance;
-    float start_pos[AXIS_SIZE + 1];
-    float end_pos[AXIS_SIZE + 1];
-    float axis_r[AXIS_SIZE + 1];
+    float start_pos[MOVE_POS_AXES];
+    float axis_r[AXIS_SIZE];
 
     double start_pos_e;
-    double end_pos_e;
 
     time_double_t start_t = 0;
-    time_double_t end_t = 0;
+
+    FORCE_INLINE float end_pos(const int axis) const {
+      const float pos = start_pos[axis] + distance * axis_r[axis];
+      return end_rounded ? (float)LROUND(pos) : pos;
+    }
+
+    FORCE_INLINE double end_pos_e() const {
+      const double pos = start_pos_e + distance * axis_r[E_AXIS];
+      return end_rounded ? (double)(int64_t)(pos + 0.5) : pos;
+    }
+
+    FORCE_INLINE time_double_t end_t() const { return start_t + t; }
 };
 
 class MoveQueue {
@@ -60,6 +103,9 @@ class MoveQueue {
 
     bool is_first = true;
 
+    uint8_t s_curve_stages = S_CURVE_STAGES_DEFAULT;
+    float s_curve_ramp = S_CURVE_RAMP_DEFAULT;
+
     Move moves[MOVE_SIZE];
 
     Move& back() {
@@ -85,6 +131,18 @@ class MoveQueue {
         return MOVE_SIZE - 1 - getMoveSize();
     }
 
+    // Most moves calculateMoves() adds for a block, the chords of an arc split them
+    int getBlockMoveSize(const block_t* block) {
+        return 4 * s_curve_stages + 3 + TERN0(ARC_NATIVE_MOVES, (block->arc.theta ? block->arc.chords - 1 : 0));
+    }
+
+    // Room for the moves of the block and the empty move padding it
+    bool hasBlockRoom(const block_t* block) {
+        return getFreeMoveSize() > getBlockMoveSize(block);
+    }
+
+    void setSCurve(uint8_t stages, float ramp);
+
     void calculateMoves(block_t* block);
 
     uint8_t addEmptyMove(float time);
@@ -97,8 +155,6 @@ class MoveQueue {
 
     void updateMoveTail(uint8_t index);
 
-    void initMoveTimeAndPos(uint8_t move_shaped_start, uint8_t move_start, uint8_t move_shaped_end);
-
     float getAxisPositionAcrossMoves(int move_index,int axis, time_double_t time, int move_shaped_start, int move_shaped_end);
     float getAxisPosition(int move_index,int axis, time_double_t time);
 
@@ -106,6 +162,23 @@ class MoveQueue {
     uint8_t addMove(float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t, uint8_t flag = MOVE_FLAG_NORMAL);
 
   private:
+    void addAccelMoves(float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t);
+    void addPathMove(float start_v, float end_v, float accelerate, float distance, xyze_float_t& axis_r, float t);
+
+    #if ENABLED(ARC_NATIVE_MOVES)
+      void startArc(const block_t* block);
+      void nextArcChord();
+
+      // Chords of the arc block calculateMoves() is on, 0 on a line. Positions
+      // are in steps from the start of the block, the radius vectors in mm.
+      int arc_chords = 0;
+      int arc_chord;
+      float arc_chord_len, arc_chord_left;
+      float arc_cos, arc_sin;
+      xy_float_t arc_r0, arc_r;
+      xy_float_t arc_pos, arc_end;
+      xyze_float_t arc_axis_r;
+    #endif
 };
 
 extern MoveQueue moveQueue;
\ No newline at end of file
@@ -0,0 +1,83 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ShapedWindow.h"
+
+ShapedWindow shapedWindow;
+
+void ShapedWindow::reset() {
+  // The window starts at SHAPED_WAITING_MIN_TIME
+  arrival_gap = (SHAPED_WAITING_MIN_TIME - SHAPED_WAITING_FLOOR_TIME) / 2.0f;
+  last_arrival = 0;
+  deferring = false;
+  stopping = false;
+  restarting = true;
+  resetStats();
+}
+
+void ShapedWindow::resetStats() {
+  stats.handovers = 0;
+  stats.deferred = 0;
+  stats.starved = 0;
+  stats.padding = 0;
+  stats.underruns = 0;
+  stats.min_remaining = SHAPED_WAITING_MAX_TIME;
+}
+
+void ShapedWindow::arrival(const millis_t now) {
+  // Average the time between blocks, a pause in the stream is not a rate
+  const millis_t gap = now - last_arrival;
+  if (gap < SHAPED_INPUT_IDLE_TIME) {
+    arrival_gap += (gap - arrival_gap) * 0.125f;
+  }
+  last_arrival = now;
+}
+
+/**
+ * Enough to bridge the expected wait for the next block, less when the
+ * planner buffer already holds the blocks to come, never less than
+ * SHAPED_WAITING_MIN_TIME.
+ */
+float ShapedWindow::waitingTime(const uint8_t nr_moves) const {
+  float gap = arrival_gap;
+  if (nr_moves > BLOCK_BUFFER_SIZE / 2) {
+    gap *= 0.5f;
+  }
+  return constrain(SHAPED_WAITING_FLOOR_TIME + 2 * gap, SHAPED_WAITING_MIN_TIME, SHAPED_WAITING_MAX_TIME);
+}
+
+bool ShapedWindow::forceHandover(const bool unplanned, const float lead, const float need,
+                                 const float right_delta, const bool input_exhausted) {
+  bool force = unplanned && lead < need;
+  // While G-code keeps coming and there is time for one more block, wait for it
+  if (force && !input_exhausted) {
+    if (lead > _MAX(SHAPED_WAITING_MIN_TIME, SHAPED_WAITING_FLOOR_TIME + arrival_gap) + right_delta) {
+      if (!deferring) {
+        stats.deferred++;
+      }
+      force = false;
+    } else {
+      stats.starved++;
+    }
+  }
+  deferring = unplanned && !force && lead < need;
+  return force;
+}
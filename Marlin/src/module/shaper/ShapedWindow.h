@@ -0,0 +1,95 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../../inc/MarlinConfig.h"
+
+// How the shaper hand-off kept up with the G-code stream during a print
+typedef struct {
+  uint32_t handovers;     // Blocks handed to the shaper
+  uint32_t deferred;      // Hand-offs put off to wait for more blocks
+  uint32_t starved;       // Stop-and-go forced while G-code was still coming in
+  uint32_t padding;       // Empty moves inserted behind a stop
+  uint32_t underruns;     // Hand-offs after the steps had run past the motion handed over
+  float min_remaining;    // Least motion left in the step generator at a hand-off, ms
+} shaped_stats_t;
+
+/*
+ The motion Planner::shaped_loop() keeps handed to the shaper ahead of the
+ steppers, see SHAPED_WAITING_MIN_TIME. It takes the time as an argument so
+ snapmaker/host/motion_replay runs the same decisions on its print clock.
+*/
+class ShapedWindow {
+  public:
+    float arrival_gap;        // Average time between new blocks, ms
+    millis_t last_arrival;    // When the last block was queued
+    shaped_stats_t stats;
+
+    ShapedWindow() { reset(); }
+
+    void reset();
+    void resetStats();
+
+    // A block was queued at now
+    void arrival(const millis_t now);
+
+    // Motion to keep handed over before the shaper takes more blocks, ms
+    float waitingTime(const uint8_t nr_moves) const;
+
+    // An empty move ends the motion handed over, it comes to a stop
+    void pad() {
+      stats.padding++;
+      stopping = true;
+    }
+
+    // Blocks are handed over with remaining ms of motion left, a start from
+    // rest after a stop has none and is not counted
+    void handover(const float remaining) {
+      if (!restarting) {
+        NOMORE(stats.min_remaining, remaining);
+        if (remaining < 0) {
+          stats.underruns++;
+        }
+      }
+      restarting = stopping;
+      stopping = false;
+    }
+
+    // No block came in for SHAPED_INPUT_IDLE_TIME
+    bool inputIdle(const millis_t now) const {
+      return ELAPSED(now, last_arrival + SHAPED_INPUT_IDLE_TIME);
+    }
+
+    /*
+     Whether the blocks still being planned are handed over, ending the
+     motion with a stop. lead is the motion left with the planned blocks,
+     need the window plus the shaper delay.
+    */
+    bool forceHandover(const bool unplanned, const float lead, const float need,
+                       const float right_delta, const bool input_exhausted);
+
+  private:
+    bool deferring;
+    bool stopping, restarting;
+};
+
+extern ShapedWindow shapedWindow;
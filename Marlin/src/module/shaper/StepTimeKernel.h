@@ -0,0 +1,93 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ Step time solvers for one segment of the piecewise functions,
+ pos(t) = a * t^2 + b * t + c, t is the time since the segment start.
+
+ Kept free of Marlin headers so the host benchmark builds them as is.
+*/
+
+#include <math.h>
+#include <stdint.h>
+
+#define STEP_TIME_EPSILON 0.000001f
+// Stop iterating once the position still missed after a correction,
+// a * dt^2, is below this, in mm
+#define STEP_TIME_NEWTON_TOLERANCE 0.001f
+#define STEP_TIME_NEWTON_ITERATIONS 2
+
+/*
+ Closed form root, one square root per step. Matches the original solver
+ bit for bit, including sqrtf for the double precision E axis.
+*/
+template <typename T>
+inline T step_time_sqrt(T a, T b, T c, int8_t type, T pos) {
+    c = c - pos;
+
+    if ((a >= 0 ? a : -a) < STEP_TIME_EPSILON) {
+        return -c / b;
+    }
+
+    T d2 = b * b - 4 * a * c;
+    if (d2 < 0) {
+        d2 = 0.0f;
+    }
+
+    T d = sqrtf(d2);
+
+    if (type > 0) {
+        return (-b + d) / (2 * a);
+    } else {
+        return (-b - d) / (2 * a);
+    }
+}
+
+/*
+ Newton iteration seeded from the previous step time of the same segment.
+ Steps are close together so one iteration is usually enough. Falls back to
+ the closed form without a seed (seed < 0), near a turning point, or when
+ the iteration does not settle.
+*/
+template <typename T>
+inline T step_time_newton(T a, T b, T c, int8_t type, T pos, T seed) {
+    if (seed >= 0 && (a >= 0 ? a : -a) >= STEP_TIME_EPSILON) {
+        T t = seed;
+        T cp = c - pos;
+        for (int i = 0; i < STEP_TIME_NEWTON_ITERATIONS; ++i) {
+            T v = 2 * a * t + b;
+            // Moving the wrong way or about to stop, the tangent is useless
+            if (type > 0 ? v <= 0 : v >= 0) {
+                break;
+            }
+            T dt = -((a * t + b) * t + cp) / v;
+            t += dt;
+            T err = a * dt * dt;
+            if ((err >= 0 ? err : -err) < STEP_TIME_NEWTON_TOLERANCE) {
+                return t;
+            }
+        }
+    }
+
+    return step_time_sqrt(a, b, c, type, pos);
+}
@@ -70,7 +70,7 @@ class TimeDouble {
         return *this;
     }
 
-    float operator-(TimeDouble& time_double) const {
+    float operator-(const TimeDouble& time_double) const {
         int res_i = (i - time_double.i);
         float res_d = d - time_double.d;
         return res_i + res_d;
@@ -110,23 +110,23 @@ class TimeDouble {
         return res;
     }
 
-    bool operator>(TimeDouble& time_double) const {
+    bool operator>(const TimeDouble& time_double) const {
         return i != time_double.i ? i > time_double.i : d > time_double.d;
     }
 
-    bool operator>=(TimeDouble& time_double) const {
+    bool operator>=(const TimeDouble& time_double) const {
         return i != time_double.i ? i > time_double.i : d >= time_double.d;
     }
 
-    bool operator<(TimeDouble& time_double) const {
+    bool operator<(const TimeDouble& time_double) const {
         return i != time_double.i ? i < time_double.i : d < time_double.d;
     }
 
-    bool operator<=(TimeDouble& time_double) const {
+    bool operator<=(const TimeDouble& time_double) const {
         return i != time_double.i ? i < time_double.i : d <= time_double.d;
     }
 
-    bool operator==(TimeDouble& time_double) const {
+    bool operator==(const TimeDouble& time_double) const {
         return i == time_double.i && d == time_double.d;
     }
 
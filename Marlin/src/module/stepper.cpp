@@ -101,6 +101,7 @@ Stepper stepper; // Singleton
 #include "../../../snapmaker/module/power_loss.h"
 #include "../../../snapmaker/module/fdm.h"
 #include "../../../snapmaker/module/motion_control.h"
+#include "../../../snapmaker/debug/profiler.h"
 
 #if ENABLED(INTEGRATED_BABYSTEPPING)
   #include "../feature/babystep.h"
@@ -203,6 +204,7 @@ uint32_t Stepper::advance_divisor = 0,
          Stepper::step_event_count;          // The total event count for the current block
 
 AxisStepper Stepper::axis_stepper;
+time_double_t Stepper::step_print_time;
 int Stepper::block_move_target_steps[AXIS_SIZE];
 bool Stepper::is_start = true;
 time_double_t Stepper::block_print_time;
@@ -1443,7 +1445,10 @@ HAL_STEP_TIMER_ISR() {
     }
   #endif
 
-  Stepper::isr();
+  {
+    PROFILE_SCOPE(PROFILE_STEP_ISR);
+    Stepper::isr();
+  }
 
   #if ENABLED(DEBUG_ISR_CPU_USAGE)
     axisManager.counts[19] += HAL_timer_get_count(STEP_TIMER_NUM);
@@ -1738,6 +1743,7 @@ void Stepper::isr() {
  */
 void Stepper::pulse_phase_isr() {
 
+  if (axis_stepper.axis >= 0) step_print_time = axis_stepper.print_time;
   switch_detect.check();
   // endstops.poll();
   power_loss.check();
@@ -1751,7 +1757,8 @@ void Stepper::pulse_phase_isr() {
     is_start = true;
     abort_current_block = false;
     axisManager.req_abort = true;
-    axisManager.T0_T1_simultaneously_move = false;
+    if (axisManager.T0_T1_simultaneously_move)
+      axisManager.T0_T1_move_end();
     planner.cleaning_buffer_counter = TEMP_TIMER_FREQUENCY / 10;
 
     is_only_extrude = false;
@@ -1967,21 +1974,16 @@ uint32_t Stepper::block_phase_isr() {
     // #ifdef DEBUG_IO
     //   WRITE(DEBUG_IO, 0);
     // #endif
-      if (axis_stepper.delta_time < 0) {
-        axis_stepper.delta_time = 0;
-      }
+      interval = axis_stepper.ticks;
 
+      // Step events are solved by the temperature ISR, only top up here
+      // when it falls behind
       hal_timer_t st = HAL_timer_get_count(STEP_TIMER_NUM);
-      if (axis_stepper.delta_time > 0.02) {
-        axisManager.calcNextAxisStepper();
-        axisManager.calcNextAxisStepper();
-      } else if (axis_stepper.delta_time > 0.01) {
-        axisManager.calcNextAxisStepper();
+      if (axisManager.getAxisStepperSize() < AXIS_STEPPER_LOW_WATER && axisManager.tryCalcNextAxisStepper()) {
+        axisManager.counts[SHAPER_DBG_STEP_QUEUE_ISR_CALC]++;
       }
       hal_timer_t et = HAL_timer_get_count(STEP_TIMER_NUM);
 
-      interval = (uint32_t)(axis_stepper.delta_time * STEPPER_TIMER_TICKS_PER_MS);
-
       hal_timer_t dt = et - st;
       if (interval > 0 && (hal_timer_t)interval < dt) {
         axisManager.counts[SHAPER_DBG_CALC_STEP_TIMEOUT_COUNT]++;
@@ -1997,6 +1999,12 @@ uint32_t Stepper::block_phase_isr() {
 
       done_count = 0;
     }
+    else if (axisManager.axis_stepper_producing) {
+      // The temperature ISR was preempted while solving the next step,
+      // hand the CPU back to it for a moment
+      axisManager.counts[SHAPER_DBG_STEP_QUEUE_UNDERRUN]++;
+      interval = STEPPER_TIMER_TICKS_PER_US * 10;
+    }
     else {
 
       done_count++;
@@ -2210,10 +2218,10 @@ uint32_t Stepper::block_phase_isr() {
 
       block_print_time = current_block->shaper_data.last_print_time;
       Move& end_move = moveQueue.moves[current_block->shaper_data.move_end];
-      for (int i = 0; i < AXIS_SIZE; ++i) {
-          block_move_target_steps[i] = LROUND(end_move.end_pos[i]);
+      for (int i = 0; i < MOVE_POS_AXES; ++i) {
+          block_move_target_steps[i] = LROUND(end_move.end_pos(i));
       }
-      block_move_target_steps[E_AXIS] = (int)(end_move.end_pos_e + 0.5);
+      block_move_target_steps[E_AXIS] = (int)(end_move.end_pos_e() + 0.5);
 
       // Initialize Bresenham delta errors to 1/2
       // delta_error = -int32_t(step_event_count);
@@ -2307,8 +2315,7 @@ uint32_t Stepper::block_phase_isr() {
 
       if (is_start) {
         is_start = false;
-        while (axisManager.calcNextAxisStepper()) {
-        }
+        axisManager.tryCalcNextAxisStepper();
         axisManager.getNextAxisStepper(&axis_stepper);
       }
 
@@ -2531,7 +2538,7 @@ uint32_t Stepper::other_axis_block_phase_isr() {
   // }
 
   if (abs(axisManager.T0_T1_calc_steps) == abs(axisManager.T0_T1_execute_steps)) {
-    axisManager.T0_T1_simultaneously_move = false;
+    axisManager.T0_T1_move_end();
     return interval;
   }
 
@@ -2551,7 +2558,7 @@ uint32_t Stepper::other_axis_block_phase_isr() {
       axisManager.axis_t0_t1.is_consumed = true;
     }
     else {
-      axisManager.T0_T1_simultaneously_move = false;
+      axisManager.T0_T1_move_end();
     }
   }
 
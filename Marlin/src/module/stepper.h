@@ -321,6 +321,8 @@ class Stepper {
                     step_event_count;       // The total event count for the current block
 
     static AxisStepper axis_stepper;
+    // Print time of the last step output, the step timer counts from its ISR
+    static time_double_t step_print_time;
 
     static int block_move_target_steps[AXIS_SIZE];
     static bool is_start;
@@ -36,8 +36,10 @@
 #include "temperature.h"
 #include "endstops.h"
 #include "planner.h"
+#include "AxisManager.h"
 #include "../../../snapmaker/module/filament_sensor.h"
 #include "../../../snapmaker/module/exception.h"
+#include "../../../snapmaker/debug/profiler.h"
 
 #if EITHER(HAS_COOLER, LASER_COOLANT_FLOW_METER)
   #include "../feature/cooler.h"
@@ -222,6 +224,12 @@
   static constexpr uint8_t heater_ttbllen_map[HOTENDS] = ARRAY_BY_HOTENDS(TEMPTABLE_0_LEN REPEAT_S(1, HOTENDS, NEXT_TEMPTABLE_LEN));
 #endif
 
+// The HAL oversamples the thermistors itself, unless other sensors need the state machine
+#if defined(HAL_ADC_DMA_OVERSAMPLE) && !HAS_ADC_BUTTONS && !HAS_POWER_MONITOR && NONE(FILAMENT_WIDTH_SENSOR, JOYSTICK) \
+    && !HAS_TEMP_ADC_PROBE && !HAS_TEMP_ADC_COOLER && !HAS_TEMP_ADC_REDUNDANT && !HAS_TEMP_ADC_6 && !HAS_TEMP_ADC_7
+  #define HAS_ADC_WINDOW 1
+#endif
+
 #define BED_TEMP_FIRST_MIN_ABNORMAL_DISABLE_TIME_MS   (5 * 60 * 1000)
 #define BED_TEMP_MIN_ABNORMAL_WATCH_WINDOW_TIME_MS    (10 * 60 * 1000)
 
@@ -3038,7 +3046,10 @@ void Temperature::readings_ready() {
 HAL_TEMP_TIMER_ISR() {
   HAL_timer_isr_prologue(TEMP_TIMER_NUM);
 
-  Temperature::isr();
+  {
+    PROFILE_SCOPE(PROFILE_TEMP_ISR);
+    Temperature::isr();
+  }
 
   HAL_timer_isr_epilogue(TEMP_TIMER_NUM);
 }
@@ -3079,8 +3090,10 @@ public:
  */
 void Temperature::isr() {
 
-  static int8_t temp_count = -1;
-  static ADCSensorState adc_sensor_state = StartupDelay;
+  #if !HAS_ADC_WINDOW
+    static int8_t temp_count = -1;
+    static ADCSensorState adc_sensor_state = StartupDelay;
+  #endif
   static uint8_t pwm_count = _BV(SOFT_PWM_SCALE);
 
   // avoid multiple loads of pwm_count
@@ -3372,6 +3385,34 @@ void Temperature::isr() {
   static bool do_buttons;
   if ((do_buttons ^= true)) ui.update_buttons();
 
+  #if HAS_ADC_WINDOW
+
+  /**
+   * The HAL sums every conversion of the sensors on its own. A window is
+   * closed as often as the state machine below would read the sensors, so
+   * PID_dT stays the same, and its means are scaled to OVERSAMPLENR samples.
+   */
+  static uint16_t window_count = 0;
+  if (++window_count >= OVERSAMPLENR * ACTUAL_ADC_SAMPLES) {
+    window_count = 0;
+    HAL_adc_close_window();
+  }
+  if (HAL_adc_window_ready()) {
+    #define WINDOW_ADC(obj, pin) obj.sample(HAL_adc_window_mean(pin, OVERSAMPLENR))
+    TERN_(HAS_TEMP_ADC_0, WINDOW_ADC(temp_hotend[0], TEMP_0_PIN));
+    TERN_(HAS_TEMP_ADC_BED, WINDOW_ADC(temp_bed, TEMP_BED_PIN));
+    TERN_(HAS_TEMP_ADC_CHAMBER, WINDOW_ADC(temp_chamber, TEMP_CHAMBER_PIN));
+    TERN_(HAS_TEMP_ADC_1, WINDOW_ADC(temp_hotend[1], TEMP_1_PIN));
+    TERN_(HAS_TEMP_ADC_2, WINDOW_ADC(temp_hotend[2], TEMP_2_PIN));
+    TERN_(HAS_TEMP_ADC_3, WINDOW_ADC(temp_hotend[3], TEMP_3_PIN));
+    TERN_(HAS_TEMP_ADC_4, WINDOW_ADC(temp_hotend[4], TEMP_4_PIN));
+    TERN_(HAS_TEMP_ADC_5, WINDOW_ADC(temp_hotend[5], TEMP_5_PIN));
+    HAL_adc_window_release();
+    readings_ready();
+  }
+
+  #else // !HAS_ADC_WINDOW
+
   /**
    * One sensor is sampled on every other call of the ISR.
    * Each sensor is read 16 (OVERSAMPLENR) times, taking the average.
@@ -3555,6 +3596,8 @@ void Temperature::isr() {
   // Go to the next state
   adc_sensor_state = next_sensor_state;
 
+  #endif // !HAS_ADC_WINDOW
+
   //
   // Additional ~1KHz Tasks
   //
@@ -3568,6 +3611,12 @@ void Temperature::isr() {
 
   // Periodically call the planner timer service routine
   planner.isr();
+
+  // Solve the upcoming step events ahead of the stepper ISR
+  {
+    PROFILE_SCOPE(PROFILE_STEP_PRODUCE);
+    axisManager.produceAxisSteppers();
+  }
 }
 
 #if HAS_TEMP_SENSOR
@@ -66,7 +66,16 @@ typedef struct { int32_t value; celsius_t celsius; } temp_entry_t;
 #define PtLine(T,R0,Rup) { OV(PtAdVal(T, R0, Rup)), T }
 
 #if ANY_THERMISTOR_IS(1) // beta25 = 4092 K, R25 = 100 kOhm, Pull-up = 4.7 kOhm, "EPCOS"
+  #ifdef HAL_ADC_DMA_OVERSAMPLE
+    // A 10-bit table, the HAL gives the bed and chamber all 12 bits
+    #undef OV_SCALE
+    #define OV_SCALE(N) ((N) * 4)
+  #endif
   #include "thermistor_1.h"
+  #ifdef HAL_ADC_DMA_OVERSAMPLE
+    #undef OV_SCALE
+    #define OV_SCALE(N) (N)
+  #endif
 #endif
 #if ANY_THERMISTOR_IS(2) // 4338 K, R25 = 200 kOhm, Pull-up = 4.7 kOhm, "ATC Semitec 204GT-2"
   #include "thermistor_2.h"
@@ -1034,6 +1034,11 @@ void tool_change(const uint8_t new_tool, bool no_move/*=false*/) {
       return invalid_extruder_error(new_tool);
     }
 
+    #if ENABLED(DUAL_X_CARRIAGE)
+      // The shaper profile of the new carriage, the planner is empty here
+      axisManager.input_shaper_select(axisManager.input_shaper_profile_of(new_tool));
+    #endif
+
     if (!no_move && homing_needed()) {
       no_move = true;
       DEBUG_ECHOLNPGM("No move (not homed)");
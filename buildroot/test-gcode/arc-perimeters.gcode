@@ -0,0 +1,178 @@
+; Arc test: rounded rectangle perimeters and round holes as G2/G3
+; 4 layers, 3 perimeters, 2 holes per layer, corners R5 to R3
+G90
+M83
+G92 E0
+; layer 0
+G0 Z0.20 F600
+G0 X75.000 Y80.000 F12000
+G1 F3600
+G1 X125.000 Y80.000 E1.65000
+G3 X130.000 Y85.000 I0.000 J5.000 E0.25918
+G1 X130.000 Y115.000 E0.99000
+G3 X125.000 Y120.000 I-5.000 J0.000 E0.25918
+G1 X75.000 Y120.000 E1.65000
+G3 X70.000 Y115.000 I0.000 J-5.000 E0.25918
+G1 X70.000 Y85.000 E0.99000
+G3 X75.000 Y80.000 I5.000 J0.000 E0.25918
+G0 X75.000 Y80.400 F12000
+G1 F3600
+G1 X125.000 Y80.400 E1.65000
+G3 X129.600 Y85.000 I0.000 J4.600 E0.23845
+G1 X129.600 Y115.000 E0.99000
+G3 X125.000 Y119.600 I-4.600 J0.000 E0.23845
+G1 X75.000 Y119.600 E1.65000
+G3 X70.400 Y115.000 I0.000 J-4.600 E0.23845
+G1 X70.400 Y85.000 E0.99000
+G3 X75.000 Y80.400 I4.600 J0.000 E0.23845
+G0 X75.000 Y80.800 F12000
+G1 F3600
+G1 X125.000 Y80.800 E1.65000
+G3 X129.200 Y85.000 I0.000 J4.200 E0.21771
+G1 X129.200 Y115.000 E0.99000
+G3 X125.000 Y119.200 I-4.200 J0.000 E0.21771
+G1 X75.000 Y119.200 E1.65000
+G3 X70.800 Y115.000 I0.000 J-4.200 E0.21771
+G1 X70.800 Y85.000 E0.99000
+G3 X75.000 Y80.800 I4.200 J0.000 E0.21771
+G0 X91.000 Y100.000 F12000
+G2 X91.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X91.400 Y100.000 F12000
+G2 X91.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X121.000 Y100.000 F12000
+G2 X121.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X121.400 Y100.000 F12000
+G2 X121.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X92.000 Y86.000 F12000
+G3 X100.000 Y86.000 R4 F3000 E0.41469
+G2 X108.000 Y86.000 R4 E0.41469
+; layer 1
+G0 Z0.40 F600
+G0 X75.000 Y80.000 F12000
+G1 F3600
+G1 X125.000 Y80.000 E1.65000
+G3 X130.000 Y85.000 I0.000 J5.000 E0.25918
+G1 X130.000 Y115.000 E0.99000
+G3 X125.000 Y120.000 I-5.000 J0.000 E0.25918
+G1 X75.000 Y120.000 E1.65000
+G3 X70.000 Y115.000 I0.000 J-5.000 E0.25918
+G1 X70.000 Y85.000 E0.99000
+G3 X75.000 Y80.000 I5.000 J0.000 E0.25918
+G0 X75.000 Y80.400 F12000
+G1 F3600
+G1 X125.000 Y80.400 E1.65000
+G3 X129.600 Y85.000 I0.000 J4.600 E0.23845
+G1 X129.600 Y115.000 E0.99000
+G3 X125.000 Y119.600 I-4.600 J0.000 E0.23845
+G1 X75.000 Y119.600 E1.65000
+G3 X70.400 Y115.000 I0.000 J-4.600 E0.23845
+G1 X70.400 Y85.000 E0.99000
+G3 X75.000 Y80.400 I4.600 J0.000 E0.23845
+G0 X75.000 Y80.800 F12000
+G1 F3600
+G1 X125.000 Y80.800 E1.65000
+G3 X129.200 Y85.000 I0.000 J4.200 E0.21771
+G1 X129.200 Y115.000 E0.99000
+G3 X125.000 Y119.200 I-4.200 J0.000 E0.21771
+G1 X75.000 Y119.200 E1.65000
+G3 X70.800 Y115.000 I0.000 J-4.200 E0.21771
+G1 X70.800 Y85.000 E0.99000
+G3 X75.000 Y80.800 I4.200 J0.000 E0.21771
+G0 X91.000 Y100.000 F12000
+G2 X91.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X91.400 Y100.000 F12000
+G2 X91.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X121.000 Y100.000 F12000
+G2 X121.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X121.400 Y100.000 F12000
+G2 X121.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X92.000 Y86.000 F12000
+G3 X100.000 Y86.000 R4 F3000 E0.41469
+G2 X108.000 Y86.000 R4 E0.41469
+; layer 2
+G0 Z0.60 F600
+G0 X75.000 Y80.000 F12000
+G1 F3600
+G1 X125.000 Y80.000 E1.65000
+G3 X130.000 Y85.000 I0.000 J5.000 E0.25918
+G1 X130.000 Y115.000 E0.99000
+G3 X125.000 Y120.000 I-5.000 J0.000 E0.25918
+G1 X75.000 Y120.000 E1.65000
+G3 X70.000 Y115.000 I0.000 J-5.000 E0.25918
+G1 X70.000 Y85.000 E0.99000
+G3 X75.000 Y80.000 I5.000 J0.000 E0.25918
+G0 X75.000 Y80.400 F12000
+G1 F3600
+G1 X125.000 Y80.400 E1.65000
+G3 X129.600 Y85.000 I0.000 J4.600 E0.23845
+G1 X129.600 Y115.000 E0.99000
+G3 X125.000 Y119.600 I-4.600 J0.000 E0.23845
+G1 X75.000 Y119.600 E1.65000
+G3 X70.400 Y115.000 I0.000 J-4.600 E0.23845
+G1 X70.400 Y85.000 E0.99000
+G3 X75.000 Y80.400 I4.600 J0.000 E0.23845
+G0 X75.000 Y80.800 F12000
+G1 F3600
+G1 X125.000 Y80.800 E1.65000
+G3 X129.200 Y85.000 I0.000 J4.200 E0.21771
+G1 X129.200 Y115.000 E0.99000
+G3 X125.000 Y119.200 I-4.200 J0.000 E0.21771
+G1 X75.000 Y119.200 E1.65000
+G3 X70.800 Y115.000 I0.000 J-4.200 E0.21771
+G1 X70.800 Y85.000 E0.99000
+G3 X75.000 Y80.800 I4.200 J0.000 E0.21771
+G0 X91.000 Y100.000 F12000
+G2 X91.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X91.400 Y100.000 F12000
+G2 X91.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X121.000 Y100.000 F12000
+G2 X121.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X121.400 Y100.000 F12000
+G2 X121.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X92.000 Y86.000 F12000
+G3 X100.000 Y86.000 R4 F3000 E0.41469
+G2 X108.000 Y86.000 R4 E0.41469
+; layer 3
+G0 Z0.80 F600
+G0 X75.000 Y80.000 F12000
+G1 F3600
+G1 X125.000 Y80.000 E1.65000
+G3 X130.000 Y85.000 I0.000 J5.000 E0.25918
+G1 X130.000 Y115.000 E0.99000
+G3 X125.000 Y120.000 I-5.000 J0.000 E0.25918
+G1 X75.000 Y120.000 E1.65000
+G3 X70.000 Y115.000 I0.000 J-5.000 E0.25918
+G1 X70.000 Y85.000 E0.99000
+G3 X75.000 Y80.000 I5.000 J0.000 E0.25918
+G0 X75.000 Y80.400 F12000
+G1 F3600
+G1 X125.000 Y80.400 E1.65000
+G3 X129.600 Y85.000 I0.000 J4.600 E0.23845
+G1 X129.600 Y115.000 E0.99000
+G3 X125.000 Y119.600 I-4.600 J0.000 E0.23845
+G1 X75.000 Y119.600 E1.65000
+G3 X70.400 Y115.000 I0.000 J-4.600 E0.23845
+G1 X70.400 Y85.000 E0.99000
+G3 X75.000 Y80.400 I4.600 J0.000 E0.23845
+G0 X75.000 Y80.800 F12000
+G1 F3600
+G1 X125.000 Y80.800 E1.65000
+G3 X129.200 Y85.000 I0.000 J4.200 E0.21771
+G1 X129.200 Y115.000 E0.99000
+G3 X125.000 Y119.200 I-4.200 J0.000 E0.21771
+G1 X75.000 Y119.200 E1.65000
+G3 X70.800 Y115.000 I0.000 J-4.200 E0.21771
+G1 X70.800 Y85.000 E0.99000
+G3 X75.000 Y80.800 I4.200 J0.000 E0.21771
+G0 X91.000 Y100.000 F12000
+G2 X91.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X91.400 Y100.000 F12000
+G2 X91.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X121.000 Y100.000 F12000
+G2 X121.000 Y100.000 I-6.000 J0 F3000 E1.24407
+G0 X121.400 Y100.000 F12000
+G2 X121.400 Y100.000 I-6.400 J0 F3000 E1.32701
+G0 X92.000 Y86.000 F12000
+G3 X100.000 Y86.000 R4 F3000 E0.41469
+G2 X108.000 Y86.000 R4 E0.41469
+G0 Z5 F600
@@ -38,6 +38,7 @@
 #include "../../../src/module/AxisManager.h"
 #include "../module/factory_data.h"
 #include "../module/calibtration.h"
+#include "../module/driver_load.h"
 
 
 TaskHandle_t thandle_event_loop = NULL;
@@ -435,6 +436,7 @@ void j1_main_task(void *args) {
 
   while(1) {
     print_control.loop();
+    power_loss.journal();
     printer_event_loop();
     exception_event_loop();
     local_event_loop();
@@ -500,6 +502,8 @@ void J1_setup() {
   switch_detect.init();
   fdm_head.init();
   debug.init();
+  TMC2208Stepper::uart_queue_start();
+  driver_load.init();
   subscribe_init();
   event_init();
   system_service.init();
@@ -30,6 +30,7 @@
 #include "../module/filament_sensor.h"
 #include "src/module/endstops.h"
 #include "../module/motion_control.h"
+#include "src/module/AxisManager.h"
 
 #define SW_FILAMNET0_BIT      0
 #define SW_FILAMNET1_BIT      1
@@ -58,6 +59,11 @@ SwitchDetect switch_detect;
 void SwitchDetect::init() {
   SET_OUTPUT(PROBE_POWER_EN_PIN);
   SET_INPUT_PULLUP(STALL_GUARD_PIN);
+  // Probe edges are timed by EXTI, check() still confirms the contact
+  ExtiInit(X0_CAL_PIN, EXTI_Rising_and_falling);
+  ExtiInit(X1_CAL_PIN, EXTI_Rising_and_falling);
+  DisableExtiInterrupt(X0_CAL_PIN);
+  DisableExtiInterrupt(X1_CAL_PIN);
   init_probe();
   disable_all();
   motion_control.init_stall_guard();
@@ -110,12 +116,56 @@ void SwitchDetect::check() {
     } while(trigged && max_continue_trigger_cnt < 10);
   }
 
-  if(trigged == true)
+  if(trigged == true) {
+    latch_probe_position();
     stepper.quick_stop();
+  }
 
   status_bits = tmp_status_bits;
 }
 
+// EXTI of a probe pin. The step timer counts from the ISR of the last step
+// output, which puts the edge on the shaped motion timebase.
+void SwitchDetect::capture_probe_edge(uint8_t probe) {
+  if (!TEST(enable_bits, SW_PROBE0_BIT + probe)) return;
+  if ((probe ? READ(X1_CAL_PIN) : READ(X0_CAL_PIN)) != probe_detect_level) return;
+  // The 64-bit print time and the count must come from the same step, so the
+  // step ISR may not run in between
+  const uint32_t primask = __get_primask();
+  DISABLE_ISRS();
+  const time_double_t step_time = stepper.step_print_time;
+  const uint32_t step_count = HAL_timer_get_count(STEP_TIMER_NUM);
+  if (!primask) ENABLE_ISRS();
+  probe_edge_time = step_time + (float)step_count / STEPPER_TIMER_TICKS_PER_MS;
+  probe_edge_valid = true;
+}
+
+// Called from check() when it confirms a probe, before the stop. The step
+// counts are those up to the last step before the edge, the position
+// function of the axis at the edge time gives the rest of the step. When the
+// edge is not timed or its segment is gone, the stop position stands.
+void SwitchDetect::latch_probe_position() {
+  if (probe_latched) return;
+  probe_latched = true;
+  // The temperature ISR is solving steps and moving the kept segments
+  if (!probe_edge_valid || axisManager.axis_stepper_producing) return;
+
+  LOOP_LINEAR_AXES(i) {
+    float pos;
+    if (!axisManager.axis[i].func_manager.getKeptPos(probe_edge_time, pos)) return;
+    probe_steps[i] = stepper.position((AxisEnum)i) + (pos - LROUND(pos));
+  }
+  probe_position_valid = true;
+}
+
+// Axis position in mm at the last probe edge, false when only the stop
+// position is known
+bool SwitchDetect::probe_trigger_position(uint8_t axis, float &pos) {
+  if (!probe_position_valid) return false;
+  pos = probe_steps[axis] / planner.settings.axis_steps_per_mm[axis];
+  return true;
+}
+
 void SwitchDetect::disable_all() {
   enable_bits = 0;
   status_bits = 0;
@@ -124,11 +174,18 @@ void SwitchDetect::disable_all() {
 void SwitchDetect::enable_probe(bool trigger_level) {
   init_probe();
   probe_detect_level = trigger_level;
+  probe_edge_valid = false;
+  probe_latched = false;
+  probe_position_valid = false;
   enable(SW_PROBE0_BIT);
   enable(SW_PROBE1_BIT);
+  EnableExtiInterrupt(X0_CAL_PIN);
+  EnableExtiInterrupt(X1_CAL_PIN);
 }
 
 void SwitchDetect::disable_probe() {
+  DisableExtiInterrupt(X0_CAL_PIN);
+  DisableExtiInterrupt(X1_CAL_PIN);
   disable(SW_PROBE0_BIT);
   disable(SW_PROBE1_BIT);
 }
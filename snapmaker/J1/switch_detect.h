@@ -20,6 +20,7 @@
  */
 
 #include "stdint.h"
+#include "../../Marlin/src/module/shaper/TimeDouble.h"
 
 class SwitchDetect
 {
@@ -44,17 +45,27 @@ public:
   bool read_e1_probe_status();
   bool read_active_extruder_status();
   // bool test_trigger();
+  void capture_probe_edge(uint8_t probe);
+  bool probe_trigger_position(uint8_t axis, float &pos);
 
   bool debug_probe_poweron_sw = true;
 
 private:
   void enable(uint8_t Item);
   void disable(uint8_t Item);
+  void latch_probe_position();
 
 private:
   uint32_t enable_bits;
   uint32_t status_bits;
   uint8_t probe_detect_level = 0;
+
+  // Last probe edge on the shaped motion timebase and the contact it gives
+  volatile bool probe_edge_valid = false;
+  time_double_t probe_edge_time = 0;
+  bool probe_latched = false;
+  bool probe_position_valid = false;
+  float probe_steps[LINEAR_AXES];
 };
 
 extern SwitchDetect switch_detect;
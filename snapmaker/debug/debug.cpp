@@ -67,8 +67,97 @@ const char *snap_debug_str[SNAP_DEBUG_LEVEL_MAX] = {
 };
 
 
+// A record is a 4 byte header and the text, or the deferred format and args,
+// padded to 4 bytes. Records never wrap, the end of the ring is padded instead.
+enum : uint8_t {
+  LOG_REC_BUSY,   // Reserved, the writer is still copying
+  LOG_REC_TEXT,
+  LOG_REC_DEFER,
+  LOG_REC_PAD,    // Rest of the ring is unused, go on at 0
+};
+
+typedef struct {
+  volatile uint8_t state;
+  uint8_t level;
+  uint16_t len;
+} log_record_t;
+
+typedef struct {
+  const char *fmt;
+  uint32_t args[4];
+} log_defer_t;
+
+#define LOG_RECORD_SIZE(len) (sizeof(log_record_t) + (((len) + 3) & ~3))
+
+static uint8_t log_ring[SNAP_LOG_RING_SIZE] __attribute__((aligned(4)));
+static volatile uint16_t log_head = 0;
+static volatile uint16_t log_tail = 0;
+static TaskHandle_t thandle_log = NULL;
+
+// frame[0..3] is the SACP log head, text follows
+static char log_frame[4 + SNAP_LOG_FRAME_TEXT];
+static uint16_t log_frame_len = 0;
+static uint8_t log_frame_level = 0;
+
+// Reserve room for a record, NULL if the ring is full. Safe in interrupts.
+static log_record_t *log_reserve(debug_level_e level, uint16_t len) {
+  uint16_t size = LOG_RECORD_SIZE(len);
+  log_record_t *rec = NULL;
+
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  uint16_t head = log_head, tail = log_tail;
+  uint16_t used = (head + SNAP_LOG_RING_SIZE - tail) % SNAP_LOG_RING_SIZE;
+  uint16_t pad = (head + size > SNAP_LOG_RING_SIZE) ? SNAP_LOG_RING_SIZE - head : 0;
+  // Keep one word free to tell full from empty
+  if (used + pad + size < SNAP_LOG_RING_SIZE) {
+    if (pad) {
+      ((log_record_t *)&log_ring[head])->state = LOG_REC_PAD;
+      head = 0;
+    }
+    rec = (log_record_t *)&log_ring[head];
+    rec->state = LOG_REC_BUSY;
+    rec->level = level;
+    rec->len = len;
+    log_head = (head + size) % SNAP_LOG_RING_SIZE;
+  }
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return rec;
+}
+
+static void log_commit(log_record_t *rec, uint8_t state) {
+  __asm__ volatile("dmb" ::: "memory");
+  rec->state = state;
+
+  if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+    // No task to drain yet, send it now like before
+    debug.drain();
+    return;
+  }
+  uint16_t used = (log_head + SNAP_LOG_RING_SIZE - log_tail) % SNAP_LOG_RING_SIZE;
+  if (thandle_log && (rec->level >= SNAP_DEBUG_LEVEL_ERROR || used > SNAP_LOG_RING_SIZE / 2)) {
+    if (xPortIsInsideInterrupt()) {
+      vTaskNotifyGiveFromISR(thandle_log, NULL);
+    } else {
+      xTaskNotifyGive(thandle_log);
+    }
+  }
+}
+
+static void log_task(void *arg) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SNAP_LOG_DRAIN_MS));
+    debug.drain();
+  }
+}
+
 void SnapDebug::init() {
-  return;
+  // Same priority as the other tasks, marlin_loop never blocks so a lower
+  // one would starve. The task sleeps until the ring fills or the period ends.
+  BaseType_t ret = xTaskCreate(log_task, "snap_log", SNAP_LOG_TASK_STACK, NULL, 5, &thandle_log);
+  if (ret != pdPASS) {
+    thandle_log = NULL;
+    SERIAL_ECHO("Failed to create snap_log!\n");
+  }
 }
 
 // output debug message, will not output message whose level
@@ -78,43 +167,139 @@ void SnapDebug::init() {
 //    fmt - format of messages
 //    ... - args
 void SnapDebug::Log(debug_level_e level, const char *fmt, ...) {
-  char log_buf[SNAP_LOG_BUFFER_SIZE + 4];
+  char log_buf[SNAP_LOG_BUFFER_SIZE];
   va_list args;
 
   if (level < debug_msg_level)
     return;
 
-  // the front 4 bytes will be used to save SACP packet info
-  char *data = log_buf + 4;
-
   va_start(args, fmt);
-  vsnprintf(data, SNAP_LOG_BUFFER_SIZE, fmt, args);
+  int len = vsnprintf(log_buf, SNAP_LOG_BUFFER_SIZE, fmt, args);
   va_end(args);
 
-  log_buf[0] = E_SUCCESS;
-  log_buf[1] = level;
+  if (len < 0)
+    return;
+  if (len >= SNAP_LOG_BUFFER_SIZE) {
+    Write(SNAP_DEBUG_LEVEL_ERROR, STR_LOG_LEN_TOO_LARGE, sizeof(STR_LOG_LEN_TOO_LARGE) - 1);
+    len = SNAP_LOG_BUFFER_SIZE - 1;
+  }
+  Write(level, log_buf, len);
+}
 
-  // length of string
-  uint16_t *data_len = ((uint16_t *)(&log_buf[2]));
-  *data_len = strlen(data);
+void SnapDebug::Write(debug_level_e level, const char *text, uint16_t len) {
+  if (level < debug_msg_level)
+    return;
 
-  if ((*data_len) > SNAP_LOG_BUFFER_SIZE) {
-    send_data(EVENT_SOURCE_MARLIN, (uint8_t *)STR_LOG_LEN_TOO_LARGE, sizeof(STR_LOG_LEN_TOO_LARGE));
+  if (len > SNAP_LOG_FRAME_TEXT)
+    len = SNAP_LOG_FRAME_TEXT;
+  log_record_t *rec = log_reserve(level, len);
+  if (!rec) {
+    dropped_ = dropped_ + 1;
+    return;
+  }
+  memcpy(rec + 1, text, len);
+  log_commit(rec, LOG_REC_TEXT);
+}
+
+void SnapDebug::Defer(debug_level_e level, const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+  if (level < debug_msg_level)
+    return;
+
+  log_record_t *rec = log_reserve(level, sizeof(log_defer_t));
+  if (!rec) {
+    dropped_ = dropped_ + 1;
+    return;
   }
+  log_defer_t *defer = (log_defer_t *)(rec + 1);
+  defer->fmt = fmt;
+  defer->args[0] = a0;
+  defer->args[1] = a1;
+  defer->args[2] = a2;
+  defer->args[3] = a3;
+  log_commit(rec, LOG_REC_DEFER);
+}
+
+// Send the lines gathered in log_frame, the same way a line was sent before
+void SnapDebug::flush_frame() {
+  if (!log_frame_len)
+    return;
+
+  log_frame[0] = E_SUCCESS;
+  log_frame[1] = log_frame_level;
+  log_frame[2] = log_frame_len & 0xFF;
+  log_frame[3] = log_frame_len >> 8;
 
   SACP_head_base_t sacp = {SACP_ID_HMI, SACP_ATTR_ACK, 0, COMMAND_SET_SYS, SYS_ID_REPORT_LOG};
 
   // always send log to HMI
-  send_event(EVENT_SOURCE_HMI, sacp, (uint8_t*)log_buf, *data_len + 4);
+  send_event(EVENT_SOURCE_HMI, sacp, (uint8_t*)log_frame, log_frame_len + 4);
 
   if (!event_serial[EVENT_SOURCE_MARLIN]->enable_sacp()) {
     // send raw string to PC channel
-    send_data(EVENT_SOURCE_MARLIN, (uint8_t *)data, *data_len);
+    send_data(EVENT_SOURCE_MARLIN, (uint8_t *)log_frame + 4, log_frame_len);
   } else {
     sacp.recever_id = SACP_ID_PC;
     // send log to PC channel with SACP packet
-    send_event(EVENT_SOURCE_MARLIN, sacp, (uint8_t*)log_buf, *data_len + 4);
+    send_event(EVENT_SOURCE_MARLIN, sacp, (uint8_t*)log_frame, log_frame_len + 4);
+  }
+  log_frame_len = 0;
+}
+
+void SnapDebug::send_dropped() {
+  uint32_t dropped = dropped_;
+  if (dropped == dropped_sent_)
+    return;
+
+  char *text = log_frame + 4;
+  flush_frame();
+  log_frame_level = SNAP_DEBUG_LEVEL_WARNING;
+  log_frame_len = snprintf(text, SNAP_LOG_FRAME_TEXT, "log ring full, %u lines dropped\n", (unsigned)(dropped - dropped_sent_));
+  flush_frame();
+  dropped_sent_ = dropped;
+}
+
+// Send every committed record, lines of one level share a frame
+void SnapDebug::drain() {
+  char *text = log_frame + 4;
+
+  while (log_tail != log_head) {
+    uint16_t tail = log_tail;
+    log_record_t *rec = (log_record_t *)&log_ring[tail];
+    uint8_t state = rec->state;
+    if (state == LOG_REC_BUSY) {
+      // Still being written, the rest waits for the next round
+      break;
+    }
+    if (state == LOG_REC_PAD) {
+      log_tail = 0;
+      continue;
+    }
+
+    if (log_frame_len && rec->level != log_frame_level) {
+      flush_frame();
+    }
+    log_frame_level = rec->level;
+    if (state == LOG_REC_DEFER) {
+      log_defer_t *defer = (log_defer_t *)(rec + 1);
+      char line[SNAP_LOG_BUFFER_SIZE];
+      int len = snprintf(line, sizeof(line), defer->fmt, defer->args[0], defer->args[1], defer->args[2], defer->args[3]);
+      len = len < 0 ? 0 : (len < (int)sizeof(line) ? len : sizeof(line) - 1);
+      if (log_frame_len + len > SNAP_LOG_FRAME_TEXT) {
+        flush_frame();
+      }
+      memcpy(text + log_frame_len, line, len);
+      log_frame_len += len;
+    } else {
+      if (log_frame_len + rec->len > SNAP_LOG_FRAME_TEXT) {
+        flush_frame();
+      }
+      memcpy(text + log_frame_len, rec + 1, rec->len);
+      log_frame_len += rec->len;
+    }
+    log_tail = (tail + LOG_RECORD_SIZE(rec->len)) % SNAP_LOG_RING_SIZE;
   }
+  flush_frame();
+  send_dropped();
 }
 
 
@@ -148,6 +333,8 @@ void SnapDebug::show_all_status() {
   extern uint32_t max_starve_dog_time;
   snprintf(log_buf, SNAP_LOG_BUFFER_SIZE, "max_starve_dog_time:%d ms\n", (unsigned int)max_starve_dog_time);
   SERIAL_ECHO(log_buf);
+  snprintf(log_buf, SNAP_LOG_BUFFER_SIZE, "log lines dropped:%u\n", (unsigned int)dropped());
+  SERIAL_ECHO(log_buf);
 
   extruder_info_t extruder0_info, extruder1_info;
   fdm_head.get_extruder_info(0, &extruder0_info);
@@ -57,6 +57,13 @@ enum GcodeState : uint8_t {
 // log buffer size, max length for one debug massage
 #define SNAP_LOG_BUFFER_SIZE 256
 
+// Lines are queued in a ring and sent by the snap_log task, several lines
+// of one level per SACP frame. A line that does not fit is counted as dropped.
+#define SNAP_LOG_RING_SIZE      2048
+#define SNAP_LOG_FRAME_TEXT     448
+#define SNAP_LOG_DRAIN_MS       20
+#define SNAP_LOG_TASK_STACK     512
+
 #define SNAP_TRACE_STR    "TRACE"
 #define SNAP_VERBOS_STR   "VERBOS"
 #define SNAP_INFO_STR     "INFO"
@@ -68,12 +75,24 @@ class SnapDebug {
   public:
     void init();
     void Log(debug_level_e level, const char *fmt, ...);
+    // Queue a line as is, no formatting
+    void Write(debug_level_e level, const char *text, uint16_t len);
+    // Queue fmt and up to 4 integer args, formatted by the snap_log task.
+    // fmt must be a string constant, %s args are not allowed.
+    void Defer(debug_level_e level, const char *fmt, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0, uint32_t a3 = 0);
+    void drain();
+    uint32_t dropped() { return dropped_; }
     void set_level(debug_level_e l);
     debug_level_e get_level();
     void show_all_status();
 
   private:
+    void flush_frame();
+    void send_dropped();
+
     SemaphoreHandle_t lock = NULL;
+    volatile uint32_t dropped_ = 0;
+    uint32_t dropped_sent_ = 0;
 };
 
 // interface for external use
@@ -88,6 +107,12 @@ extern SnapDebug debug;
 #define LOG_V(...) debug.Log(SNAP_DEBUG_LEVEL_VERBOSE, __VA_ARGS__)
 #define LOG_T(...) debug.Log(SNAP_DEBUG_LEVEL_TRACE, __VA_ARGS__)
 
+// For hot paths and interrupts up to configMAX_SYSCALL_INTERRUPT_PRIORITY:
+// integer args only, formatted later by the snap_log task
+#define LOG_FAST_E(...) debug.Defer(SNAP_DEBUG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_FAST_W(...) debug.Defer(SNAP_DEBUG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_FAST_I(...) debug.Defer(SNAP_DEBUG_LEVEL_INFO, __VA_ARGS__)
+
 #define SNAP_DEBUG_SET_LEVEL(l)        debug.set_level((debug_level_e)(l));
 #define SNAP_DEBUG_IF_LEVEL(l)        (debug.get_level() <= (debug_level_e)(l))
 
@@ -99,6 +124,9 @@ extern SnapDebug debug;
 #define LOG_I(...)
 #define LOG_V(...)
 #define LOG_T(...)
+#define LOG_FAST_E(...)
+#define LOG_FAST_W(...)
+#define LOG_FAST_I(...)
 
 #define SNAP_DEBUG_SHOW_INFO()
 #define SNAP_DEBUG_SHOW_EXCEPTION()
@@ -0,0 +1,133 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "profiler.h"
+#include "MapleFreeRTOS1030.h"
+
+// FreeRTOS run time stats clock for M101. CYCCNT wraps every 35 s at 120 MHz,
+// the context switches that read it come far more often.
+extern "C" void rtos_run_time_init(void) {
+  PROFILE_DEMCR |= 1UL << 24;   // TRCENA
+  PROFILE_DWT_CTRL |= 1;        // CYCCNTENA
+}
+
+extern "C" uint32_t rtos_run_time_counter(void) {
+  static uint32_t last = 0;
+  static uint64_t total = 0;
+  UBaseType_t mask = taskENTER_CRITICAL_FROM_ISR();
+  uint32_t now = PROFILE_DWT_CYCCNT;
+  total += now - last;
+  last = now;
+  uint32_t ret = (uint32_t)(total >> 10);
+  taskEXIT_CRITICAL_FROM_ISR(mask);
+  return ret;
+}
+
+#if ENABLED(HOT_PATH_PROFILER)
+
+#include <string.h>
+#include "debug.h"
+
+profile_stat_t Profiler::stat[PROFILE_COUNT];
+
+static const char *profile_name[PROFILE_COUNT] = {
+  "step_isr",
+  "temp_isr",
+  "shaped_loop",
+  "calc_moves",
+  "gcode_advance",
+  "sacp_parse",
+  "event_loop",
+  "step_produce",
+};
+
+static const char *profile_bucket_name[PROFILE_BUCKETS] = {
+  "<1", "<4", "<16", "<64", "<256", "<1k", "<4k", ">=4k"
+};
+
+void Profiler::clear(profile_stat_t &s) {
+  s.count = 0;
+  s.min = 0;
+  s.max = 0;
+  s.total = 0;
+  memset(s.hist, 0, sizeof(s.hist));
+  s.reset = false;
+}
+
+void Profiler::reset() {
+  for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+    stat[i].reset = true;
+  }
+}
+
+const char *Profiler::name(profile_id_e id) {
+  return id < PROFILE_COUNT ? profile_name[id] : "?";
+}
+
+// Probes run on while we read, take a copy that is at worst one record old
+static void profile_snapshot(uint8_t id, profile_stat_t &s) {
+  s = Profiler::stat[id];
+  if (s.reset) {
+    memset(&s, 0, sizeof(s));
+  }
+}
+
+void Profiler::dump() {
+  const float cycles_per_us = F_CPU / 1000000.0f;
+  LOG_I("probe          count      min us   avg us   max us\n");
+  for (uint8_t i = 0; i < PROFILE_COUNT; i++) {
+    profile_stat_t s;
+    profile_snapshot(i, s);
+    float avg = s.count ? (float)s.total / s.count : 0;
+    LOG_I("%-13s %10u %8.2f %8.2f %8.2f\n", profile_name[i], s.count,
+          s.min / cycles_per_us, avg / cycles_per_us, s.max / cycles_per_us);
+    LOG_I("  ");
+    for (uint8_t b = 0; b < PROFILE_BUCKETS; b++) {
+      LOG_I(" %s:%u", profile_bucket_name[b], s.hist[b]);
+    }
+    LOG_I("\n");
+  }
+}
+
+uint16_t Profiler::report(uint8_t *buf, uint16_t max) {
+  uint16_t n = 0;
+  if (max < 2) {
+    return 0;
+  }
+  buf[n++] = PROFILE_COUNT;
+  buf[n++] = F_CPU / 1000000UL;
+  for (uint8_t i = 0; i < PROFILE_COUNT && n + sizeof(profile_report_t) <= max; i++) {
+    profile_stat_t s;
+    profile_snapshot(i, s);
+    profile_report_t r;
+    r.id = i;
+    r.count = s.count;
+    r.min = s.min;
+    r.avg = s.count ? (uint32_t)(s.total / s.count) : 0;
+    r.max = s.max;
+    memcpy(r.hist, s.hist, sizeof(r.hist));
+    memcpy(&buf[n], &r, sizeof(r));
+    n += sizeof(r);
+  }
+  return n;
+}
+
+#endif  // HOT_PATH_PROFILER
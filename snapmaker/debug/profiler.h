@@ -0,0 +1,133 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SNAPMAKER_PROFILER_H_
+#define SNAPMAKER_PROFILER_H_
+
+/*
+ Hot path cycle profiler, enabled with HOT_PATH_PROFILER.
+
+ A probe point times one run of a code path with the DWT cycle counter,
+ which calibrate_delay_loop() starts at boot:
+
+   PROFILE_SCOPE(PROFILE_STEP_ISR);   // from here to the end of the block
+
+ Each probe keeps count, min, max, total and a histogram of run times in
+ microseconds with the buckets <1, <4, <16, <64, <256, <1024, <4096 and
+ the rest. A probe is updated from one context only, readers take it as
+ is. M2001 dumps the probes, SYS_ID_SUBSCRIBE_PROFILE reports them over
+ SACP.
+*/
+
+#include <stdint.h>
+#include "src/inc/MarlinConfigPre.h"
+
+enum profile_id_e : uint8_t {
+  PROFILE_STEP_ISR,
+  PROFILE_TEMP_ISR,
+  PROFILE_SHAPED_LOOP,
+  PROFILE_CALC_MOVES,
+  PROFILE_GCODE_ADVANCE,
+  PROFILE_SACP_PARSE,
+  PROFILE_EVENT_LOOP,
+  PROFILE_STEP_PRODUCE,
+  PROFILE_COUNT
+};
+
+#define PROFILE_BUCKETS 8
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t total;
+  uint32_t hist[PROFILE_BUCKETS];
+  volatile bool reset;
+} profile_stat_t;
+
+#pragma pack(1)
+// SACP report of one probe, times in cycles of F_CPU
+typedef struct {
+  uint8_t id;
+  uint32_t count;
+  uint32_t min;
+  uint32_t avg;
+  uint32_t max;
+  uint32_t hist[PROFILE_BUCKETS];
+} profile_report_t;
+#pragma pack()
+
+#define PROFILE_DWT_CTRL   (*(volatile uint32_t *)0xE0001000)
+#define PROFILE_DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define PROFILE_DEMCR      (*(volatile uint32_t *)0xE000EDFC)
+
+#if ENABLED(HOT_PATH_PROFILER)
+
+class Profiler {
+  public:
+    static inline uint32_t now() { return PROFILE_DWT_CYCCNT; }
+
+    static inline void record(profile_id_e id, uint32_t cycles) {
+      profile_stat_t &s = stat[id];
+      if (s.reset) {
+        clear(s);
+      }
+      uint32_t us = cycles / (F_CPU / 1000000UL);
+      uint8_t bucket = us ? (33 - __builtin_clz(us)) >> 1 : 0;
+      s.hist[bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1]++;
+      if (!s.count || cycles < s.min) s.min = cycles;
+      if (cycles > s.max) s.max = cycles;
+      s.total += cycles;
+      s.count++;
+    }
+
+    // Cleared by the next record() so the owner of a probe is its only writer
+    static void reset();
+    static void dump();
+    static uint16_t report(uint8_t *buf, uint16_t max);
+    static const char *name(profile_id_e id);
+
+    static profile_stat_t stat[PROFILE_COUNT];
+
+  private:
+    static void clear(profile_stat_t &s);
+};
+
+class ProfileScope {
+  public:
+    ProfileScope(profile_id_e id) : id_(id), start_(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(id_, Profiler::now() - start_); }
+  private:
+    profile_id_e id_;
+    uint32_t start_;
+};
+
+#define _PROFILE_CAT(A, B) A##B
+#define _PROFILE_NAME(L) _PROFILE_CAT(profile_scope_, L)
+#define PROFILE_SCOPE(ID) ProfileScope _PROFILE_NAME(__LINE__)(ID)
+
+#else
+
+#define PROFILE_SCOPE(ID)
+
+#endif
+
+#endif  // SNAPMAKER_PROFILER_H_
@@ -30,12 +30,14 @@
 #include "event_update.h"
 #include "event_exception.h"
 #include "../module/calibtration.h"
+#include "../debug/profiler.h"
 #include "../../../../Marlin/src/MarlinCore.h"
 
 EventHandler event_handler;
 static QueueHandle_t event_queue = NULL;
 static local_event_t local_event = LE_NONE;
 static SemaphoreHandle_t le_event_lock = NULL;
+static TaskHandle_t thandle_event_recv = NULL;
 
 event_cb_info_t * get_event_info(uint8_t cmd_set, uint8_t cmd_id) {
   switch (cmd_set) {
@@ -59,9 +61,8 @@ event_cb_info_t * get_event_info(uint8_t cmd_set, uint8_t cmd_id) {
   return NULL;
 }
 
-void EventHandler::parse_event_info(recv_data_info_t *recv_info, event_cache_node_t *event) {
+void EventHandler::parse_event_info(recv_data_info_t *recv_info, SACP_struct_t *info, event_cache_node_t *event) {
   event_param_t *param = &event->param;
-  SACP_struct_t *info = &recv_info->sacp_params.sacp;
   param->info.attribute = SACP_ATTR_ACK;
   param->info.command_set = info->command_set;
   param->info.command_id = info->command_id;
@@ -71,9 +72,7 @@ void EventHandler::parse_event_info(recv_data_info_t *recv_info, event_cache_nod
   param->length = info->length;
   param->length -= 8;  // Effective data length
   // SERIAL_ECHOLNPAIR("event data len:", param->length);
-  for (uint32_t i = 0; i < param->length; i++) {
-    param->data[i] = info->data[i];
-  }
+  memcpy(param->data, info->data, param->length);
 }
 
 event_cache_node_t * EventHandler::get_event_cache() {
@@ -86,16 +85,16 @@ event_cache_node_t * EventHandler::get_event_cache() {
   return NULL;
 }
 
-ErrCode EventHandler::parse(recv_data_info_t *recv_info) {
+ErrCode EventHandler::parse(recv_data_info_t *recv_info, SACP_struct_t *packet) {
   event_cache_node_t *event = get_event_cache();
   if (!event) {
     SERIAL_ECHO("SNMK_ERROR:event no cache\n");
-    parse_event_info(recv_info, &err_result_event);
+    parse_event_info(recv_info, packet, &err_result_event);
     send_result(err_result_event.param, E_NO_MEM);
     return E_NO_MEM;
   }
 
-  parse_event_info(recv_info, event);
+  parse_event_info(recv_info, packet, event);
   // char debug_buf[60];
   // sprintf(debug_buf, "SC:event cmd_set: 0x%x ,cmd_id:0x%x", event->param.info.command_set, event->param.info.command_id);
   // SERIAL_ECHOLN(debug_buf);
@@ -150,7 +149,10 @@ void EventHandler::loop_task() {
     if (xQueueReceive(event_queue, &event, 1 ) == pdPASS) {
       if (event->block_status == EVENT_CACHT_STATUS_WAIT) {
         event->block_status = EVENT_CACHT_STATUS_BUSY;
-        (event->cb)(event->param);
+        {
+          PROFILE_SCOPE(PROFILE_EVENT_LOOP);
+          (event->cb)(event->param);
+        }
         event->block_status = EVENT_CACHT_STATUS_IDLE;
       }
     }
@@ -160,10 +162,24 @@ void EventHandler::loop_task() {
   }
 }
 
+static void event_recv_notify() {
+  BaseType_t woken = pdFALSE;
+  if (thandle_event_recv) {
+    vTaskNotifyGiveFromISR(thandle_event_recv, &woken);
+    portYIELD_FROM_ISR(woken);
+  }
+}
+
+// recv_drain() reads the RX buffer in place, it only runs on a port while
+// rx_notify is attached, which keeps the IRQ from overwriting unread bytes
 void EventHandler::recv_enable(event_source_e source, bool enable) {
-  event_serial[source]->enable_sacp(enable);
   if (enable) {
     event_serial[source]->begin(115200);
+    event_serial[source]->attach_rx_notify(event_recv_notify);
+    event_serial[source]->enable_sacp(true);
+  } else {
+    event_serial[source]->enable_sacp(false);
+    event_serial[source]->attach_rx_notify(NULL);
   }
 }
 
@@ -171,27 +187,39 @@ void EventHandler::recv_enable(event_source_e source) {
   recv_enable(source, true);
 }
 
+// Frame packets straight out of the serial RX buffer, a run of bytes at a time
+void EventHandler::recv_drain(event_source_e source) {
+  recv_data_info_t *recv_info = &recv_data_info[source];
+  uint8_t *data;
+  uint16_t len;
+  while ((len = event_serial[source]->read_span(&data)) > 0) {
+    uint16_t offset = 0;
+    while (offset < len) {
+      uint16_t used;
+      SACP_struct_t *packet;
+      ErrCode ret;
+      {
+        PROFILE_SCOPE(PROFILE_SACP_PARSE);
+        ret = protocol_sacp.parse(data + offset, len - offset, recv_info->sacp_params, used, packet);
+      }
+      offset += used;
+      if (ret == E_SUCCESS) {
+        recv_info->recv_source = source;
+        event_handler.parse(recv_info, packet);
+      }
+    }
+    event_serial[source]->read_skip(len);
+  }
+}
+
 void EventHandler::recv_task() {
-  recv_data_info_t *recv_info;
   while (true) {
-    bool need_wait = true;
     for (uint8_t i = 0; i < EVENT_SOURCE_ALL; i++) {
-      recv_info = &recv_data_info[i];
       if (event_serial[i]->enable_sacp()) {
-        int ch = event_read_byte[i]();
-        if (ch != -1) {
-          uint8_t data = ch&0xFF;
-          if (protocol_sacp.parse(&data, 1, recv_info->sacp_params) == E_SUCCESS) {
-            recv_info->recv_source = (event_source_e)i;
-            event_handler.parse(recv_info);
-          }
-          need_wait = false;
-        }
+        recv_drain((event_source_e)i);
       }
     }
-    if (need_wait) {
-      vTaskDelay(pdMS_TO_TICKS(5));
-    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(EVENT_RECV_WAIT_MS));
   }
 }
 
@@ -222,7 +250,6 @@ void event_init() {
   }
 
 
-  TaskHandle_t thandle_event_recv;
   ret = xTaskCreate(event_recv_task, "event_recv_task", 1024, NULL, 5, &thandle_event_recv);
   if (ret != pdPASS) {
     SERIAL_ECHO("Failed to create event_recv_task!\n");
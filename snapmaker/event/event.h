@@ -26,6 +26,8 @@
 #include "../protocol/protocol_sacp.h"
 
 #define EVENT_CACHE_COUNT 6
+// The RX interrupt wakes the receive task, the timeout only covers a lost wakeup
+#define EVENT_RECV_WAIT_MS 100
 
 typedef enum {
   EVENT_CACHT_STATUS_IDLE,
@@ -60,8 +62,9 @@ class EventHandler {
     void recv_enable(event_source_e source);
 
   private:
-    ErrCode parse(recv_data_info_t *recv_info);
-    void parse_event_info(recv_data_info_t *recv_info, event_cache_node_t *event);
+    void recv_drain(event_source_e source);
+    ErrCode parse(recv_data_info_t *recv_info, SACP_struct_t *packet);
+    void parse_event_info(recv_data_info_t *recv_info, SACP_struct_t *packet, event_cache_node_t *event);
     event_cache_node_t * get_event_cache();
 
   private:
@@ -19,6 +19,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
 #include "event_base.h"
 #include "../protocol/protocol_sacp.h"
 
@@ -54,7 +55,15 @@ event_cb_info_t * get_evevt_info_by_id(uint8_t id, event_cb_info_t *array, uint8
 }
 
 
-static bool send_to(event_source_e source, uint8_t *data, uint16_t len) {
+// Frames sent by the batching task collect here and go out in one write
+// when the source changes, the buffer fills up or the batch ends. Only one
+// task batches, so it has the one buffer.
+static TaskHandle_t batch_owner = NULL;
+static uint8_t batch_buf[EVENT_BATCH_SIZE];
+static uint16_t batch_len = 0;
+static event_source_e batch_source = EVENT_SOURCE_MARLIN;
+
+static bool write_to(event_source_e source, uint8_t *data, uint16_t len) {
   if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
     if (xSemaphoreTake(event_write_lock[source], portMAX_DELAY) == pdPASS) {
       for (int i = 0; i < len; i++) {
@@ -76,6 +85,35 @@ static bool send_to(event_source_e source, uint8_t *data, uint16_t len) {
   }
 }
 
+static void batch_flush() {
+  if (batch_len) {
+    write_to(batch_source, batch_buf, batch_len);
+    batch_len = 0;
+  }
+}
+
+static bool send_to(event_source_e source, uint8_t *data, uint16_t len) {
+  if (batch_owner && batch_owner == xTaskGetCurrentTaskHandle() && len <= EVENT_BATCH_SIZE) {
+    if (source != batch_source || batch_len + len > EVENT_BATCH_SIZE) {
+      batch_flush();
+      batch_source = source;
+    }
+    memcpy(&batch_buf[batch_len], data, len);
+    batch_len += len;
+    return true;
+  }
+  return write_to(source, data, len);
+}
+
+void send_batch_begin() {
+  batch_owner = xTaskGetCurrentTaskHandle();
+}
+
+void send_batch_end() {
+  batch_owner = NULL;
+  batch_flush();
+}
+
 bool send_data(event_source_e source, uint8_t *data, uint16_t len) {
   if (source == EVENT_SOURCE_ALL) {
     for (uint8_t s = 0; s < EVENT_SOURCE_ALL; s++) {
@@ -51,6 +51,8 @@ typedef std::function<int(void)> read_byte_f;
 #define COMMAND_SET_UPDATE 0xAD
 
 #define STR_PACK_TOO_LARGE  ("sacp packet is large than PACK_PARSE_MAX_SIZE\r\n")
+// Bytes a batch holds before it is written out, one SACP frame
+#define EVENT_BATCH_SIZE PACK_PARSE_MAX_SIZE
 
 // Event Source
 typedef enum {
@@ -107,4 +109,8 @@ ErrCode send_event(event_source_e source, uint8_t recever_id, uint8_t attribute,
 ErrCode send_result(event_param_t &event, ErrCode result);
 ErrCode write_fun_register(event_source_e source, write_byte_f cb);
 bool send_data(event_source_e source, uint8_t *data, uint16_t len);
+// Hold back the frames this task sends and write them together at the end,
+// only one task batches at a time
+void send_batch_begin();
+void send_batch_end();
 #endif // EVENT_BASE_H
@@ -73,6 +73,15 @@ typedef struct {
   uint8_t extruder_count;  // 1
   z_offet_info_t info;
 } sc_get_z_offet_t;
+
+typedef struct {
+  uint8_t extruder_index;
+  uint8_t axis;
+  uint8_t dir;
+  uint8_t samples;
+  uint8_t converged;
+  float_to_int_t spread;
+} probe_quality_info_t;
 #pragma pack()
 
 
@@ -103,6 +112,9 @@ static ErrCode calibtration_set_mode(event_param_t& event) {
         LOG_E("can NOT set to SYSTEM_STATUE_CAlIBRATION\r\n");
         event.data[0] = E_COMMON_ERROR;
       }
+      else {
+        calibtration.reset_probe_quality();
+      }
     }
   }
   event.length = 1;
@@ -224,6 +236,40 @@ static ErrCode calibtration_report_xy_offset(event_param_t& event) {
   return send_event(event);
 }
 
+static_assert(2 + PROBE_QUALITY_POINTS * sizeof(probe_quality_info_t) <= PACK_PARSE_MAX_SIZE,
+              "probe quality report does not fit in a frame");
+
+// One entry per probed point of the calibration, in probing order
+static ErrCode calibtration_report_probe_quality(event_param_t& event) {
+  uint8_t count = calibtration.get_probe_quality_count();
+  probe_quality_info_t * info = (probe_quality_info_t *)(event.data + 2);
+  event.data[0] = E_SUCCESS;
+  event.data[1] = count;
+  for (uint8_t i = 0; i < count; i++) {
+    const probe_quality_t &quality = calibtration.get_probe_quality(i);
+    info[i].extruder_index = quality.extruder;
+    info[i].axis = quality.axis;
+    info[i].dir = quality.dir;
+    info[i].samples = quality.samples;
+    info[i].converged = quality.converged;
+    info[i].spread = FLOAT_TO_INT(quality.spread);
+  }
+  event.length = 2 + sizeof(probe_quality_info_t) * count;
+  return send_event(event);
+}
+
+static ErrCode calibtration_set_probe_tolerance(event_param_t& event) {
+  if (event.length < sizeof(float_to_int_t)) {
+    event.data[0] = E_PARAM;
+  } else {
+    float_to_int_t tolerance = *(float_to_int_t *)event.data;
+    LOG_V("sc set probe tolerance:%d\n", tolerance);
+    event.data[0] = calibtration.set_probe_tolerance(INT_TO_FLOAT(tolerance));
+  }
+  event.length = 1;
+  return send_event(event);
+}
+
 static ErrCode calibtration_set_z_offset(event_param_t& event) {
   sc_set_z_offet_t * info = (sc_set_z_offet_t *)event.data;
   float offset = -INT_TO_FLOAT(info->info.offset);
@@ -332,6 +378,8 @@ event_cb_info_t calibtration_cb_info[CAlIBRATION_ID_CB_COUNT] = {
   {CAlIBRATION_ID_START_XY         , EVENT_CB_TASK_RUN,     calibtration_start_xy},
   {CAlIBRATION_ID_SET_XY_OFFSET    , EVENT_CB_TASK_RUN,     calibtration_set_xy_offset},
   {CAlIBRATION_ID_REPORT_XY_OFFSET , EVENT_CB_DIRECT_RUN,   calibtration_report_xy_offset},
+  {CAlIBRATION_ID_REPORT_PROBE_QUALITY , EVENT_CB_DIRECT_RUN, calibtration_report_probe_quality},
+  {CAlIBRATION_ID_SET_PROBE_TOLERANCE , EVENT_CB_TASK_RUN,  calibtration_set_probe_tolerance},
   {CAlIBRATION_ID_SUBSCRIBE_Z_OFFSET , EVENT_CB_DIRECT_RUN, calibtration_get_z_offset},
   {CAlIBRATION_ID_START_PID_AUTOTUNE , EVENT_CB_TASK_RUN,   calibtration_start_pid_autotune},
 };
@@ -35,6 +35,12 @@
 #define GCODE_REQ_TIMEOUT_MS    (200)
 #define GCODE_TIMEOUT_MAX_CNT   (8)  // 25.6 second
 
+// Sliding window for PRINTER_ID_REQ_GCODE_RANGE, window size 1 keeps the stop-and-wait protocol
+#define GCODE_REQ_WINDOW_MAX    (3)
+#define GCODE_RANGE_MIN_LINES   (4)
+#define GCODE_RANGE_MAX_LINES   (96)
+#define GCODE_LINE_LEN_DEFAULT  (24)
+
 #pragma pack(1)
 
 typedef struct {
@@ -49,6 +55,12 @@ typedef struct {
   uint16_t buf_max_size;
 } batch_gcode_req_info_t;
 
+typedef struct {
+  uint32_t start_line;
+  uint16_t line_count;
+  uint16_t buf_max_size;
+} batch_gcode_range_req_info_t;
+
 typedef struct {
   uint8_t flag;
   uint32_t start_line;
@@ -78,6 +90,33 @@ typedef enum {
   GCODE_PACK_REQ_DONE,
 } gcode_req_status_e;
 
+typedef struct {
+  gcode_req_status_e status;  // IDLE: free, WAIT_RECV: in flight, DONE: received out of order
+  uint32_t start_line;
+  uint32_t end_line;
+  uint32_t timeout;
+  uint8_t flag;
+  uint16_t data_len;
+  uint8_t data[GCODE_MAX_PACK_SIZE];
+} gcode_window_slot_t;
+
+typedef struct {
+  uint8_t size;
+  uint8_t head;  // index of the oldest outstanding slot
+  uint8_t count;
+  bool eof;
+  uint32_t next_line;  // first line not covered by any slot
+  uint16_t line_len;  // estimated bytes per line, used to size the line ranges
+  gcode_window_slot_t slot[GCODE_REQ_WINDOW_MAX];
+} gcode_window_t;
+
+typedef struct {
+  uint32_t start_ms;
+  uint32_t lines;
+  uint32_t packs;
+  uint32_t resend;
+} gcode_stream_stat_t;
+
 typedef enum {
   STATUS_PRINT_DONE,
   STATUS_PAUSE_BE_GCODE,
@@ -101,12 +140,18 @@ uint32_t gcode_req_timeout = 0;
 uint32_t gcode_req_timeout_times = 0;
 uint32_t gcode_req_base_wait_ms = 0;
 
+static gcode_window_t gcode_window;
+static gcode_stream_stat_t gcode_stream_stat;
+static SemaphoreHandle_t gcode_window_lock = NULL;
+
 bool start_pause_record = false;
 uint32_t start_pause_time_ms = 0;
 bool pause_hotend_tmp_down = 0;
 
 
 static void req_gcode_pack();
+static void gcode_stream_stat_log();
+static ErrCode gcode_window_pack_deal(batch_gcode_t *gcode);
 static void report_status_info(ErrCode status);
 static void save_event_suorce_info(event_param_t& event, bool update_get_gcode_info=false);
 
@@ -164,9 +209,14 @@ static ErrCode gcode_pack_deal(event_param_t& event) {
   ErrCode ret;
   batch_gcode_t *gcode = (batch_gcode_t *)event.data;
   ret = print_control.push_gcode(gcode->start_line, gcode->end_line, gcode->data, gcode->data_len);
+  if (E_SUCCESS == ret) {
+    gcode_stream_stat.lines += gcode->end_line - gcode->start_line + 1;
+    gcode_stream_stat.packs++;
+  }
   if (gcode->flag == PRINT_RESULT_GCODE_RECV_DONE_E) {
     gcode_req_status = GCODE_PACK_REQ_DONE;
     SERIAL_ECHOLN("SC gcoce pack recv done");
+    gcode_stream_stat_log();
   } else {
     if (E_SUCCESS == ret) {
       if (gcode_req_timeout_times) gcode_req_timeout_times--;
@@ -177,10 +227,31 @@ static ErrCode gcode_pack_deal(event_param_t& event) {
   return E_SUCCESS;
 }
 
+static ErrCode gcode_range_pack_deal(event_param_t& event) {
+  return gcode_window_pack_deal((batch_gcode_t *)event.data);
+}
+
+static ErrCode set_gcode_window(event_param_t& event) {
+  uint8_t size = event.data[0];
+  if (system_service.is_working() || size < 1 || size > GCODE_REQ_WINDOW_MAX) {
+    event.data[0] = E_PARAM;
+  } else {
+    gcode_window.size = size;
+    event.data[0] = E_SUCCESS;
+  }
+  LOG_I("SC set gcode window:%d, ret:%d\n", gcode_window.size, event.data[0]);
+  event.data[1] = gcode_window.size;
+  event.length = 2;
+  return send_event(event);
+}
+
 static ErrCode request_start_work(event_param_t& event) {
   SERIAL_ECHOLNPAIR("SC req start work");
   ErrCode result= print_control.start();
   SERIAL_ECHOLNPAIR("start work result:", result);
+  // An optional format byte after the file name asks for binary gcode packs
+  bool format_req = false;
+  gcode_format_e format = GCODE_FORMAT_TEXT;
   if (result == E_SUCCESS) {
     // set md5 and file name
     uint16_t data_len = *((uint16_t *)event.data);
@@ -189,15 +260,32 @@ static ErrCode request_start_work(event_param_t& event) {
     data = event.data + data_len + 4;
     data_len = *((uint16_t *)&event.data[data_len + 2]);
     power_loss.set_file_name(data, data_len);
+    power_loss.start_job();
+
+    uint16_t format_offset = (data - event.data) + data_len;
+    if (event.length > format_offset) {
+      format_req = true;
+      if (event.data[format_offset] == GCODE_FORMAT_BINARY) {
+        format = GCODE_FORMAT_BINARY;
+      }
+    }
+    print_control.set_gcode_format(format);
+    SERIAL_ECHOLNPAIR("gcode format:", format);
 
     save_event_suorce_info(event, true);
   }
   event.data[0] = result;
   event.length = 1;
+  if (format_req) {
+    event.data[1] = format;
+    event.length = 2;
+  }
   send_event(event);
   if (result == E_SUCCESS) {
     gcode_req_timeout_times = 0;
     gcode_req_base_wait_ms = 2000;
+    memset(&gcode_stream_stat, 0, sizeof(gcode_stream_stat));
+    gcode_stream_stat.start_ms = millis();
     req_gcode_pack();
   }
   return result;
@@ -294,6 +382,8 @@ static ErrCode request_power_loss_status(event_param_t& event) {
 
 static ErrCode request_power_loss_resume(event_param_t& event) {
   SERIAL_ECHOLNPAIR("SC req power loss resume");
+  // Resume does not negotiate the pack format
+  print_control.set_gcode_format(GCODE_FORMAT_TEXT);
   ErrCode ret = power_loss.power_loss_resume();
   event.data[0] = E_SUCCESS;
   event.length = 1;
@@ -537,6 +627,8 @@ event_cb_info_t printer_cb_info[PRINTER_ID_CB_COUNT] = {
   {PRINTER_ID_GET_FDM_ENABLE          , EVENT_CB_DIRECT_RUN, get_fdm_enable},
   {PRINTER_ID_SET_NOISE_MODE          , EVENT_CB_DIRECT_RUN, set_noise_mode},
   {PRINTER_ID_GET_NOISE_MODE          , EVENT_CB_DIRECT_RUN, get_noise_mode},
+  {PRINTER_ID_SET_GCODE_WINDOW        , EVENT_CB_DIRECT_RUN, set_gcode_window},
+  {PRINTER_ID_REQ_GCODE_RANGE         , EVENT_CB_TASK_RUN,   gcode_range_pack_deal},
   {PRINTER_ID_REQ_LINE                , EVENT_CB_DIRECT_RUN, request_cur_line},
   {PRINTER_ID_SUBSCRIBE_PRINT_MODE    , EVENT_CB_DIRECT_RUN, subscribe_print_mode},
   {PRINTER_ID_GET_WORK_FEEDRATE       , EVENT_CB_DIRECT_RUN, get_work_feedrate},
@@ -545,7 +637,207 @@ event_cb_info_t printer_cb_info[PRINTER_ID_CB_COUNT] = {
   {PRINTER_ID_SUBSCRIBE_WORK_TIME    , EVENT_CB_DIRECT_RUN, subscribe_work_time},
 };
 
+static void gcode_stream_stat_log() {
+  uint32_t ms = millis() - gcode_stream_stat.start_ms;
+  LOG_I("gcode stream: %u lines, %u packs, %u resend in %u ms, %u lines/s, window %d\n",
+        gcode_stream_stat.lines, gcode_stream_stat.packs, gcode_stream_stat.resend, ms,
+        ms ? (uint32_t)((uint64_t)gcode_stream_stat.lines * 1000 / ms) : 0, gcode_window.size);
+}
+
+static gcode_window_slot_t *gcode_window_slot(uint8_t index) {
+  return &gcode_window.slot[(gcode_window.head + index) % GCODE_REQ_WINDOW_MAX];
+}
+
+static void gcode_window_send_req(gcode_window_slot_t *slot) {
+  batch_gcode_range_req_info_t info;
+  info.start_line = slot->start_line;
+  info.line_count = slot->end_line - slot->start_line + 1;
+  info.buf_max_size = GCODE_MAX_PACK_SIZE;
+  send_event(rep_gcode_source, rep_gcode_recever_id, SACP_ATTR_REQ,
+      COMMAND_SET_PRINTER, PRINTER_ID_REQ_GCODE_RANGE, (uint8_t *)&info, sizeof(info));
+  slot->status = GCODE_PACK_REQ_WAIT_RECV;
+  slot->timeout = millis() + (GCODE_REQ_TIMEOUT_MS<<gcode_req_timeout_times) + gcode_req_base_wait_ms;
+  LOG_V("gcode range requst line:%u-%u\n", slot->start_line, slot->end_line);
+}
+
+static void gcode_window_update_status() {
+  if (gcode_window.count) {
+    gcode_req_status = GCODE_PACK_REQ_WAIT_RECV;
+  } else if (gcode_window.eof) {
+    gcode_req_status = GCODE_PACK_REQ_DONE;
+  } else {
+    gcode_req_status = GCODE_PACK_REQ_WAIT_CACHE;
+  }
+}
+
+// Issue range requests until the window is full or the gcode buffer
+// can not hold every outstanding pack
+static void gcode_window_fill() {
+  while (!gcode_window.eof && gcode_window.count < gcode_window.size) {
+    if (print_control.get_buf_free() < (uint32_t)(gcode_window.count + 1) * GCODE_MAX_PACK_SIZE) {
+      break;
+    }
+    uint32_t lines = GCODE_MAX_PACK_SIZE / gcode_window.line_len;
+    LIMIT(lines, GCODE_RANGE_MIN_LINES, GCODE_RANGE_MAX_LINES);
+    gcode_window_slot_t *slot = gcode_window_slot(gcode_window.count++);
+    slot->start_line = gcode_window.next_line;
+    slot->end_line = gcode_window.next_line + lines - 1;
+    slot->data_len = 0;
+    gcode_window.next_line = slot->end_line + 1;
+    gcode_window_send_req(slot);
+  }
+  gcode_window_update_status();
+}
+
+static void gcode_window_reset() {
+  for (auto &slot : gcode_window.slot) {
+    slot.status = GCODE_PACK_REQ_IDLE;
+  }
+  gcode_window.head = gcode_window.count = 0;
+  gcode_window.eof = false;
+  gcode_window.next_line = print_control.next_req_line();
+  if (!gcode_window.line_len) {
+    gcode_window.line_len = GCODE_LINE_LEN_DEFAULT;
+  }
+}
+
+// Forget every slot after index, their ranges are requested again by gcode_window_fill()
+static void gcode_window_drop_after(uint8_t index) {
+  for (uint8_t i = index + 1; i < gcode_window.count; i++) {
+    gcode_window_slot(i)->status = GCODE_PACK_REQ_IDLE;
+  }
+  gcode_window.count = index + 1;
+  gcode_window.next_line = gcode_window_slot(index)->end_line + 1;
+}
+
+static bool gcode_window_push(gcode_window_slot_t *slot, uint8_t *data) {
+  ErrCode ret = E_SUCCESS;
+  if (slot->data_len) {
+    ret = print_control.push_gcode(slot->start_line, slot->end_line, data, slot->data_len);
+  }
+  if (ret == E_SUCCESS) {
+    if (slot->data_len) {
+      gcode_stream_stat.lines += slot->end_line - slot->start_line + 1;
+    }
+    gcode_stream_stat.packs++;
+  }
+  slot->status = GCODE_PACK_REQ_IDLE;
+  gcode_window.head = (gcode_window.head + 1) % GCODE_REQ_WINDOW_MAX;
+  gcode_window.count--;
+  if (slot->flag == PRINT_RESULT_GCODE_RECV_DONE_E) {
+    SERIAL_ECHOLN("SC gcoce pack recv done");
+    gcode_stream_stat_log();
+    return true;
+  }
+  if (ret != E_SUCCESS) {
+    // Go back to the line the buffer expects and request everything again
+    LOG_E("gcode window push failed at line:%u\n", slot->start_line);
+    gcode_window_reset();
+    return false;
+  }
+  return true;
+}
+
+static ErrCode gcode_window_pack_deal(batch_gcode_t *gcode) {
+  if (gcode_req_status == GCODE_PACK_REQ_IDLE || gcode_window.size <= 1) {
+    return E_SUCCESS;
+  }
+  xSemaphoreTake(gcode_window_lock, portMAX_DELAY);
+
+  uint8_t index = 0;
+  gcode_window_slot_t *slot = NULL;
+  for (; index < gcode_window.count; index++) {
+    slot = gcode_window_slot(index);
+    if (slot->status == GCODE_PACK_REQ_WAIT_RECV && slot->start_line == gcode->start_line) {
+      break;
+    }
+  }
+
+  // Only the last pack may be empty, its end_line is then start_line - 1
+  bool is_done = gcode->flag == PRINT_RESULT_GCODE_RECV_DONE_E;
+  uint32_t lines = gcode->end_line + 1 - gcode->start_line;
+  if (index == gcode_window.count || gcode->data_len > GCODE_MAX_PACK_SIZE ||
+      lines > slot->end_line + 1 - slot->start_line || (!is_done && !lines)) {
+    // Answer of a dropped or resent range
+    LOG_V("drop gcode pack line:%u-%u\n", gcode->start_line, gcode->end_line);
+    xSemaphoreGive(gcode_window_lock);
+    return E_SUCCESS;
+  }
+
+  if (gcode_req_timeout_times) gcode_req_timeout_times--;
+  gcode_req_base_wait_ms = 0;
+
+  slot->flag = gcode->flag;
+  slot->data_len = gcode->data_len;
+  if (gcode->data_len && lines) {
+    uint32_t line_len = (gcode->data_len + lines / 2) / lines;
+    gcode_window.line_len = (gcode_window.line_len * 3 + line_len + 2) / 4;
+    NOLESS(gcode_window.line_len, 1);
+  }
+  if (is_done) {
+    slot->end_line = gcode->end_line;
+    gcode_window.eof = true;
+    gcode_window_drop_after(index);
+  } else if (gcode->end_line < slot->end_line) {
+    // HMI cut the range to fit buf_max_size, the tail has to be requested again
+    slot->end_line = gcode->end_line;
+    gcode_stream_stat.resend += gcode_window.count - index - 1;
+    gcode_window_drop_after(index);
+  }
+
+  bool ok = true;
+  if (index == 0) {
+    ok = gcode_window_push(slot, gcode->data);
+  } else {
+    memcpy(slot->data, gcode->data, gcode->data_len);
+    slot->status = GCODE_PACK_REQ_DONE;
+  }
+  while (ok && gcode_window.count && gcode_window_slot(0)->status == GCODE_PACK_REQ_DONE) {
+    slot = gcode_window_slot(0);
+    ok = gcode_window_push(slot, slot->data);
+  }
+
+  gcode_window_fill();
+  xSemaphoreGive(gcode_window_lock);
+  return E_SUCCESS;
+}
+
+static void gcode_window_status_deal() {
+  xSemaphoreTake(gcode_window_lock, portMAX_DELAY);
+  if (gcode_req_status == GCODE_PACK_REQ_WAIT_CACHE) {
+    gcode_window_fill();
+  } else if (gcode_req_status == GCODE_PACK_REQ_WAIT_RECV) {
+    for (uint8_t i = 0; i < gcode_window.count; i++) {
+      gcode_window_slot_t *slot = gcode_window_slot(i);
+      if (slot->status != GCODE_PACK_REQ_WAIT_RECV || PENDING(millis(), slot->timeout)) {
+        continue;
+      }
+      extern uint32_t statistics_gcode_timeout_cnt;
+      statistics_gcode_timeout_cnt++;
+      LOG_E("requst gcode range %u-%u timeout!\n", slot->start_line, slot->end_line);
+      gcode_req_timeout_times++;
+      if (gcode_req_timeout_times > GCODE_TIMEOUT_MAX_CNT) {
+        xSemaphoreGive(gcode_window_lock);
+        print_control.error_and_stop();
+        return;
+      }
+      gcode_stream_stat.resend++;
+      gcode_window_send_req(slot);
+    }
+  }
+  xSemaphoreGive(gcode_window_lock);
+}
+
 static void req_gcode_pack() {
+  if (gcode_window.size > 1) {
+    // Every caller restarts the stream from print_control.next_req_line()
+    xSemaphoreTake(gcode_window_lock, portMAX_DELAY);
+    gcode_window_reset();
+    gcode_window_fill();
+    xSemaphoreGive(gcode_window_lock);
+    return;
+  }
+
   batch_gcode_req_info_t info;
   uint16_t free_buf = print_control.get_buf_free();
   // SERIAL_ECHOLNPAIR("gcode buf free:", free_buf);
@@ -651,6 +943,9 @@ void pausing_status_deal() {
 }
 
 void printer_event_init(void) {
+  gcode_window.size = 1;
+  gcode_window_lock = xSemaphoreCreateMutex();
+  configASSERT(gcode_window_lock);
   filament_sensor.init();
   power_loss.init();
 }
@@ -662,10 +957,16 @@ void printing_status_deal() {
 
   switch (gcode_req_status) {
     case GCODE_PACK_REQ_WAIT_CACHE:
-      req_gcode_pack();
+      if (gcode_window.size > 1)
+        gcode_window_status_deal();
+      else
+        req_gcode_pack();
       break;
     case GCODE_PACK_REQ_WAIT_RECV:
-      gcode_req_timeout_deal();
+      if (gcode_window.size > 1)
+        gcode_window_status_deal();
+      else
+        gcode_req_timeout_deal();
       break;
     case GCODE_PACK_REQ_DONE:
       wait_print_end();
@@ -29,11 +29,14 @@
 #include "../module/enclosure.h"
 #include "event.h"
 #include "../debug/debug.h"
+#include "../debug/profiler.h"
 #include "src/module/settings.h"
 #include "../../../src/module/AxisManager.h"
 #include "../module/print_control.h"
 #include "../module/factory_data.h"
 #include "../module/calibtration.h"
+#include "../module/inactive_x.h"
+#include "../module/driver_load.h"
 
 
 #pragma pack(1)
@@ -215,6 +218,27 @@ static ErrCode move_relative_home(event_param_t& event) {
   return send_event(event);
 }
 
+#pragma pack(1)
+typedef struct {
+  float_to_int_t x;
+  float_to_int_t speed;  // mm/s, 0 for the default
+  float_to_int_t accel;  // mm/s^2, 0 for the default
+} inactive_x_move_info_t;
+#pragma pack()
+
+static ErrCode move_inactive_x(event_param_t& event) {
+  inactive_x_move_info_t *info = (inactive_x_move_info_t *)event.data;
+  if (event.length < sizeof(inactive_x_move_info_t)) {
+    event.data[0] = E_PARAM;
+  } else {
+    float speed = info->speed > 0 ? INT_TO_FLOAT(info->speed) : INACTIVE_X_SPEED_DEFAULT;
+    float accel = info->accel > 0 ? INT_TO_FLOAT(info->accel) : INACTIVE_X_ACCEL_DEFAULT;
+    SERIAL_ECHOLNPAIR("SC move inactive x to ", INT_TO_FLOAT(info->x), " F:", speed);
+    event.data[0] = inactive_x.move_to(INT_TO_FLOAT(info->x), speed, accel);
+  }
+  event.length = 1;
+  return send_event(event);
+}
 
 #define DEFAULT_IS_TYPE  (1) //EI
 #define DEFAULT_IS_DAMP  (0.1)
@@ -471,6 +495,25 @@ static ErrCode set_motor_enable(event_param_t& event) {
   return send_event(event);
 }
 
+// E_SUCCESS, probe count, MHz, then a profile_report_t per probe
+static ErrCode get_profile(event_param_t& event) {
+  #if ENABLED(HOT_PATH_PROFILER)
+    event.data[0] = E_SUCCESS;
+    event.length = Profiler::report(event.data + 1, sizeof(event.data) - 1) + 1;
+  #else
+    event.data[0] = E_NO_RESRC;
+    event.length = 1;
+  #endif
+  return send_event(event);
+}
+
+static ErrCode get_driver_load(event_param_t& event) {
+  driver_load_info_t *info = (driver_load_info_t *)(event.data + 2);
+  event.data[0] = E_SUCCESS;
+  event.data[1] = driver_load.report(info);
+  event.length = sizeof(driver_load_info_t) * event.data[1] + 2;
+  return send_event(event);
+}
 
 event_cb_info_t system_cb_info[SYS_ID_CB_COUNT] = {
   {SYS_ID_SUBSCRIBE             ,         EVENT_CB_DIRECT_RUN,    subscribe_event},
@@ -495,6 +538,7 @@ event_cb_info_t system_cb_info[SYS_ID_CB_COUNT] = {
   {SYS_ID_GET_MOTOR_ENABLE      ,         EVENT_CB_DIRECT_RUN,    get_motor_enable},
   {SYS_ID_SET_MOTOR_ENABLE      ,         EVENT_CB_DIRECT_RUN,    set_motor_enable},
   {SYS_ID_MOVE_TO_RELATIVE_HOME ,         EVENT_CB_TASK_RUN  ,    move_relative_home},
+  {SYS_ID_MOVE_INACTIVE_X       ,         EVENT_CB_DIRECT_RUN,    move_inactive_x},
 
   {SYS_ID_INPUTSHAPER_SET ,               EVENT_CB_TASK_RUN,      inputshaper_set},
   {SYS_ID_INPUTSHAPER_GET ,               EVENT_CB_TASK_RUN,      inputshaper_get},
@@ -506,4 +550,6 @@ event_cb_info_t system_cb_info[SYS_ID_CB_COUNT] = {
   {SYS_ID_GET_BUILD_PLATE_TKNESS ,        EVENT_CB_TASK_RUN,      get_build_plate_thickness},
   {SYS_ID_GET_DISTANCE_RELATIVE_HOME ,    EVENT_CB_TASK_RUN,      req_distance_relative_home},
   {SYS_ID_SUBSCRIBE_MOTOR_ENABLE_STATUS , EVENT_CB_DIRECT_RUN,    get_motor_enable},
+  {SYS_ID_SUBSCRIBE_PROFILE ,             EVENT_CB_DIRECT_RUN,    get_profile},
+  {SYS_ID_SUBSCRIBE_DRIVER_LOAD ,         EVENT_CB_DIRECT_RUN,    get_driver_load},
 };
\ No newline at end of file
@@ -47,6 +47,7 @@ enum : uint8_t {
   SYS_ID_GET_MOTOR_ENABLE               = 0x37,
   SYS_ID_SET_MOTOR_ENABLE               = 0x38,
   SYS_ID_MOVE_TO_RELATIVE_HOME          = 0x3C,
+  SYS_ID_MOVE_INACTIVE_X                = 0x3D,
   SYS_ID_INPUTSHAPER_SET                = 0x3E,
   SYS_ID_INPUTSHAPER_GET                = 0x3F,
   SYS_ID_RESONANCE_COMPENSATION_SET     = 0x40,
@@ -57,9 +58,11 @@ enum : uint8_t {
   SYS_ID_GET_BUILD_PLATE_TKNESS         = 0x45,
   SYS_ID_GET_DISTANCE_RELATIVE_HOME     = 0xA3,
   SYS_ID_SUBSCRIBE_MOTOR_ENABLE_STATUS  = 0xA4,
+  SYS_ID_SUBSCRIBE_PROFILE              = 0xA5,
+  SYS_ID_SUBSCRIBE_DRIVER_LOAD          = 0xA6,
 };
 
-#define SYS_ID_CB_COUNT 33
+#define SYS_ID_CB_COUNT 36
 
 extern event_cb_info_t system_cb_info[SYS_ID_CB_COUNT];
 
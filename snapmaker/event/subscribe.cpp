@@ -35,6 +35,93 @@ extern event_cb_info_t * get_event_info(uint8_t cmd_set, uint8_t cmd_id);
 
 static event_param_t event_public_param;
 
+void Subscribe::init() {
+  for (uint8_t i = 0; i < MAX_SUBSCRIBE_COUNT; i++) {
+    heap_pos[i] = SUBSCRIBE_HEAP_NONE;
+  }
+  heap_size = 0;
+  heap_lock = xSemaphoreCreateMutex();
+  configASSERT(heap_lock);
+}
+
+void Subscribe::lock() {
+  if (heap_lock) {
+    xSemaphoreTake(heap_lock, portMAX_DELAY);
+  }
+}
+
+void Subscribe::unlock() {
+  if (heap_lock) {
+    xSemaphoreGive(heap_lock);
+  }
+}
+
+bool Subscribe::before(uint8_t a, uint8_t b) {
+  return (int32_t)(sub[a].deadline - sub[b].deadline) < 0;
+}
+
+void Subscribe::heap_swap(uint8_t i, uint8_t j) {
+  uint8_t tmp = heap[i];
+  heap[i] = heap[j];
+  heap[j] = tmp;
+  heap_pos[heap[i]] = i;
+  heap_pos[heap[j]] = j;
+}
+
+void Subscribe::heap_up(uint8_t pos) {
+  while (pos > 0) {
+    uint8_t parent = (pos - 1) / 2;
+    if (!before(heap[pos], heap[parent])) {
+      break;
+    }
+    heap_swap(pos, parent);
+    pos = parent;
+  }
+}
+
+void Subscribe::heap_down(uint8_t pos) {
+  while (true) {
+    uint8_t first = pos;
+    uint8_t left = 2 * pos + 1, right = left + 1;
+    if (left < heap_size && before(heap[left], heap[first])) {
+      first = left;
+    }
+    if (right < heap_size && before(heap[right], heap[first])) {
+      first = right;
+    }
+    if (first == pos) {
+      break;
+    }
+    heap_swap(pos, first);
+    pos = first;
+  }
+}
+
+// Put sub[index] in its place after its deadline changed
+void Subscribe::heap_update(uint8_t index) {
+  uint8_t pos = heap_pos[index];
+  if (pos == SUBSCRIBE_HEAP_NONE) {
+    pos = heap_size++;
+    heap[pos] = index;
+    heap_pos[index] = pos;
+  }
+  heap_up(pos);
+  heap_down(heap_pos[index]);
+}
+
+void Subscribe::heap_remove(uint8_t index) {
+  uint8_t pos = heap_pos[index];
+  if (pos == SUBSCRIBE_HEAP_NONE) {
+    return;
+  }
+  heap_swap(pos, --heap_size);
+  heap_pos[index] = SUBSCRIBE_HEAP_NONE;
+  if (pos < heap_size) {
+    heap_up(pos);
+    heap_down(pos);
+  }
+}
+
 ErrCode Subscribe::enable(event_param_t &event) {
   if (sub_count >= MAX_SUBSCRIBE_COUNT) {
     SERIAL_ECHOLNPAIR("SNMK_ERROR: subscribe count to max:", sub_count);
@@ -53,6 +140,7 @@ ErrCode Subscribe::enable(event_param_t &event) {
     SERIAL_ECHOLNPAIR("SNMK_ERROR:heve no cmd_set:", cmd_set, ", cmd_id:", cmd_id);
     return E_PARAM;
   }
+  lock();
   uint8_t index = 0;
   for (; index < sub_count; index++) {
     if (sub[index].info.command_set == cmd_set &&
@@ -71,12 +159,18 @@ ErrCode Subscribe::enable(event_param_t &event) {
 
   sub[index].cb = tmp_cb->cb;
   uint16_t tmp_time = data[3] << 8 | data[2];
-  sub[index].time_interval = tmp_time;
-  sub[index].last_time = millis();
+  // An interval of 0 would report on every pass, once a tick is the most
+  sub[index].time_interval = tmp_time ? tmp_time : 1;
+  sub[index].deadline = millis();
   sub[index].write_byte = event.write_byte;
   sub[index].source = event.source;
   sub[index].is_available = true;
+  heap_update(index);
+  unlock();
 
+  if (task_handle) {
+    xTaskNotifyGive(task_handle);
+  }
   return E_SUCCESS;
 }
 
@@ -90,36 +184,71 @@ ErrCode Subscribe::disable(event_param_t &event) {
   uint8_t cmd_id = data[1];
   uint8_t index = 0;
   SERIAL_ECHOPAIR("unsubscribe set:", cmd_set, ", id:", cmd_id);
+  lock();
   for (; index < sub_count; index++) {
     if (sub[index].info.command_set == cmd_set &&
         (sub[index].info.command_id == cmd_id) &&
         (sub[index].info.recever_id == event.info.recever_id) &&
         (sub[index].source == event.source)) {
       sub[index].is_available = false;
+      heap_remove(index);
+      unlock();
+      if (task_handle) {
+        xTaskNotifyGive(task_handle);
+      }
       SERIAL_ECHOLN(" success");
       return E_SUCCESS;
     }
   }
+  unlock();
   SERIAL_ECHOLN(" failed");
   return E_PARAM;
 }
 
+// Report what is due, then sleep until the next deadline or a change of the
+// subscriptions. Reports due together go out in one write per source.
 void Subscribe::loop_task(void * arg) {
   while (true) {
-    for (uint8_t i = 0; i < sub_count; i++) {
-      if (sub[i].is_available) {
-        // if (sub[i].last_time < millis()) {
-        // LOG_I("SB_LOOP: index %i, cur %d, to %d\r\n", i, millis(), sub[i].last_time);
-        if (ELAPSED(millis(), sub[i].last_time)) {
-          sub[i].last_time = millis() + sub[i].time_interval;
-          sub[i].info.sequence = protocol_sacp.sequence_pop();
-          event_public_param.write_byte = sub[i].write_byte;
-          event_public_param.info = sub[i].info;
-          event_public_param.source = sub[i].source;
-          event_public_param.length = 0;
-          (sub[i].cb)(event_public_param);
-        }
+    bool batching = false;
+    uint32_t now = millis();
+
+    lock();
+    while (heap_size && (int32_t)(sub[heap[0]].deadline - now) <= 0) {
+      uint8_t i = heap[0];
+      // Keep the rate, but do not try to catch up on missed reports
+      sub[i].deadline += sub[i].time_interval;
+      if ((int32_t)(sub[i].deadline - now) <= 0) {
+        sub[i].deadline = now + sub[i].time_interval;
+      }
+      heap_down(0);
+
+      sub[i].info.sequence = protocol_sacp.sequence_pop();
+      event_public_param.write_byte = sub[i].write_byte;
+      event_public_param.info = sub[i].info;
+      event_public_param.source = sub[i].source;
+      event_public_param.length = 0;
+      evevnt_cb_f cb = sub[i].cb;
+      unlock();
+
+      if (!batching) {
+        send_batch_begin();
+        batching = true;
       }
+      cb(event_public_param);
+      lock();
+    }
+    TickType_t wait = portMAX_DELAY;
+    if (heap_size) {
+      int32_t left = (int32_t)(sub[heap[0]].deadline - millis());
+      wait = left > 0 ? pdMS_TO_TICKS(left) : 0;
+    }
+    unlock();
+
+    if (batching) {
+      send_batch_end();
+    }
+    if (wait) {
+      ulTaskNotifyTake(pdTRUE, wait);
     }
   }
 }
@@ -130,8 +259,10 @@ static void subscribe_task(void * arg) {
 
 void subscribe_init(void) {
 
+  subscribe.init();
   TaskHandle_t thandle_subscribe = NULL;
   BaseType_t ret = xTaskCreate(subscribe_task, "subscribe_loop", 1024, NULL, 5, &thandle_subscribe);
+  subscribe.attach_task(thandle_subscribe);
   if (ret != pdPASS) {
     SERIAL_ECHO("Failed to create subscribe_loop!\n");
   }
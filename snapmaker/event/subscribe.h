@@ -27,12 +27,13 @@
 #include "event_base.h"
 
 #define MAX_SUBSCRIBE_COUNT 30
+#define SUBSCRIBE_HEAP_NONE 0xFF
 
 typedef struct {
   bool is_available;
   event_source_e source;
   uint16_t time_interval;
-  uint32_t last_time;
+  uint32_t deadline;  // millis() of the next report
   SACP_head_base_t info;
   write_byte_f write_byte;
   evevnt_cb_f cb;
@@ -40,12 +41,29 @@ typedef struct {
 
 class Subscribe {
   public:
+    void init();
+    void attach_task(TaskHandle_t task) { task_handle = task; }
     ErrCode enable(event_param_t &event);
     ErrCode disable(event_param_t &event);
     void loop_task(void *arg);
   private:
+    bool before(uint8_t a, uint8_t b);
+    void heap_swap(uint8_t i, uint8_t j);
+    void heap_up(uint8_t pos);
+    void heap_down(uint8_t pos);
+    void heap_update(uint8_t index);
+    void heap_remove(uint8_t index);
+    void lock();
+    void unlock();
+
     subscribe_node_t sub[MAX_SUBSCRIBE_COUNT];
     uint8_t sub_count;
+    // Min-heap of the available sub[] indexes by deadline
+    uint8_t heap[MAX_SUBSCRIBE_COUNT];
+    uint8_t heap_pos[MAX_SUBSCRIBE_COUNT];  // Position in heap or SUBSCRIBE_HEAP_NONE
+    uint8_t heap_size;
+    SemaphoreHandle_t heap_lock = NULL;
+    TaskHandle_t task_handle = NULL;
 };
 void subscribe_init(void);
 extern Subscribe subscribe;
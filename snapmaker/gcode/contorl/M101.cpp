@@ -36,8 +36,14 @@
 
 #define MAX_TASKS 12
 
+// Run time of each task at the last M101, CPU use is shown for the time since
+static uint32_t last_task_number[MAX_TASKS];
+static uint32_t last_task_run_time[MAX_TASKS];
+static uint32_t last_total_run_time;
+
 void GcodeSuite::M101() {
   TaskStatus_t TaskStatArray[MAX_TASKS];
+  uint32_t total_run_time;
 
   unsigned n_tasks = uxTaskGetNumberOfTasks();
   if (n_tasks > MAX_TASKS) {
@@ -48,7 +54,9 @@ void GcodeSuite::M101() {
 
   LOG_I("M101 RTOS Task Info:\n");
   /* Generate raw status information about each task. */
-  n_tasks = uxTaskGetSystemState( TaskStatArray, MAX_TASKS, NULL);
+  n_tasks = uxTaskGetSystemState( TaskStatArray, MAX_TASKS, &total_run_time);
+  uint32_t run_time = total_run_time - last_total_run_time;
+  last_total_run_time = total_run_time;
 
   LOG_I("Free Heap: %u Bytes\n", xPortGetFreeHeapSize());
 
@@ -70,6 +78,16 @@ void GcodeSuite::M101() {
 
     LOG_I(" Stack: 0x%08x ", TaskStatArray[x].pxStackBase);
     LOG_I(" Free_Mem: %u Bytes", (unsigned int) TaskStatArray[x].usStackHighWaterMark * sizeof( StackType_t ));
+
+    uint32_t task_run_time = TaskStatArray[x].ulRunTimeCounter;
+    for (unsigned i = 0; i < MAX_TASKS; i++) {
+      if (last_task_number[i] == TaskStatArray[x].xTaskNumber) {
+        task_run_time -= last_task_run_time[i];
+        break;
+      }
+    }
+    LOG_I(" CPU: %u.%u%%", run_time ? (unsigned)((uint64_t)task_run_time * 100 / run_time) : 0,
+          run_time ? (unsigned)((uint64_t)task_run_time * 1000 / run_time % 10) : 0);
     LOG_I(" State: ");
     switch( TaskStatArray[x].eCurrentState ) {
       case eRunning:   LOG_I("Running\n");   break;
@@ -81,4 +99,9 @@ void GcodeSuite::M101() {
         break;
     }
   }
+
+  for (unsigned x = 0; x < MAX_TASKS; x++) {
+    last_task_number[x] = x < n_tasks ? TaskStatArray[x].xTaskNumber : 0;
+    last_task_run_time[x] = x < n_tasks ? TaskStatArray[x].ulRunTimeCounter : 0;
+  }
 }
@@ -28,6 +28,7 @@
  #include "../../module/motion_control.h"
  #include "../../module/print_control.h"
  #include "../../module/power_loss.h"
+ #include "../../module/inactive_x.h"
  #include "../../module/system.h"
  #include "../../J1/switch_detect.h"
  #include "../../module/factory_data.h"
@@ -230,101 +231,13 @@
     SERIAL_ECHOLNPAIR("M2000 S200: Resumed with T", active_extruder, " at X", current_position.x);
   }
        else {
-         // Original Snapmaker HMI code
-         if (print_control.get_mode() >= PRINT_DUPLICATION_MODE) {
-           LOG_I("work mode do not support this command\r\n");
-           return;
-         }
-         if (axisManager.T0_T1_simultaneously_move) {
-           LOG_I("BUSY\r\n");
-           return;
-         }
-         if (SYSTEM_STATUE_PRINTING != system_service.get_status()) {
-           LOG_I("Not printing, can not move T0 T1 now\r\n");
-           return;
-         }
-         axisManager.T0_T1_simultaneously_move_req = true;
-         axisManager.T0_T1_target_pos = x_home_pos(!active_extruder);
-         float L = axisManager.T0_T1_target_pos - inactive_extruder_x;
-         float V = (float)parser.floatval('V', (float)200.0);
-         float A = (float)parser.floatval('A', (float)6000.0);
-         int32_t target_steps = (!active_extruder) == 0 ? axisManager.X0_home_step_pos : axisManager.X1_home_step_pos;
-         axisManager.T0_T1_calc_steps = target_steps - axisManager.inactive_x_step_pos;
-         int32_t float_d_to_step_d = L * planner.settings.axis_steps_per_mm[X_AXIS];
-         if (abs(float_d_to_step_d - axisManager.T0_T1_calc_steps) > 5) {
-           axisManager.T0_T1_calc_steps = L * planner.settings.axis_steps_per_mm[X_AXIS];
-         }
-         if (0 == axisManager.T0_T1_calc_steps){
-           axisManager.T0_T1_simultaneously_move_req = false;
-           return;
-         }
-         float millimeters = fabs(L);
-         float entry_speed = 5 / 1000.0f;
-         float leave_speed = 5 / 1000.0f;
-         float nominal_speed = fabs(V) / 1000.0f;
-         float acceleration = fabs(A) / 1000000.0f;
-         float i_acceleration = 1.0f / acceleration;
-         float i_nominal_speed = 1.0f / nominal_speed;
-         float accelDistance = Planner::estimate_acceleration_distance(entry_speed, nominal_speed, acceleration);
-         float decelDistance = Planner::estimate_acceleration_distance(nominal_speed, leave_speed, -acceleration);
-         if (accelDistance < EPSILON) accelDistance = 0;
-         if (decelDistance < EPSILON) decelDistance = 0;
-         float plateau = millimeters - accelDistance - decelDistance;
-         float accelClocks = (nominal_speed - entry_speed) * i_acceleration;
-         float decelClocks = (nominal_speed - leave_speed) * i_acceleration;
-         float plateauClocks = plateau * i_nominal_speed;
-         if (plateau < 0) {
-           float newAccelDistance = Planner::intersection_distance(entry_speed, leave_speed, acceleration, millimeters);
-           if (newAccelDistance > millimeters) newAccelDistance = millimeters;
-           if (newAccelDistance < EPSILON) newAccelDistance = 0;
-           if ((millimeters - newAccelDistance) < EPSILON) newAccelDistance = millimeters;
-           accelDistance = newAccelDistance;
-           decelDistance = millimeters - accelDistance;
-           if (decelDistance < EPSILON) decelDistance = 0;
-           nominal_speed = SQRT(2 * acceleration * accelDistance + sq(entry_speed));
-           if (nominal_speed < leave_speed) nominal_speed = leave_speed;
-           accelClocks = (nominal_speed - entry_speed) * i_acceleration;
-           decelClocks = (nominal_speed - leave_speed) * i_acceleration;
-           plateauClocks = 0;
-           plateau = 0;
-         }
-         Move move;
-         axisManager.axis_t0_t1.reset();
-         move.start_t = 0;
-         move.axis_r[T0_T1_AXIS_INDEX] = L > 0.0 ? 80 : -80;
-         if (accelDistance > 0) {
-           move.accelerate = acceleration;
-           move.t = accelClocks;
-           move.end_t = move.start_t + move.t;
-           move.start_pos[T0_T1_AXIS_INDEX] = axisManager.axis_t0_t1.func_manager.last_pos;
-           move.end_pos[T0_T1_AXIS_INDEX] = move.start_pos[T0_T1_AXIS_INDEX] + accelDistance * move.axis_r[T0_T1_AXIS_INDEX];
-           axisManager.axis_t0_t1.generateLineFuncParams(&move);
-         }
-         if (plateau > 0.0) {
-           move.accelerate = 0;
-           move.start_t = move.end_t;
-           move.t = plateauClocks;
-           move.end_t = move.start_t + move.t;
-           move.start_pos[T0_T1_AXIS_INDEX] = move.end_pos[T0_T1_AXIS_INDEX];
-           move.end_pos[T0_T1_AXIS_INDEX] = move.start_pos[T0_T1_AXIS_INDEX] + plateau * move.axis_r[T0_T1_AXIS_INDEX];
-           axisManager.axis_t0_t1.generateLineFuncParams(&move);
-         }
-         if (decelDistance > 0) {
-           move.accelerate = -acceleration;
-           move.start_t = move.end_t;
-           move.t = decelClocks;
-           move.end_t = move.start_t + move.t;
-           move.start_pos[T0_T1_AXIS_INDEX] = move.end_pos[T0_T1_AXIS_INDEX];
-           move.end_pos[T0_T1_AXIS_INDEX] = move.start_pos[T0_T1_AXIS_INDEX] + decelDistance * move.axis_r[T0_T1_AXIS_INDEX];
-           axisManager.axis_t0_t1.generateLineFuncParams(&move);
-         }
-         axisManager.T0_T1_execute_steps = 0;
-         axisManager.T0_T1_axis = !active_extruder;
-         inactive_extruder_x = axisManager.T0_T1_target_pos;
-         axisManager.T0_T1_last_print_time = 0;
-         axisManager.axis_t0_t1.is_consumed = true;
-         axisManager.T0_T1_simultaneously_move = true;
-         axisManager.T0_T1_simultaneously_move_req = false;
+         // Original Snapmaker HMI code, X queues a move of the inactive carriage to X instead of parking it
+         const float speed = parser.floatval('V', INACTIVE_X_SPEED_DEFAULT);
+         const float accel = parser.floatval('A', INACTIVE_X_ACCEL_DEFAULT);
+         if (parser.seenval('X'))
+           inactive_x.move_to(parser.value_float(), speed, accel);
+         else
+           motion_control.park_inactive_x(speed, accel);
        }
        break;
      case 50:
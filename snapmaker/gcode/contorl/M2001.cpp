@@ -0,0 +1,43 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../../Marlin/src/gcode/gcode.h"
+#include "../../debug/debug.h"
+#include "../../debug/profiler.h"
+
+/**
+ * M2001: Hot path profiler
+ *
+ *  M2001    Dump count, min/avg/max time and histogram of every probe
+ *  M2001 R  Reset all probes
+ */
+void GcodeSuite::M2001() {
+  #if ENABLED(HOT_PATH_PROFILER)
+    if (parser.seen('R')) {
+      Profiler::reset();
+      LOG_I("profiler reset\n");
+      return;
+    }
+    Profiler::dump();
+  #else
+    LOG_I("HOT_PATH_PROFILER is disabled\n");
+  #endif
+}
@@ -0,0 +1,42 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../../../Marlin/src/gcode/gcode.h"
+#include "../../debug/debug.h"
+#include "../../module/tool_lookahead.h"
+
+/**
+ * M2002: Look-ahead tool change scheduler
+ *
+ *  M2002      Report the tool change dwell of the current print
+ *  M2002 P<0|1>  Preheat the idle hotend ahead of a tool change
+ *  M2002 K<0|1>  Park the old head right after a tool change
+ */
+void GcodeSuite::M2002() {
+  if (parser.seenval('P')) {
+    tool_lookahead.set_preheat(parser.value_bool());
+  }
+  if (parser.seenval('K')) {
+    tool_lookahead.set_early_park(parser.value_bool());
+  }
+  LOG_I("tool preheat:%d, early park:%d\n", tool_lookahead.preheat(), tool_lookahead.early_park());
+  tool_lookahead.report();
+}
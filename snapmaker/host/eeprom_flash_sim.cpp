@@ -0,0 +1,273 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ Flash simulator for the settings EEPROM emulation.
+
+ The two EEPROM pages are a RAM array behind FLASH_ProgramWord() and
+ FLASH_ErasePage() with NOR semantics. A power cut in a word program leaves
+ some of its bits cleared, one in a page erase some of the page bits set.
+
+ Reported are the page erases and words programmed by a run of saves that
+ each change a few words, against the old store that erased and wrote the
+ whole area on every save.
+
+ Then power is cut at every flash operation of a run of saves, including
+ the ones that move the settings to the other page, and a load after the
+ cut must give the settings of before or after the save, never a mix. A
+ save after the cut must then store the new settings. The first save of
+ the old raw layout must keep its settings.
+
+ build: make -C snapmaker/host
+ usage: eeprom_flash_sim [saves]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <libmaple/libmaple_types.h>
+#include "flash_stm32.h"
+#include "../module/flash_eeprom.h"
+
+#define SIM_BASE        0x080FD000UL
+#define SIM_PAGE_SIZE   (4 * 1024)
+#define SIM_SIZE        (2 * SIM_PAGE_SIZE)
+#define IMAGE_SIZE      (SIM_PAGE_SIZE - FLASH_EEPROM_HEAD_WORDS * 4)
+// Bytes of settings data, the rest of the image stays blank
+#define SETTINGS_SIZE   1400
+
+static uint8_t flash[SIM_SIZE];
+static bool locked = true;
+static long cut_after = -1;     // operations left until the power cut, -1 for none
+static uint32_t words, erases, ops;
+
+const uint8_t *flash_sim_map(uint32_t addr) {
+  if (addr < SIM_BASE || addr >= SIM_BASE + SIM_SIZE) {
+    printf("read out of the EEPROM pages: 0x%08x\n", addr);
+    exit(1);
+  }
+  return flash + (addr - SIM_BASE);
+}
+
+static uint32_t random_bits() {
+  return (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+}
+
+// True when the power goes in this operation
+static bool power_cut() {
+  ops++;
+  return cut_after > 0 && --cut_after == 0;
+}
+
+extern "C" {
+
+void FLASH_Unlock(void) { locked = false; }
+void FLASH_Lock(void) { locked = true; }
+
+FLASH_Status FLASH_ProgramWord(uint32 Address, uint32 Data) {
+  if (locked || cut_after == 0) {
+    return FLASH_ERROR_PG;
+  }
+  if (Address & 3 || Address < SIM_BASE || Address >= SIM_BASE + SIM_SIZE) {
+    return FLASH_BAD_ADDRESS;
+  }
+  uint32_t word;
+  memcpy(&word, flash + (Address - SIM_BASE), 4);
+  if (power_cut()) {
+    // Some of the bits get cleared, not all
+    uint32_t zeros = ~Data;
+    uint32_t left = random_bits() & zeros;
+    Data |= left ? left : zeros & -zeros;
+  }
+  word &= Data;
+  memcpy(flash + (Address - SIM_BASE), &word, 4);
+  words++;
+  return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ErasePage(uint32 Page_Address) {
+  if (locked || cut_after == 0 || Page_Address < SIM_BASE || Page_Address >= SIM_BASE + SIM_SIZE) {
+    return FLASH_ERROR_PG;
+  }
+  uint8_t *page = flash + ((Page_Address - SIM_BASE) & ~(SIM_PAGE_SIZE - 1));
+  if (power_cut()) {
+    for (uint32_t i = 0; i < SIM_PAGE_SIZE; i++) {
+      page[i] |= rand();
+    }
+  } else {
+    memset(page, 0xFF, SIM_PAGE_SIZE);
+  }
+  erases++;
+  return FLASH_COMPLETE;
+}
+
+}
+
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static uint8_t image[IMAGE_SIZE];
+
+// The RAM copy as settings.cpp leaves it: settings data, then blank
+static void settings_of(uint8_t *data, uint32_t seed) {
+  memset(data, 0xFF, IMAGE_SIZE);
+  for (uint32_t i = 0; i < SETTINGS_SIZE; i++) {
+    data[i] = (uint8_t)(i * 7 + (i >> 8));
+  }
+  memcpy(data, &seed, sizeof(seed));
+}
+
+// A save of M500 changes a few values
+static void change(uint8_t *data, uint32_t seed) {
+  memcpy(data, &seed, sizeof(seed));
+  for (int n = rand() % 12; n > 0; n--) {
+    data[8 + rand() % (SETTINGS_SIZE - 8)] = rand();
+  }
+}
+
+static bool loads(FlashEeprom &store, const uint8_t *expect) {
+  memset(image, 0, sizeof(image));
+  store.load(IMAGE_SIZE);
+  return !memcmp(image, expect, IMAGE_SIZE);
+}
+
+static void report_wear(long saves) {
+  FlashEeprom store;
+  uint8_t data[IMAGE_SIZE];
+  memset(flash, 0xFF, sizeof(flash));
+  store.init(SIM_BASE, SIM_PAGE_SIZE, image, IMAGE_SIZE);
+  settings_of(data, 0);
+  memcpy(image, data, IMAGE_SIZE);
+  store.save();
+
+  words = erases = 0;
+  for (long s = 1; s <= saves; s++) {
+    change(data, s);
+    memcpy(image, data, IMAGE_SIZE);
+    CHECK(store.save(), "save %ld failed", s);
+  }
+  CHECK(loads(store, data), "settings lost after %ld saves", saves);
+
+  // Before: two erases and 2048 half words on every save
+  printf("%ld saves of a few changed words, %u bytes of settings:\n", saves, SETTINGS_SIZE);
+  printf("  erase and rewrite   %6ld erases %8ld words\n", saves * 2, saves * 1024);
+  printf("  append changes      %6u erases %8u words, %u page moves\n", erases, words, store.compactions);
+  printf("  erases per page     %.1fx fewer\n", erases ? (double)saves * 2 / erases : (double)saves * 2);
+}
+
+// Cut the power at every flash operation of each save
+static void cut_saves(long saves) {
+  FlashEeprom store;
+  uint8_t before[IMAGE_SIZE], after[IMAGE_SIZE];
+  static uint8_t snapshot[SIM_SIZE], saved[SIM_SIZE];
+  uint32_t cuts = 0, moves = 0, old = 0;
+
+  memset(flash, 0xFF, sizeof(flash));
+  store.init(SIM_BASE, SIM_PAGE_SIZE, image, IMAGE_SIZE);
+  settings_of(before, 0);
+  memcpy(image, before, IMAGE_SIZE);
+  store.save();
+
+  for (long s = 1; s <= saves; s++) {
+    memcpy(after, before, IMAGE_SIZE);
+    change(after, s);
+
+    // Operations of the save without a cut
+    memcpy(snapshot, flash, SIM_SIZE);
+    uint32_t compactions = store.compactions;
+    ops = 0;
+    memcpy(image, after, IMAGE_SIZE);
+    store.save();
+    uint32_t save_ops = ops;
+    moves += store.compactions != compactions;
+    memcpy(saved, flash, SIM_SIZE);
+
+    for (uint32_t cut = 1; cut <= save_ops; cut++) {
+      memcpy(flash, snapshot, SIM_SIZE);
+      memcpy(image, after, IMAGE_SIZE);
+      cut_after = cut;
+      store.save();
+      cut_after = -1;
+      cuts++;
+
+      // Power back
+      FlashEeprom back;
+      back.init(SIM_BASE, SIM_PAGE_SIZE, image, IMAGE_SIZE);
+      bool is_before = loads(back, before);
+      bool is_after = !memcmp(image, after, IMAGE_SIZE);
+      CHECK(is_before || is_after, "save %ld cut at op %u of %u: settings mixed", s, cut, save_ops);
+      old += is_before;
+
+      memcpy(image, after, IMAGE_SIZE);
+      CHECK(back.save(), "save %ld cut at op %u: no save after", s, cut);
+      CHECK(loads(back, after), "save %ld cut at op %u: save after lost", s, cut);
+    }
+    // Go on from the save without a cut, so the entries fill up
+    memcpy(flash, saved, SIM_SIZE);
+    memcpy(before, after, IMAGE_SIZE);
+  }
+  printf("%ld saves, %u of them page moves, %u cuts: %u kept the old settings, %u the new, none mixed\n",
+         saves, moves, cuts, old, cuts - old);
+}
+
+// Raw 4 KB image of the old store in the first page
+static void legacy_layout() {
+  FlashEeprom store;
+  uint8_t data[IMAGE_SIZE];
+  memset(flash, 0xFF, sizeof(flash));
+  settings_of(data, 77);
+  memcpy(flash, data, IMAGE_SIZE);
+
+  store.init(SIM_BASE, SIM_PAGE_SIZE, image, IMAGE_SIZE);
+  CHECK(loads(store, data), "old layout not read");
+  CHECK(store.save(), "old layout not moved");
+  CHECK(loads(store, data), "old layout lost in the move");
+
+  uint8_t len_data[IMAGE_SIZE];
+  memset(image, 0xAB, IMAGE_SIZE);
+  memcpy(len_data, image, IMAGE_SIZE);
+  memcpy(len_data, data, 100);
+  store.load(100);
+  CHECK(!memcmp(image, len_data, IMAGE_SIZE), "load of a length changed bytes past it");
+  printf("old layout moved to the second page\n");
+}
+
+int main(int argc, char **argv) {
+  long saves = 400;
+  if (argc > 1) {
+    saves = atol(argv[1]);
+  }
+  srand(1);
+
+  report_wear(saves);
+  cut_saves(saves);
+  legacy_layout();
+
+  if (failures) {
+    printf("%d FAILED\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,499 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Round trip test and benchmark of the binary G-code transport.
+
+ A G-code file, or a synthetic slicer like stream without one, is encoded
+ into packs of at most GCODE_MAX_PACK_SIZE bytes the way the HMI does. The
+ packs are checked with gcode_bin_check(), pushed with a sync mark into a
+ ring of the size of the print_control buffer and decoded record by record
+ as print_control.get_commands() does. Every decoded command must give the
+ GCodeParser the same command, the same parameters and bit identical
+ value_float() and value_long() as the text line. Random lines and random
+ pack bytes are fuzzed after that.
+
+ Reported are lines per pack for text and binary, and the CPU time per line
+ from the buffer to the parsed values for both.
+
+ build: make -C snapmaker/host
+ usage: gcode_binary_test [file.gcode] [fuzz cases]
+*/
+
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../protocol/gcode_binary.h"
+#include "../../Marlin/src/gcode/parser.h"
+
+#define GCODE_MAX_PACK_SIZE 450
+#define GCODE_BUFFER_SIZE   (1024 * 2)
+#define BENCH_ROUNDS        20
+
+// Serial output of the parser, nothing is echoed in the test
+void serialprintPGM(PGM_P str) { (void)str; }
+void serial_echo_start() {}
+void serial_error_start() {}
+void serial_echopair_PGM(PGM_P const s, const char *v) { (void)s; (void)v; }
+
+struct Pack {
+  std::vector<uint8_t> data;
+  uint32_t lines;
+};
+
+static std::vector<std::string> lines;
+static std::vector<Pack> text_packs, bin_packs;
+static uint8_t ring[GCODE_BUFFER_SIZE];
+
+static uint32_t next_rand() {
+  static uint32_t seed = 12345;
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static bool load_file(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    // The HMI sends lines without comments
+    char *p = strchr(line, ';');
+    if (!p) p = line + strlen(line);
+    while (p > line && (p[-1] == '\n' || p[-1] == '\r' || p[-1] == ' ')) p--;
+    *p = 0;
+    if (strlen(line) < GCODE_BIN_CMD_MAX) {
+      lines.push_back(line);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static void add_line(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void add_line(const char *fmt, ...) {
+  char line[128];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  lines.push_back(line);
+}
+
+static void add_move(double &x, double &y, double nx, double ny, double &e_abs) {
+  double e = hypot(nx - x, ny - y) * 0.0333;
+  x = nx;
+  y = ny;
+  e_abs += e;
+  switch (next_rand() % 50) {
+    case 0:  add_line("G1 X%.3f Y%.3f E%.5f F%d", x, y, e, 1200 + (int)(next_rand() % 60) * 100); break;
+    case 1:  add_line("G2 X%.3f Y%.3f I%.3f J%.3f E%.5f", x, y, (next_rand() % 2001) / 1000.0 - 1, 0.5, e); break;
+    case 2:  add_line("G3 X%.3f Y%.3f R%.3f E%.5f", x, y, (next_rand() % 20001) / 1000.0 + 1, e); break;
+    case 3:  add_line("G1 X%.2f Y%.2f E%.4f", x, y, e); break;
+    // Absolute E long into a print, past 2^24 in fixed point
+    case 4:  add_line("G92 E%.5f", e_abs * 100); break;
+    default: add_line("G1 X%.3f Y%.3f E%.5f", x, y, e); break;
+  }
+}
+
+// Curved perimeters and infill of a few layers, relative E like the slicer profiles
+static void synthetic_stream() {
+  double x = 150, y = 150, z = 0, e_abs = 0;
+  add_line("M104 S210");
+  add_line("M140 S60");
+  add_line("G28");
+  add_line("G92 E0");
+  add_line("M83");
+  for (int layer = 0; layer < 40; layer++) {
+    z += 0.2;
+    add_line("G1 Z%.3f F600", z);
+    add_line("M106 S%d", layer ? 255 : 0);
+    if (layer % 10 == 9) {
+      add_line("T%d", (layer / 10) & 1);
+      add_line("G92 E0");
+    }
+    // Perimeters, segments of a few mm around a wavy outline
+    for (int wall = 0; wall < 3; wall++) {
+      double r = 40 - wall * 0.42;
+      add_line("G1 E-0.8 F2400");
+      add_line("G0 F9000 X%.3f Y%.3f", 150 + r, 150.0);
+      add_line("G1 E0.8 F2400");
+      x = 150 + r;
+      y = 150;
+      for (int i = 1; i <= 360; i++) {
+        double a = i * M_PI / 180, rr = r + 3 * sin(a * 6);
+        add_move(x, y, 150 + rr * cos(a), 150 + rr * sin(a), e_abs);
+      }
+    }
+    // Infill, long lines joined by short steps
+    lines.push_back("");
+    add_line("G0 X%.3f Y%.3f", 120.0, 120.0);
+    x = y = 120;
+    for (int i = 0; i < 60; i++) {
+      add_move(x, y, (i & 1) ? 120 : 180, y, e_abs);
+      add_move(x, y, x, y + 1, e_abs);
+    }
+  }
+  add_line("M104 S0");
+  add_line("M84");
+}
+
+// Split the stream into packs, binary packs start from a zero context
+static void build_packs() {
+  Pack text = {{}, 0}, bin = {{}, 0};
+  gcode_bin_ctx_t ctx;
+  gcode_bin_reset(ctx);
+  for (size_t i = 0; i < lines.size(); i++) {
+    const std::string &l = lines[i];
+    if (text.data.size() + l.size() + 1 > GCODE_MAX_PACK_SIZE) {
+      text_packs.push_back(text);
+      text = {{}, 0};
+    }
+    text.data.insert(text.data.end(), l.begin(), l.end());
+    text.data.push_back('\n');
+    text.lines++;
+
+    uint8_t record[GCODE_BIN_CMD_MAX + 2];
+    gcode_bin_ctx_t next = ctx;
+    int16_t n = gcode_bin_encode(l.c_str(), l.size(), record, sizeof(record), next);
+    if (bin.data.size() + n > GCODE_MAX_PACK_SIZE) {
+      bin_packs.push_back(bin);
+      bin = {{}, 0};
+      gcode_bin_reset(ctx);
+      next = ctx;
+      n = gcode_bin_encode(l.c_str(), l.size(), record, sizeof(record), next);
+    }
+    ctx = next;
+    bin.data.insert(bin.data.end(), record, record + n);
+    bin.lines++;
+  }
+  if (text.lines) text_packs.push_back(text);
+  if (bin.lines) bin_packs.push_back(bin);
+}
+
+struct Parsed {
+  char letter;
+  uint16_t codenum;
+  uint32_t seen;
+  float value[26];
+  int32_t value_long[26];
+  bool has_value[26];
+};
+
+static void take(Parsed &p) {
+  memset(&p, 0, sizeof(p));
+  p.letter = parser.command_letter;
+  p.codenum = parser.codenum;
+  for (char c = 'A'; c <= 'Z'; c++) {
+    if (parser.seen(c)) {
+      uint8_t i = c - 'A';
+      p.seen |= 1UL << i;
+      p.has_value[i] = parser.has_value();
+      p.value[i] = parser.value_float();
+      p.value_long[i] = parser.value_long();
+    }
+  }
+}
+
+static bool same(const Parsed &a, const Parsed &b, const char *line) {
+  bool ok = a.letter == b.letter && a.codenum == b.codenum && a.seen == b.seen;
+  for (int i = 0; ok && i < 26; i++) {
+    ok = a.has_value[i] == b.has_value[i] && !memcmp(&a.value[i], &b.value[i], sizeof(float))
+         && a.value_long[i] == b.value_long[i];
+  }
+  if (!ok) {
+    printf("MISMATCH \"%s\"\n", line);
+  }
+  return ok;
+}
+
+// The print_control side: push with a sync mark, decode one record per command
+struct Ring {
+  uint16_t head, tail;
+  gcode_bin_ctx_t ctx;
+
+  uint16_t used() { return (head + GCODE_BUFFER_SIZE - tail) % GCODE_BUFFER_SIZE; }
+
+  bool push(const Pack &pack) {
+    uint32_t lines;
+    if (GCODE_BUFFER_SIZE - used() < (int)pack.data.size() + 2 || !gcode_bin_check(pack.data.data(), pack.data.size(), lines)
+        || lines != pack.lines) {
+      return false;
+    }
+    ring[head] = GCODE_BIN_OP_SYNC;
+    head = (head + 1) % GCODE_BUFFER_SIZE;
+    for (uint8_t ch : pack.data) {
+      ring[head] = ch;
+      head = (head + 1) % GCODE_BUFFER_SIZE;
+    }
+    return true;
+  }
+
+  int16_t get(char *cmd) {
+    while (head != tail) {
+      if (ring[tail] == GCODE_BIN_OP_SYNC) {
+        gcode_bin_reset(ctx);
+        tail = (tail + 1) % GCODE_BUFFER_SIZE;
+        continue;
+      }
+      gcode_bin_reader_t r = {ring, GCODE_BUFFER_SIZE, tail, used()};
+      int16_t len = gcode_bin_decode(r, ctx, cmd, MAX_CMD_SIZE);
+      if (len >= 0) {
+        tail = r.pos;
+      }
+      return len;
+    }
+    return -1;
+  }
+};
+
+static bool round_trip() {
+  Ring rb;
+  memset(&rb, 0, sizeof(rb));
+  size_t line = 0, pack = 0;
+  char cmd[MAX_CMD_SIZE], text[MAX_CMD_SIZE];
+  while (line < lines.size()) {
+    while (pack < bin_packs.size() && rb.push(bin_packs[pack])) {
+      pack++;
+    }
+    int16_t len = rb.get(cmd);
+    if (len < 0) {
+      printf("DECODE FAILED at line %u\n", (unsigned)line + 1);
+      return false;
+    }
+    const std::string &l = lines[line++];
+    if (!len) {
+      if (!l.empty()) {
+        printf("EMPTY \"%s\"\n", l.c_str());
+        return false;
+      }
+      continue;
+    }
+    Parsed a, b;
+    parser.parse(cmd);
+    take(a);
+    strcpy(text, l.c_str());
+    parser.parse(text);
+    take(b);
+    if (!same(a, b, l.c_str())) {
+      return false;
+    }
+    if (cmd[0] == GCODE_BIN_MARK) {
+      // The echo must parse back to the same values
+      gcode_bin_to_text(cmd, text, sizeof(text));
+      parser.parse(text);
+      take(b);
+      if (!same(a, b, text)) {
+        return false;
+      }
+    }
+  }
+  return pack == bin_packs.size() && rb.head == rb.tail;
+}
+
+static void fuzz_line(char *line) {
+  static const char letters[] = "XYZEFIJRSTP";
+  int n = sprintf(line, "G%d", (int)(next_rand() % 4 ? next_rand() % 4 : next_rand() % 100));
+  for (int i = next_rand() % 6; i > 0 && n < 70; i--) {
+    line[n++] = next_rand() % 8 ? ' ' : '\0';
+    if (!line[n - 1]) n--;
+    line[n++] = letters[next_rand() % (next_rand() % 5 ? 8 : sizeof(letters) - 1)];
+    int decimals = next_rand() % 7;
+    long v = (long)(next_rand() % 2000000000) >> (next_rand() % 31);
+    switch (next_rand() % 8) {
+      case 0:  n += sprintf(line + n, "%ld", v); break;
+      case 1:  n += sprintf(line + n, "-%ld.%0*ld", v / 1000, decimals, v % 1000); break;
+      case 2:  n += sprintf(line + n, ".%ld", v % 1000); break;
+      case 3:  n += sprintf(line + n, "-0.0"); break;
+      case 4:  n += sprintf(line + n, "+%ld.", v % 100); break;
+      default: n += sprintf(line + n, "%ld.%0*ld", v / 100000, decimals, v % 100000); break;
+    }
+  }
+  line[n] = 0;
+}
+
+static bool fuzz(long cases) {
+  char line[128], cmd[MAX_CMD_SIZE], text[128];
+  uint8_t record[GCODE_BIN_CMD_MAX + 2];
+  for (long i = 0; i < cases; i++) {
+    gcode_bin_ctx_t enc, dec;
+    gcode_bin_reset(enc);
+    for (int j = 0; j < GCODE_BIN_PARAM_COUNT; j++) {
+      enc.last[j] = (int64_t)(next_rand() % 2000001) - 1000000;
+    }
+    dec = enc;
+    fuzz_line(line);
+    int16_t n = gcode_bin_encode(line, strlen(line), record, sizeof(record), enc);
+    if (n < 0) {
+      continue;
+    }
+    uint32_t count;
+    gcode_bin_reader_t r = {record, (uint16_t)n, 0, (uint16_t)n};
+    gcode_bin_reader_t skip = r;
+    if (!gcode_bin_check(record, n, count) || count != 1 || gcode_bin_decode(r, dec, cmd, MAX_CMD_SIZE) < 0
+        || r.left || memcmp(&enc, &dec, sizeof(enc)) || gcode_bin_skip(skip, text, sizeof(text)) < 0 || skip.left) {
+      printf("FUZZ DECODE \"%s\"\n", line);
+      return false;
+    }
+    Parsed a, b;
+    parser.parse(cmd);
+    take(a);
+    strcpy(text, line);
+    parser.parse(text);
+    take(b);
+    if (!same(a, b, line)) {
+      return false;
+    }
+  }
+
+  // Random bytes must be refused or decode within bounds
+  uint8_t junk[64];
+  for (long i = 0; i < cases; i++) {
+    uint16_t size = 1 + next_rand() % sizeof(junk);
+    for (uint16_t j = 0; j < size; j++) {
+      junk[j] = next_rand() % 3 ? (uint8_t)next_rand() : (uint8_t)(next_rand() % 8);
+    }
+    uint32_t count;
+    if (!gcode_bin_check(junk, size, count)) {
+      continue;
+    }
+    gcode_bin_ctx_t ctx;
+    gcode_bin_reset(ctx);
+    gcode_bin_reader_t r = {junk, size, 0, size};
+    for (uint32_t j = 0; j < count; j++) {
+      int16_t len = gcode_bin_decode(r, ctx, cmd, MAX_CMD_SIZE);
+      if (len < 0 || len >= MAX_CMD_SIZE || (len && cmd[0] != GCODE_BIN_MARK && strlen(cmd) != (size_t)len)) {
+        printf("FUZZ CHECKED PACK FAILED TO DECODE\n");
+        return false;
+      }
+    }
+    if (r.left) {
+      printf("FUZZ CHECKED PACK NOT CONSUMED\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+static volatile float sink;
+
+static void consume() {
+  float sum = 0;
+  for (char c : {'X', 'Y', 'Z', 'E', 'F', 'I', 'J', 'R', 'S'}) {
+    if (parser.seenval(c)) sum += parser.value_float();
+  }
+  sink = sink + sum;
+}
+
+// print_control.get_commands() text path, parser and value_float() per line
+static double text_ns() {
+  static uint8_t buf[GCODE_BUFFER_SIZE];
+  char cmd[MAX_CMD_SIZE];
+  auto st = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    for (const Pack &pack : text_packs) {
+      memcpy(buf, pack.data.data(), pack.data.size());
+      uint16_t tail = 0, head = pack.data.size();
+      while (tail != head) {
+        while (tail != head && (buf[tail] == ' ' || buf[tail] == '\n')) tail++;
+        uint16_t n = 0;
+        while (tail != head) {
+          cmd[n] = buf[tail++];
+          if (cmd[n] == '\n') {
+            cmd[n] = 0;
+            break;
+          }
+          n++;
+        }
+        if (n) {
+          parser.parse(cmd);
+          consume();
+        }
+      }
+    }
+  }
+  auto et = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(et - st).count() / BENCH_ROUNDS / lines.size();
+}
+
+static double bin_ns() {
+  char cmd[MAX_CMD_SIZE];
+  gcode_bin_ctx_t ctx;
+  auto st = std::chrono::steady_clock::now();
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    for (const Pack &pack : bin_packs) {
+      gcode_bin_reset(ctx);
+      gcode_bin_reader_t r = {pack.data.data(), (uint16_t)pack.data.size(), 0, (uint16_t)pack.data.size()};
+      while (r.left) {
+        if (gcode_bin_decode(r, ctx, cmd, MAX_CMD_SIZE) > 0) {
+          parser.parse(cmd);
+          consume();
+        }
+      }
+    }
+  }
+  auto et = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(et - st).count() / BENCH_ROUNDS / lines.size();
+}
+
+int main(int argc, char **argv) {
+  int arg = 1;
+  if (argc > arg && !isdigit(argv[arg][0])) {
+    if (!load_file(argv[arg])) {
+      fprintf(stderr, "can not open %s\n", argv[arg]);
+      return 1;
+    }
+    arg++;
+  } else {
+    synthetic_stream();
+  }
+  long cases = argc > arg ? atol(argv[arg]) : 200000;
+
+  build_packs();
+  if (!round_trip()) {
+    return 2;
+  }
+  printf("%u lines round trip identical\n", (unsigned)lines.size());
+  if (!fuzz(cases)) {
+    return 2;
+  }
+  printf("%ld random lines and packs ok\n", cases);
+
+  size_t text_bytes = 0, bin_bytes = 0;
+  for (const Pack &p : text_packs) text_bytes += p.data.size();
+  for (const Pack &p : bin_packs) bin_bytes += p.data.size();
+  double text_lines = (double)lines.size() / text_packs.size(), bin_lines = (double)lines.size() / bin_packs.size();
+  printf("format  packs    bytes  bytes/line  lines/pack  ns/line\n");
+  printf("text    %5u  %7u  %10.1f  %10.1f  %7.1f\n", (unsigned)text_packs.size(), (unsigned)text_bytes,
+         (double)text_bytes / lines.size(), text_lines, text_ns());
+  printf("binary  %5u  %7u  %10.1f  %10.1f  %7.1f\n", (unsigned)bin_packs.size(), (unsigned)bin_bytes,
+         (double)bin_bytes / lines.size(), bin_lines, bin_ns());
+  printf("lines per pack x%.2f\n", bin_lines / text_lines);
+  return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ Definitions the motion core links against when it is built for the host.
+ They stand in for planner.cpp, parser.cpp, debug.cpp and the Arduino core.
+*/
+
+#include <stdarg.h>
+#include <time.h>
+
+#include "../../Marlin/src/module/AxisManager.h"
+#include "../../Marlin/src/gcode/parser.h"
+
+HostSerial MSerial1;
+
+// snapmaker/debug
+SnapDebug debug;
+static debug_level_e host_debug_level = SNAP_DEBUG_LEVEL_WARNING;
+
+void SnapDebug::Log(debug_level_e level, const char *fmt, ...) {
+    if (level < host_debug_level) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+void SnapDebug::Defer(debug_level_e level, const char *fmt, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3) {
+    Log(level, fmt, a0, a1, a2, a3);
+}
+
+void SnapDebug::set_level(debug_level_e l) {
+    host_debug_level = l;
+}
+
+debug_level_e SnapDebug::get_level() {
+    return host_debug_level;
+}
+
+// planner
+Planner planner;
+Planner::Planner() {}
+planner_settings_t Planner::settings;
+block_t Planner::block_buffer[BLOCK_BUFFER_SIZE];
+float Planner::extruder_advance_K[EXTRUDERS];
+void Planner::synchronize() {}
+uint32_t statistics_funcgen_runout_cnt;
+
+// motion
+#if HAS_MULTI_EXTRUDER
+    uint8_t active_extruder;
+#endif
+float inactive_extruder_x;
+#if ENABLED(DUAL_X_CARRIAGE)
+    DualXMode dual_x_carriage_mode = DEFAULT_DUAL_X_CARRIAGE_MODE;
+#endif
+
+// gcode parser
+GCodeParser parser;
+char *GCodeParser::command_ptr;
+char *GCodeParser::value_ptr;
+uint32_t GCodeParser::codebits;
+uint8_t GCodeParser::param[26];
+bool GCodeParser::binary_values;
+
+// Arduino
+static uint32_t host_micros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+}
+
+uint32_t millis() { return host_micros() / 1000; }
+uint32_t micros() { return host_micros(); }
+void delay(uint32_t ms) { (void)ms; }
+void delayMicroseconds(uint32_t us) { (void)us; }
@@ -0,0 +1,914 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ Replay planner blocks through the motion core on the host.
+
+ The blocks are the "blk: ..." lines logged with SHAPER_RECORD_BLOCKS, any
+ other line of the log is ignored, or a synthetic zig-zag with -s. They go
+ through MoveQueue, the input shapers and FuncManager exactly as in
+ Planner::shaped_loop(), and the step events are popped the way the stepper
+ ISR does.
+
+ Reported are steps per axis and the throughput of the whole pipeline in
+ steps/s on one core. -o writes the step timeline ("time_ms axis dir" per
+ step), -c compares against such a timeline and fails on any step count
+ difference or a time difference above -t microseconds. The steps are
+ compared axis by axis, the order in which steps of different axes are
+ popped follows the hand-off timing and is left out.
+
+ -j splits the acceleration phases into S-curve stages, stages per ramp and
+ the part of the phase a ramp takes. The block time, the peak acceleration
+ and the largest step of the acceleration between two moves, the jerk the
+ axes see, are reported for the trapezoid or S-curve profile.
+
+ -f feeds the blocks the way G-code comes in, rate blocks per second and a
+ pause of gap ms after every n blocks, against the print time of the steps.
+ The planner then holds at most -b blocks and the move queue -m moves, and
+ each time the steps run out while blocks are still to come is counted as
+ a starvation. The replay pads the motion with an empty move there and
+ waits for the next block, as the planner does when it runs dry.
+
+ Blocks are handed to the shaper through the hand-off window of the
+ firmware, ShapedWindow, once every -l ms of print time (1 by default), the
+ period of the marlin_loop that runs Planner::shaped_loop(). Its counts are reported: blocks handed over, waits
+ for one more block, stops forced while blocks were still to come, padding
+ moves, hand-offs after the steps had run past the motion handed over
+ (underruns), and the least motion left at a hand-off (min lead).
+
+ -p checks the probe contact worked out between steps, as SwitchDetect
+ latches it. Midway between two step events, the kept position of X, Y and
+ Z must be within half a step of the step count of the axis. The samples, the
+ matches and the largest distance of a mismatch from the step boundary are
+ reported, the check fails below PROBE_CHECK_MIN_MATCH of the samples.
+
+ -g plans the blocks of a G-code file, G0 to G3 in the XY plane, with
+ junction deviation and a reverse and forward pass like the planner. Its
+ arcs are cut into segments as plan_arc() does, with -n into arc blocks
+ whose moves follow the chords, as with ARC_NATIVE_MOVES. -a sets the chord
+ tolerance of the arc blocks in mm, ARC_CHORD_TOLERANCE by default. The arcs,
+ blocks, moves and the largest distance of a chord or segment from its arc
+ are reported, so both ways can be compared at the same tolerance.
+
+ usage: motion_replay [-x type,freq,zeta] [-y type,freq,zeta] [-k K] [-r rounds]
+                      [-o timeline.txt] [-c reference.txt] [-t us]
+                      [-j stages[,ramp]] [-f rate[,gap,n]] [-b blocks] [-m moves] [-l ms] [-p]
+                      [-s blocks[,mm] | -g file.gcode [-n [-a mm]] | log.txt]
+*/
+
+#include <algorithm>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "../../Marlin/src/module/AxisManager.h"
+#include "../../Marlin/src/module/shaper/ShapedWindow.h"
+
+struct RecordedBlock {
+    float millimeters, initial_speed, final_speed, cruise_speed, acceleration;
+    float axis_r[4];
+    int use_advance_lead;
+    float arc_theta, arc_rvec[2];
+    int arc_chords;
+};
+
+struct StepEvent {
+    double time;
+    int8_t axis;
+    int8_t dir;
+};
+
+static std::vector<RecordedBlock> blocks;
+static std::vector<StepEvent> timeline;
+static uint8_t block_head, block_planned, block_shaped, block_tail;
+// An empty move has been added behind the last block
+static bool padded;
+
+// Feed of the blocks and the buffer depths, see -f, -b and -m
+static float feed_rate, feed_gap;
+static int feed_every;
+static int block_depth = BLOCK_BUFFER_SIZE - 1;
+static int move_depth = MOVE_SIZE - 1;
+static double print_ms;
+static long starved;
+// Period of the marlin_loop that runs Planner::shaped_loop(), ms
+static float loop_ms = 1;
+
+// Profile of the moves, see -j
+static double profile_ms;
+static float peak_accel, peak_accel_step, last_accel;
+static long move_count;
+
+// Probe contact check, see -p
+#define PROBE_CHECK_MIN_MATCH 0.999
+static bool probe_check;
+static long probe_count[LINEAR_AXES];
+static long probe_samples, probe_matched, probe_uncovered;
+static float probe_worst;
+static time_double_t probe_last_time;
+
+static constexpr uint8_t next_block_index(const uint8_t block_index) { return BLOCK_MOD(block_index + 1); }
+static constexpr uint8_t prev_block_index(const uint8_t block_index) { return BLOCK_MOD(block_index - 1); }
+
+static bool load_blocks(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        const char *p = strstr(line, "blk: ");
+        RecordedBlock b = {};
+        // The arc of a block is only logged with ARC_NATIVE_MOVES
+        if (p && sscanf(p + 5, "%f %f %f %f %f %f %f %f %f %d %f %f %f %d", &b.millimeters, &b.initial_speed, &b.final_speed,
+                        &b.cruise_speed, &b.acceleration, &b.axis_r[0], &b.axis_r[1], &b.axis_r[2], &b.axis_r[3],
+                        &b.use_advance_lead, &b.arc_theta, &b.arc_rvec[0], &b.arc_rvec[1], &b.arc_chords) >= 10) {
+            blocks.push_back(b);
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// Short infill-like zig-zag at 250 mm/s with 10000 mm/s^2
+static void synthetic_blocks(int count, float length) {
+    const float steps_per_mm[4] = DEFAULT_AXIS_STEPS_PER_UNIT;
+    for (int i = 0; i < count; ++i) {
+        float dx = (i & 1) ? -length : length;
+        float dy = 0.4f + (i % 5) * 0.1f;
+        float de = 0.05f * sqrtf(dx * dx + dy * dy);
+        RecordedBlock b = {};
+        b.millimeters = sqrtf(dx * dx + dy * dy);
+        b.cruise_speed = 250;
+        b.acceleration = 10000;
+        b.initial_speed = i == 0 ? 0 : 8;
+        b.final_speed = i == count - 1 ? 0 : 8;
+        b.axis_r[0] = dx * steps_per_mm[0] / b.millimeters;
+        b.axis_r[1] = dy * steps_per_mm[1] / b.millimeters;
+        b.axis_r[2] = 0;
+        b.axis_r[3] = de * steps_per_mm[3] / b.millimeters;
+        b.use_advance_lead = 1;
+        blocks.push_back(b);
+    }
+}
+
+/*
+ Blocks of a G-code file, see -g. G0/G1 and G2/G3 in the XY plane, with I J
+ or R, are planned as the planner does: feed rate and acceleration limits
+ per axis, junction deviation between the blocks, then a reverse and a
+ forward pass over the whole file. An arc is cut into segments the way
+ plan_arc() does, or with -n into arc blocks as with ARC_NATIVE_MOVES.
+*/
+struct PathBlock {
+    RecordedBlock r;
+    float unit_start[4], unit_end[4];
+    float nominal_sqr, max_entry_sqr, entry_sqr;
+};
+
+static std::vector<PathBlock> path;
+static long path_steps[4];
+static float path_pos[4];
+static bool native_arcs;
+static float chord_tolerance = ARC_CHORD_TOLERANCE;
+static float path_sagitta;
+static long path_arcs;
+
+static void path_block(const float target[4], float fr_mm_s, float theta, const float rvec[2], int chords, float millimeters) {
+    const float steps_per_mm[4] = DEFAULT_AXIS_STEPS_PER_UNIT;
+    const float max_feedrate[4] = DEFAULT_MAX_FEEDRATE;
+    const float max_accel[4] = DEFAULT_MAX_ACCELERATION;
+
+    long steps[4];
+    float d[4];
+    bool moves = false;
+    for (int i = 0; i < 4; ++i) {
+        const long target_steps = lroundf(target[i] * steps_per_mm[i]);
+        steps[i] = target_steps - path_steps[i];
+        d[i] = steps[i] / steps_per_mm[i];
+        path_steps[i] = target_steps;
+        path_pos[i] = target[i];
+        moves |= steps[i] != 0;
+    }
+    if (!moves) {
+        return;
+    }
+
+    PathBlock b = {};
+    const bool e_only = !steps[0] && !steps[1] && !steps[2];
+    if (e_only) {
+        theta = 0;
+        millimeters = ABS(d[3]);
+    } else if (!theta) {
+        millimeters = sqrtf(sq(d[0]) + sq(d[1]) + sq(d[2]));
+    }
+
+    // The tangent of an arc turns, X and Y may move at the whole speed
+    float speed = fr_mm_s;
+    for (int i = 0; i < 4; ++i) {
+        const float axis_speed = theta && i < 2 ? speed : ABS(d[i]) / millimeters * speed;
+        if (axis_speed > max_feedrate[i]) {
+            speed *= max_feedrate[i] / axis_speed;
+        }
+    }
+    float accel = e_only ? DEFAULT_RETRACT_ACCELERATION : steps[3] ? DEFAULT_ACCELERATION : DEFAULT_TRAVEL_ACCELERATION;
+    for (int i = 0; i < 4; ++i) {
+        if (theta && i < 2) {
+            NOMORE(accel, _MIN(max_accel[0], max_accel[1]));
+        } else if (steps[i]) {
+            NOMORE(accel, max_accel[i] * millimeters / ABS(d[i]));
+        }
+    }
+    b.nominal_sqr = sq(speed);
+    if (theta) {
+        NOMORE(b.nominal_sqr, accel * HYPOT(rvec[0], rvec[1]));
+        b.r.arc_theta = theta;
+        b.r.arc_rvec[0] = rvec[0];
+        b.r.arc_rvec[1] = rvec[1];
+        b.r.arc_chords = chords;
+    }
+
+    b.r.millimeters = millimeters;
+    b.r.acceleration = accel;
+    b.r.cruise_speed = sqrtf(b.nominal_sqr);
+    for (int i = 0; i < 4; ++i) {
+        b.r.axis_r[i] = steps[i] / millimeters;
+    }
+    b.r.use_advance_lead = steps[3] && !e_only;
+
+    // Junction vectors, with E when it moves, an arc starts and ends along its tangent
+    float u[4] = { d[0], d[1], d[2], d[3] };
+    if (theta) {
+        u[0] = -rvec[1] * theta;
+        u[1] = rvec[0] * theta;
+    }
+    const float inv = steps[3] ? 1 / sqrtf(sq(u[0]) + sq(u[1]) + sq(u[2]) + sq(u[3])) : 1 / millimeters;
+    for (int i = 0; i < 4; ++i) {
+        b.unit_start[i] = b.unit_end[i] = u[i] * inv;
+    }
+    if (theta) {
+        b.unit_end[0] = b.unit_start[0] * cosf(theta) - b.unit_start[1] * sinf(theta);
+        b.unit_end[1] = b.unit_start[0] * sinf(theta) + b.unit_start[1] * cosf(theta);
+    }
+
+    if (!path.empty()) {
+        const PathBlock &prev = path.back();
+        float cos_theta = 0;
+        for (int i = 0; i < 4; ++i) {
+            cos_theta -= prev.unit_end[i] * b.unit_start[i];
+        }
+        float vmax_sqr;
+        if (cos_theta > 0.999999f) {
+            vmax_sqr = sq(float(MINIMUM_PLANNER_SPEED));
+        } else {
+            NOLESS(cos_theta, -0.999999f);
+            const float sin_theta_d2 = sqrtf(0.5f * (1.0f - cos_theta));
+            vmax_sqr = accel * JUNCTION_DEVIATION_MM * sin_theta_d2 / (1.0f - sin_theta_d2);
+            #if ENABLED(JD_HANDLE_SMALL_SEGMENTS)
+                if (millimeters < 1 && cos_theta < -0.7071067812f) {
+                    NOMORE(vmax_sqr, millimeters * accel / _MAX(acosf(-cos_theta), 0.033f));
+                }
+            #endif
+        }
+        b.max_entry_sqr = _MIN(vmax_sqr, b.nominal_sqr, prev.nominal_sqr);
+    }
+    path.push_back(b);
+}
+
+static void path_arc(const float target[4], const float offset[2], bool clockwise, float fr_mm_s) {
+    const float rvec[2] = { -offset[0], -offset[1] };
+    const float radius = HYPOT(rvec[0], rvec[1]),
+                center_x = path_pos[0] + offset[0], center_y = path_pos[1] + offset[1],
+                rt_x = target[0] - center_x, rt_y = target[1] - center_y;
+    uint16_t min_segments = MIN_ARC_SEGMENTS;
+    float angular_travel;
+    if (NEAR(path_pos[0], target[0]) && NEAR(path_pos[1], target[1])) {
+        angular_travel = clockwise ? -RADIANS(360) : RADIANS(360);
+    } else {
+        angular_travel = atan2f(rvec[0] * rt_y - rvec[1] * rt_x, rvec[0] * rt_x + rvec[1] * rt_y);
+        if (!angular_travel) {
+            return;
+        }
+        if (angular_travel < 0 && !clockwise) {
+            angular_travel += RADIANS(360);
+        } else if (angular_travel > 0 && clockwise) {
+            angular_travel -= RADIANS(360);
+        }
+        min_segments = _MAX(uint16_t(CEIL(min_segments * ABS(angular_travel) / RADIANS(360))), uint16_t(1));
+    }
+    const float linear_travel = target[2] - path_pos[2], extruder_travel = target[3] - path_pos[3],
+                flat_mm = radius * angular_travel,
+                mm_of_travel = linear_travel ? HYPOT(flat_mm, linear_travel) : ABS(flat_mm);
+    if (mm_of_travel < 0.001f) {
+        return;
+    }
+    path_arcs++;
+
+    uint16_t pieces, chords = 0;
+    if (native_arcs && radius > chord_tolerance) {
+        const float chord_theta = 2 * acosf(1 - chord_tolerance / radius);
+        const uint16_t all_chords = _MAX(uint16_t(CEIL(ABS(angular_travel) / chord_theta)), min_segments);
+        pieces = _MAX(CEIL(float(all_chords) / (ARC_BLOCK_CHORDS)), CEIL(ABS(angular_travel) / RADIANS(90)));
+        chords = CEIL(float(all_chords) / pieces);
+    } else {
+        pieces = _MAX(uint16_t(FLOOR(mm_of_travel / (MM_PER_ARC_SEGMENT))), min_segments);
+    }
+
+    const float theta_per_piece = angular_travel / pieces,
+                chord_angle = ABS(theta_per_piece) / (chords ? chords : 1);
+    NOLESS(path_sagitta, radius * (1 - cosf(chord_angle / 2)));
+    float raw[4] = { path_pos[0], path_pos[1], path_pos[2], path_pos[3] };
+    float piece_rvec[2] = { rvec[0], rvec[1] };
+    for (uint16_t i = 1; i <= pieces; ++i) {
+        const float cos_t = cosf(i * theta_per_piece), sin_t = sinf(i * theta_per_piece),
+                    next_rvec[2] = { rvec[0] * cos_t - rvec[1] * sin_t, rvec[0] * sin_t + rvec[1] * cos_t };
+        if (i == pieces) {
+            memcpy(raw, target, sizeof(raw));
+        } else {
+            raw[0] = center_x + next_rvec[0];
+            raw[1] = center_y + next_rvec[1];
+            raw[2] += linear_travel / pieces;
+            raw[3] += extruder_travel / pieces;
+        }
+        path_block(raw, fr_mm_s, chords ? theta_per_piece : 0, piece_rvec, chords, mm_of_travel / pieces);
+        piece_rvec[0] = next_rvec[0];
+        piece_rvec[1] = next_rvec[1];
+    }
+}
+
+// Reverse and forward pass over the whole path, it ends at rest
+static void plan_path() {
+    float exit_sqr = sq(float(MINIMUM_PLANNER_SPEED));
+    for (size_t i = path.size(); i--;) {
+        PathBlock &b = path[i];
+        b.entry_sqr = _MIN(b.max_entry_sqr, exit_sqr + 2 * b.r.acceleration * b.r.millimeters);
+        exit_sqr = b.entry_sqr;
+    }
+    for (size_t i = 1; i < path.size(); ++i) {
+        const PathBlock &prev = path[i - 1];
+        NOMORE(path[i].entry_sqr, prev.entry_sqr + 2 * prev.r.acceleration * prev.r.millimeters);
+    }
+    for (size_t i = 0; i < path.size(); ++i) {
+        RecordedBlock r = path[i].r;
+        r.initial_speed = sqrtf(path[i].entry_sqr);
+        r.final_speed = i + 1 < path.size() ? sqrtf(path[i + 1].entry_sqr) : float(MINIMUM_PLANNER_SPEED);
+        blocks.push_back(r);
+    }
+}
+
+static float gcode_word(const char *line, char letter, float value, bool *seen = nullptr) {
+    for (const char *p = line; *p; ++p) {
+        if (toupper(*p) == letter && (p == line || isspace(p[-1]))) {
+            if (seen) {
+                *seen = true;
+            }
+            return atof(p + 1);
+        }
+    }
+    return value;
+}
+
+static bool gcode_blocks(const char *path_name) {
+    FILE *f = fopen(path_name, "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    float fr_mm_s = 50;
+    bool relative = false, relative_e = false;
+    while (fgets(line, sizeof(line), f)) {
+        char *comment = strchr(line, ';');
+        if (comment) {
+            *comment = 0;
+        }
+        const char *p = line;
+        while (isspace(*p)) {
+            ++p;
+        }
+        const char code = toupper(*p);
+        const int n = atoi(p + 1);
+        if (code == 'M') {
+            relative_e = n == 83 ? true : n == 82 ? false : relative_e;
+            continue;
+        }
+        if (code != 'G') {
+            continue;
+        }
+        if (n == 90 || n == 91) {
+            relative = relative_e = n == 91;
+            continue;
+        }
+        if (n == 92) {
+            const float steps_per_mm[4] = DEFAULT_AXIS_STEPS_PER_UNIT;
+            path_pos[3] = gcode_word(p, 'E', path_pos[3]);
+            path_steps[3] = lroundf(path_pos[3] * steps_per_mm[3]);
+            continue;
+        }
+        if (n < 0 || n > 3) {
+            continue;
+        }
+
+        float target[4];
+        const char axes[4] = { 'X', 'Y', 'Z', 'E' };
+        for (int i = 0; i < 4; ++i) {
+            const bool rel = i == 3 ? relative_e : relative;
+            target[i] = rel ? path_pos[i] + gcode_word(p, axes[i], 0) : gcode_word(p, axes[i], path_pos[i]);
+        }
+        fr_mm_s = gcode_word(p, 'F', fr_mm_s * 60) / 60;
+
+        if (n < 2) {
+            path_block(target, fr_mm_s, 0, nullptr, 0, 0);
+            continue;
+        }
+        float offset[2] = { gcode_word(p, 'I', 0), gcode_word(p, 'J', 0) };
+        bool has_r = false;
+        const float r = gcode_word(p, 'R', 0, &has_r);
+        if (has_r && r && (target[0] != path_pos[0] || target[1] != path_pos[1])) {
+            const float e = (n == 2) ^ (r < 0) ? -1 : 1,
+                        dx = target[0] - path_pos[0], dy = target[1] - path_pos[1],
+                        d = HYPOT(dx, dy), h2 = (r - 0.5f * d) * (r + 0.5f * d), h = h2 >= 0 ? sqrtf(h2) : 0.0f;
+            offset[0] = 0.5f * dx + e * h * -dy / d;
+            offset[1] = 0.5f * dy + e * h * dx / d;
+        }
+        if (offset[0] || offset[1]) {
+            path_arc(target, offset, n == 2, fr_mm_s);
+        }
+    }
+    fclose(f);
+    plan_path();
+    return true;
+}
+
+// Acceleration in mm/ms^2 along the path of the moves of a block
+static void profile_block(block_t *block) {
+    profile_ms += block->shaper_data.block_time;
+    for (uint8_t i = block->shaper_data.move_start;; i = moveQueue.nextMoveIndex(i)) {
+        float a = moveQueue.moves[i].accelerate;
+        NOLESS(peak_accel, ABS(a));
+        NOLESS(peak_accel_step, ABS(a - last_accel));
+        last_accel = a;
+        move_count++;
+        if (i == block->shaper_data.move_end) {
+            break;
+        }
+    }
+}
+
+static bool parse_shaper(int axis, const char *arg) {
+    int type;
+    float freq, zeta;
+    if (sscanf(arg, "%d,%f,%f", &type, &freq, &zeta) != 3) {
+        return false;
+    }
+    AxisInputShaper *shaper = axis == X_AXIS ? &AxisInputShaper::axis_input_shaper_x : &AxisInputShaper::axis_input_shaper_y;
+    shaper->setConfig(type, freq, zeta);
+    return true;
+}
+
+/*
+ Print time at which the next block comes in. A full buffer holds the
+ sender back, the block after one that waited for room comes a block
+ interval after the push.
+*/
+static double feed_ms;
+static bool feed_held;
+
+static void feed_next(size_t pushed) {
+    if (feed_rate <= 0) {
+        return;
+    }
+    feed_ms = (feed_held ? print_ms : feed_ms) + 1000.0 / feed_rate;
+    feed_held = false;
+    if (feed_every > 0 && pushed % feed_every == 0) {
+        feed_ms += feed_gap;
+    }
+}
+
+static int blocks_queued() {
+    return BLOCK_MOD(block_head - block_tail);
+}
+
+static void push_block(const RecordedBlock &r) {
+    block_t *block = &planner.block_buffer[block_head];
+    memset((void *)block, 0, sizeof(block_t));
+    block->millimeters = r.millimeters;
+    block->initial_speed = r.initial_speed;
+    block->final_speed = r.final_speed;
+    block->cruise_speed = r.cruise_speed;
+    block->acceleration = r.acceleration;
+    block->axis_r.x = r.axis_r[0];
+    block->axis_r.y = r.axis_r[1];
+    block->axis_r.z = r.axis_r[2];
+    block->axis_r.e = r.axis_r[3];
+    TERN_(LIN_ADVANCE, block->use_advance_lead = r.use_advance_lead);
+    #if ENABLED(ARC_NATIVE_MOVES)
+        block->arc.theta = r.arc_theta;
+        block->arc.rvec.set(r.arc_rvec[0], r.arc_rvec[1]);
+        block->arc.chords = r.arc_chords;
+    #endif
+    block->shaper_data.init();
+    // The block before is final now, this one may still change
+    block_planned = block_head;
+    block_head = next_block_index(block_head);
+    padded = false;
+    shapedWindow.arrival(millis_t(print_ms));
+}
+
+/*
+ Planner::shaped_loop() on the print clock. The hand-off window, the wait
+ for one more block and the stop when none comes in time are decided by
+ ShapedWindow as in the firmware. The last block is still being planned
+ until the next one comes in. The input is exhausted once the stream has
+ ended, no block came in for SHAPED_INPUT_IDLE_TIME, or the steps ran out.
+*/
+// Moves of the block at index, false when the move queue has no room for them
+static bool calculate_block_moves(uint8_t &index, float &planed_time) {
+    block_t *block = &planner.block_buffer[index];
+    if (!block->shaper_data.is_create_move) {
+        if (!moveQueue.hasBlockRoom(block) || moveQueue.getMoveSize() + moveQueue.getBlockMoveSize(block) > move_depth) {
+            axisManager.counts[SHAPER_DBG_NOT_ENOUGH_MOVES_RESC]++;
+            return false;
+        }
+        moveQueue.calculateMoves(block);
+        profile_block(block);
+        block->shaper_data.is_create_move = true;
+    }
+    if (!block->shaper_data.is_zero_speed) {
+        planed_time += block->shaper_data.block_time;
+    }
+    index = next_block_index(index);
+    return true;
+}
+
+static void shaped_loop(bool input_exhausted) {
+    if (block_shaped == block_head) {
+        return;
+    }
+    float remaining_consume_time = axisManager.getRemainingConsumeTime();
+    const float waiting_time = shapedWindow.waitingTime(blocks_queued());
+    if (remaining_consume_time > waiting_time) {
+        return;
+    }
+
+    uint8_t index = block_shaped;
+    float planed_time = 0;
+    while (index != block_planned && calculate_block_moves(index, planed_time));
+
+    const float need_shaped_time = waiting_time + axisManager.shaped_right_delta;
+    if (shapedWindow.forceHandover(index != block_head, planed_time + remaining_consume_time, need_shaped_time,
+                                   axisManager.shaped_right_delta, input_exhausted)) {
+        while (index != block_head && planed_time + remaining_consume_time < need_shaped_time &&
+               calculate_block_moves(index, planed_time));
+        if (index == block_head || planed_time + remaining_consume_time < need_shaped_time) {
+            axisManager.addEmptyMove();
+            shapedWindow.pad();
+            padded = index == block_head;
+            block_t *block = &planner.block_buffer[prev_block_index(index)];
+            block->shaper_data.last_print_time += axisManager.shaped_left_delta;
+        }
+    }
+
+    block_planned = index;
+    if (block_shaped != block_planned) {
+        shapedWindow.handover(remaining_consume_time);
+    }
+
+    while (block_shaped != block_planned) {
+        block_t *block = &planner.block_buffer[block_shaped];
+        if (!block->shaper_data.is_zero_speed &&
+            (!axisManager.hasFuncParamsRoom(block) || !axisManager.generateAllAxisFuncParams(block_shaped, block))) {
+            break;
+        }
+        block_shaped = next_block_index(block_shaped);
+        shapedWindow.stats.handovers++;
+    }
+}
+
+/*
+ The contact as SwitchDetect::latch_probe_position() works it out for an
+ edge midway between the last step event and the next one: the step count
+ of each axis plus the part of a step from the kept position functions.
+ Samples the kept segments no longer cover are counted apart, the firmware
+ keeps the stop position for those.
+*/
+static void probe_sample(const time_double_t &next_time) {
+    // No edge falls between two step events at the same time
+    if (!(next_time > probe_last_time)) {
+        return;
+    }
+    const time_double_t edge_time = probe_last_time + (next_time - probe_last_time) / 2;
+    float pos[LINEAR_AXES];
+    LOOP_LINEAR_AXES(i) {
+        if (!axisManager.axis[i].func_manager.getKeptPos(edge_time, pos[i])) {
+            probe_uncovered++;
+            return;
+        }
+    }
+    probe_samples++;
+    bool match = true;
+    LOOP_LINEAR_AXES(i) {
+        // An axis at rest may sit right on the step boundary, either count holds there
+        const float beyond = ABS(pos[i] - probe_count[i]) - 0.5f;
+        if (beyond > 0) {
+            match = false;
+            NOLESS(probe_worst, beyond);
+        }
+    }
+    probe_matched += match;
+}
+
+/*
+ Pop step events like the stepper ISR for one loop period, see -l. Steps are
+ only taken up to the time every axis has been generated to, unless the
+ stream has ended.
+*/
+static bool consume_steps(bool flush, long steps[AXIS_SIZE], bool record) {
+    bool progress = false;
+    AxisStepper axis_stepper;
+    const double until_ms = print_ms + loop_ms;
+
+    axisManager.produceAxisSteppers();
+    while (axisManager.getAxisStepperSize() > 0) {
+        AxisStepper &next = axisManager.axis_steppers[axisManager.axis_steppper_tail];
+        if (!flush && next.print_time >= axisManager.min_last_time) {
+            break;
+        }
+        if (next.print_time.toDouble() > until_ms) {
+            // The next loop runs before this step is due
+            print_ms = until_ms;
+            return true;
+        }
+        axisManager.getNextAxisStepper(&axis_stepper);
+        axisManager.produceAxisSteppers();
+        progress = true;
+
+        if (probe_check) {
+            probe_sample(axis_stepper.print_time);
+        }
+        if (axis_stepper.axis >= 0 && axis_stepper.axis < AXIS_SIZE) {
+            steps[axis_stepper.axis]++;
+            if (axis_stepper.axis < LINEAR_AXES) {
+                probe_count[axis_stepper.axis] += axis_stepper.dir;
+            }
+        }
+        probe_last_time = axis_stepper.print_time;
+        print_ms = axis_stepper.print_time.toDouble();
+        if (record) {
+            StepEvent e = { axis_stepper.print_time.toDouble(), axis_stepper.axis, axis_stepper.dir };
+            timeline.push_back(e);
+        }
+
+        while (block_tail != block_shaped) {
+            block_t *block = &planner.block_buffer[block_tail];
+            if (!block->shaper_data.is_zero_speed && axis_stepper.print_time < block->shaper_data.last_print_time) {
+                break;
+            }
+            block_tail = next_block_index(block_tail);
+        }
+    }
+    return progress;
+}
+
+static void replay(long steps[AXIS_SIZE], bool record) {
+    moveQueue.reset();
+    axisManager.reset();
+    axisManager.addEmptyMove();
+    block_head = block_planned = block_shaped = block_tail = 0;
+    padded = false;
+    print_ms = feed_ms = 0;
+    shapedWindow.reset();
+    feed_held = false;
+    profile_ms = 0;
+    peak_accel = peak_accel_step = last_accel = 0;
+    move_count = 0;
+    ZERO(probe_count);
+    probe_last_time = 0;
+
+    size_t next = 0;
+    int idle = 0;
+    bool moving = false, starving = false;
+    while (idle < 3) {
+        bool pushed = false;
+        while (next < blocks.size() && feed_ms <= print_ms) {
+            if (blocks_queued() >= block_depth) {
+                feed_held = true;
+                break;
+            }
+            push_block(blocks[next++]);
+            feed_next(next);
+            pushed = true;
+            starving = false;
+        }
+
+        bool waiting = next < blocks.size() && feed_ms > print_ms;
+        uint8_t shaped = block_shaped;
+        shaped_loop(next == blocks.size() || starving || shapedWindow.inputIdle(millis_t(print_ms)));
+
+        bool flush = padded && block_shaped == block_head;
+        bool stepped = consume_steps(flush, steps, record);
+        bool progress = stepped || shaped != block_shaped || pushed;
+        moving |= stepped && !starving;
+
+        if (!progress && waiting) {
+            if (moving) {
+                // Out of steps before the next block came in, stop on an empty move
+                moving = false;
+                starving = true;
+                starved++;
+            } else {
+                // Standing until the next block comes in
+                print_ms = feed_ms;
+            }
+            progress = true;
+        }
+        idle = progress ? 0 : idle + 1;
+    }
+
+    // Free whatever is left in the planner buffer
+    block_tail = block_shaped = block_planned = block_head;
+}
+
+// Step events of one axis after another, in the order each axis took them
+static void sort_by_axis(std::vector<StepEvent> &events) {
+    std::stable_sort(events.begin(), events.end(),
+                     [](const StepEvent &a, const StepEvent &b) { return a.axis < b.axis; });
+}
+
+static int compare_timeline(const char *path, float tolerance_us) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "can not open %s\n", path);
+        return 1;
+    }
+    std::vector<StepEvent> reference;
+    double time;
+    int axis, dir;
+    while (fscanf(f, "%lf %d %d", &time, &axis, &dir) == 3) {
+        StepEvent e = { time, (int8_t)axis, (int8_t)dir };
+        reference.push_back(e);
+    }
+    fclose(f);
+
+    std::vector<StepEvent> replayed = timeline;
+    sort_by_axis(reference);
+    sort_by_axis(replayed);
+    size_t mismatch = reference.size() != replayed.size();
+    double max_diff = 0;
+    for (size_t i = 0; i < reference.size() && i < replayed.size(); i++) {
+        if (replayed[i].axis != reference[i].axis || replayed[i].dir != reference[i].dir) {
+            mismatch++;
+        } else {
+            double diff = fabs(replayed[i].time - reference[i].time) * 1000;
+            if (diff > max_diff) {
+                max_diff = diff;
+            }
+        }
+    }
+    printf("compare: %zu reference steps, %zu replayed, %zu mismatched, max diff %.3f us\n",
+           reference.size(), replayed.size(), mismatch, max_diff);
+    return mismatch || max_diff > tolerance_us ? 2 : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = nullptr;
+    const char *ref_path = nullptr;
+    const char *gcode_path = nullptr;
+    float tolerance_us = 1;
+    int rounds = 1;
+    int synthetic = 0;
+    float synthetic_mm = 40;
+    float K = 0;
+    int s_curve_stages = 0;
+    float s_curve_ramp = S_CURVE_RAMP_DEFAULT;
+
+    axisManager.input_shaper_reset();
+
+    int opt;
+    while ((opt = getopt(argc, argv, "x:y:k:r:o:c:t:s:j:f:b:m:g:a:l:np")) != -1) {
+        switch (opt) {
+            case 'x':
+            case 'y':
+                if (!parse_shaper(opt == 'x' ? X_AXIS : Y_AXIS, optarg)) {
+                    fprintf(stderr, "-%c expects type,freq,zeta\n", opt);
+                    return 1;
+                }
+                break;
+            case 'k': K = atof(optarg); break;
+            case 'r': rounds = atoi(optarg); NOLESS(rounds, 1); break;
+            case 'o': out_path = optarg; break;
+            case 'c': ref_path = optarg; break;
+            case 't': tolerance_us = atof(optarg); break;
+            case 's': sscanf(optarg, "%d,%f", &synthetic, &synthetic_mm); break;
+            case 'j': sscanf(optarg, "%d,%f", &s_curve_stages, &s_curve_ramp); break;
+            case 'f': sscanf(optarg, "%f,%f,%d", &feed_rate, &feed_gap, &feed_every); break;
+            case 'b': block_depth = atoi(optarg); LIMIT(block_depth, 1, BLOCK_BUFFER_SIZE - 1); break;
+            case 'g': gcode_path = optarg; break;
+            case 'n': native_arcs = true; break;
+            case 'l': loop_ms = atof(optarg); NOLESS(loop_ms, 0.01f); break;
+            case 'a': chord_tolerance = atof(optarg); NOLESS(chord_tolerance, 0.0001f); break;
+            case 'p': probe_check = true; break;
+            case 'm': move_depth = atoi(optarg); LIMIT(move_depth, 4, MOVE_SIZE - 1); break;
+            default:
+                fprintf(stderr, "usage: %s [-x t,f,z] [-y t,f,z] [-k K] [-r rounds] [-o out] [-c ref] [-t us] "
+                                "[-j stages[,ramp]] [-f rate[,gap,n]] [-b blocks] [-m moves] [-l ms] [-p] [-s blocks[,mm] | -g file.gcode [-n [-a mm]] | log]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (synthetic > 0) {
+        synthetic_blocks(synthetic, synthetic_mm);
+    } else if (gcode_path) {
+        if (!gcode_blocks(gcode_path)) {
+            fprintf(stderr, "can not open %s\n", gcode_path);
+            return 1;
+        }
+    } else if (optind >= argc || !load_blocks(argv[optind])) {
+        fprintf(stderr, "no block log given\n");
+        return 1;
+    }
+
+    const float steps_per_mm[] = DEFAULT_AXIS_STEPS_PER_UNIT;
+    for (int i = 0; i < DISTINCT_AXES; ++i) {
+        planner.settings.axis_steps_per_mm[i] = steps_per_mm[i < 4 ? i : 3];
+    }
+    for (int i = 0; i < EXTRUDERS; ++i) {
+        planner.extruder_advance_K[i] = K;
+    }
+    axisManager.init();
+    moveQueue.setSCurve(s_curve_stages, s_curve_ramp);
+
+    long steps[AXIS_SIZE] = {0};
+    bool record = out_path || ref_path;
+    clock_t st = clock();
+    for (int i = 0; i < rounds; ++i) {
+        replay(steps, record && i == 0);
+    }
+    double cpu_s = (double)(clock() - st) / CLOCKS_PER_SEC;
+
+    long total = 0;
+    for (int i = 0; i < AXIS_SIZE; ++i) {
+        total += steps[i];
+    }
+    printf("%zu blocks x %d, steps X %ld Y %ld Z %ld E %ld, %.3f s cpu, %.0f steps/s\n", blocks.size(), rounds,
+           steps[X_AXIS] / rounds, steps[Y_AXIS] / rounds, steps[Z_AXIS] / rounds, steps[E_AXIS] / rounds,
+           cpu_s, cpu_s > 0 ? total / cpu_s : 0);
+    printf("%s profile: %.1f ms of blocks, peak accel %.0f mm/s^2, largest accel step %.0f mm/s^2\n",
+           s_curve_stages ? "s-curve" : "trapezoid", profile_ms, peak_accel * 1e6, peak_accel_step * 1e6);
+    if (gcode_path) {
+        printf("%ld arcs as %s: %zu blocks, %ld moves, chords up to %.4f mm from the arc\n", path_arcs,
+               native_arcs ? "arc blocks" : "segments", path.size(), move_count, path_sagitta);
+    }
+    if (s_curve_stages) {
+        printf("  %d stages per ramp, ramp %.2f of each phase\n", moveQueue.s_curve_stages, moveQueue.s_curve_ramp);
+    }
+    if (feed_rate > 0) {
+        printf("fed at %.0f blocks/s, %.0f ms gap every %d: %d blocks, %d moves deep, starved %ld times\n",
+               feed_rate, feed_gap, feed_every, block_depth, move_depth, starved / rounds);
+    }
+    const shaped_stats_t &hand_off = shapedWindow.stats;
+    printf("hand-off: %u blocks, %u deferred, %u forced stops, %u padded, %u underruns, min lead %.1f ms, "
+           "block gap %.2f ms\n", (unsigned)hand_off.handovers, (unsigned)hand_off.deferred, (unsigned)hand_off.starved,
+           (unsigned)hand_off.padding, (unsigned)hand_off.underruns, hand_off.min_remaining, shapedWindow.arrival_gap);
+
+    if (out_path) {
+        FILE *f = fopen(out_path, "w");
+        if (!f) {
+            fprintf(stderr, "can not open %s\n", out_path);
+            return 1;
+        }
+        for (size_t i = 0; i < timeline.size(); ++i) {
+            fprintf(f, "%.6f %d %d\n", timeline[i].time, timeline[i].axis, timeline[i].dir);
+        }
+        fclose(f);
+    }
+
+    if (probe_check) {
+        const float rate = probe_samples ? float(probe_matched) / probe_samples : 0;
+        printf("probe contact: %ld samples, %.3f%% matched, mismatches %.4f step past a boundary, %ld not kept\n",
+               probe_samples, rate * 100, probe_worst, probe_uncovered);
+        if (rate < PROBE_CHECK_MIN_MATCH) {
+            return 2;
+        }
+    }
+
+    return ref_path ? compare_timeline(ref_path, tolerance_us) : 0;
+}
@@ -0,0 +1,391 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ Flash simulator for the power-loss log.
+
+ The power-loss pages are a RAM array behind FLASH_ProgramWord() and
+ FLASH_ErasePage() with NOR semantics, a program only clears bits, and
+ every word program and page erase is timed with the typical figures of
+ the GD32F30x data flash (-w and -e to change them).
+
+ Reported is the flash time of the power-fail path: the old write of the
+ whole power_loss_t against the delta record, and the worst case of the
+ log with a state record and the job not written yet.
+
+ Then power is cut at every word of an append, with a random half written
+ word at the cut, and the log must give the last complete record of each
+ type after a rescan. A log with records torn that way is filled until it
+ is full and every valid record must still be found.
+
+ A page is started the way journal() moves the job and the state on, with
+ the power cut at every word and at the erase. After a rescan the log must
+ give either the old records or the moved ones, and the page in use must
+ be untouched. A start is dropped when the power-fail path appends to the
+ page in use in between, and a clear hides the records until the next one.
+
+ build: make -C snapmaker/host
+ usage: power_loss_flash_sim [-w word_us] [-e erase_ms] [cases]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <libmaple/libmaple_types.h>
+#include "flash_stm32.h"
+#include "../module/power_loss.h"
+
+#define SIM_BASE        0x080FB000UL
+#define SIM_SIZE        (8 * 1024)
+#define SIM_PAGE_SIZE   (4 * 1024)
+
+static uint8_t flash[SIM_SIZE];
+static bool locked = true;
+static long cut_after = -1;     // words left until the power cut, -1 for none
+static uint32_t words, erases;
+
+const uint8_t *flash_sim_map(uint32_t addr) {
+  if (addr < SIM_BASE || addr >= SIM_BASE + SIM_SIZE) {
+    printf("read out of the power-loss pages: 0x%08x\n", addr);
+    exit(1);
+  }
+  return flash + (addr - SIM_BASE);
+}
+
+extern "C" {
+
+void FLASH_Unlock(void) { locked = false; }
+void FLASH_Lock(void) { locked = true; }
+
+FLASH_Status FLASH_ProgramWord(uint32 Address, uint32 Data) {
+  if (locked || cut_after == 0) {
+    return FLASH_ERROR_PG;
+  }
+  if (Address & 3 || Address < SIM_BASE || Address >= SIM_BASE + SIM_SIZE) {
+    return FLASH_BAD_ADDRESS;
+  }
+  uint32_t word;
+  memcpy(&word, flash + (Address - SIM_BASE), 4);
+  if (cut_after > 0 && --cut_after == 0) {
+    // Cut while programming: some of the bits get cleared, not all
+    uint32_t zeros = ~Data;
+    uint32_t left = ((uint32_t)rand() | ((uint32_t)rand() << 16)) & zeros;
+    Data |= left ? left : zeros & -zeros;
+  }
+  word &= Data;
+  memcpy(flash + (Address - SIM_BASE), &word, 4);
+  words++;
+  return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ErasePage(uint32 Page_Address) {
+  if (locked || cut_after == 0 || Page_Address < SIM_BASE || Page_Address >= SIM_BASE + SIM_SIZE) {
+    return FLASH_ERROR_PG;
+  }
+  memset(flash + ((Page_Address - SIM_BASE) & ~(SIM_PAGE_SIZE - 1)), 0xFF, SIM_PAGE_SIZE);
+  erases++;
+  return FLASH_COMPLETE;
+}
+
+}
+
+static int failures;
+
+#define CHECK(cond, ...) do { if (!(cond)) { printf(__VA_ARGS__); printf("\n"); failures++; } } while (0)
+
+static void fill(void *data, uint16_t len, uint32_t seed) {
+  uint8_t *p = (uint8_t *)data;
+  for (uint16_t i = 0; i < len; i++) {
+    p[i] = (uint8_t)(seed * 131 + i * 7 + (seed >> 8));
+  }
+}
+
+// A delta as write_flash() appends it, the seed goes in file_position
+static pl_delta_t delta_of(uint32_t seed) {
+  pl_delta_t d;
+  fill(&d, sizeof(d), seed);
+  d.file_position = seed;
+  return d;
+}
+
+// Blank pages and a started first page, as after the first start_job()
+static void fresh(PowerLossLog &log) {
+  memset(flash, 0xFF, sizeof(flash));
+  log.init(SIM_BASE, SIM_SIZE, SIM_PAGE_SIZE);
+  log.start_page();
+  log.start_page_done();
+}
+
+static double flash_ms(uint32_t w, uint32_t e, double word_us, double erase_ms) {
+  return w * word_us / 1000 + e * erase_ms;
+}
+
+static void report_power_fail(double word_us, double erase_ms) {
+  PowerLossLog log;
+  fresh(log);
+
+  pl_job_t job;
+  pl_state_t state;
+  fill(&job, sizeof(job), 1);
+  fill(&state, sizeof(state), 2);
+  pl_delta_t delta = delta_of(3);
+
+  // Before: the whole power_loss_t word by word
+  uint32_t legacy = (sizeof(power_loss_t) + 3) / 4;
+
+  log.append(PL_RECORD_JOB, &job, sizeof(job));
+  log.append(PL_RECORD_STATE, &state, sizeof(state));
+  words = erases = 0;
+  log.append(PL_RECORD_DELTA, &delta, sizeof(delta));
+  uint32_t typical = words;
+
+  fresh(log);
+  words = erases = 0;
+  log.append(PL_RECORD_JOB, &job, sizeof(job));
+  log.append(PL_RECORD_STATE, &state, sizeof(state));
+  log.append(PL_RECORD_DELTA, &delta, sizeof(delta));
+  uint32_t no_job = words;
+
+  fresh(log);
+  log.append(PL_RECORD_JOB, &job, sizeof(job));
+  words = erases = 0;
+  log.append(PL_RECORD_STATE, &state, sizeof(state));
+  log.append(PL_RECORD_DELTA, &delta, sizeof(delta));
+  uint32_t state_changed = words;
+
+  printf("record bytes: power_loss_t %u, job %u, state %u, delta %u\n",
+         (unsigned)sizeof(power_loss_t), (unsigned)sizeof(pl_job_t),
+         (unsigned)sizeof(pl_state_t), (unsigned)sizeof(pl_delta_t));
+  printf("power-fail path at %.1f us/word:\n", word_us);
+  printf("  power_loss_t write       %4u words %7.2f ms\n", legacy, flash_ms(legacy, 0, word_us, erase_ms));
+  printf("  delta                    %4u words %7.2f ms  %.1fx\n", typical,
+         flash_ms(typical, 0, word_us, erase_ms), (double)legacy / typical);
+  printf("  state changed + delta    %4u words %7.2f ms  %.1fx\n", state_changed,
+         flash_ms(state_changed, 0, word_us, erase_ms), (double)legacy / state_changed);
+  printf("  no job record, fallback  %4u words %7.2f ms  %.1fx\n", no_job,
+         flash_ms(no_job, 0, word_us, erase_ms), (double)legacy / no_job);
+  printf("  page erase, page start only       %7.2f ms\n", flash_ms(0, 1, word_us, erase_ms));
+}
+
+// Cut the power at every word of a delta append
+static void torn_appends(long cases) {
+  PowerLossLog log;
+  pl_job_t job;
+  pl_state_t state;
+  fill(&job, sizeof(job), 10);
+  fill(&state, sizeof(state), 11);
+  uint32_t record_words = sizeof(pl_delta_t) / 4 + 1;
+
+  for (long c = 0; c < cases; c++) {
+    for (uint32_t cut = 1; cut <= record_words; cut++) {
+      fresh(log);
+      log.append(PL_RECORD_JOB, &job, sizeof(job));
+      log.append(PL_RECORD_STATE, &state, sizeof(state));
+      pl_delta_t before = delta_of(100 + c);
+      log.append(PL_RECORD_DELTA, &before, sizeof(before));
+
+      pl_delta_t torn = delta_of(200 + c);
+      cut_after = cut;
+      log.append(PL_RECORD_DELTA, &torn, sizeof(torn));
+      cut_after = -1;
+
+      // Power back: scan, then a new print's records after the torn one
+      log.scan();
+      const pl_delta_t *d = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+      CHECK(d && !memcmp(d, &before, sizeof(pl_delta_t)),
+            "cut at word %u of %u: wrong delta", cut, record_words);
+      CHECK(log.newest(PL_RECORD_JOB, sizeof(pl_job_t)) && log.newest(PL_RECORD_STATE, sizeof(pl_state_t)),
+            "cut at word %u: job or state lost", cut);
+
+      pl_delta_t after = delta_of(300 + c);
+      CHECK(log.append(PL_RECORD_DELTA, &after, sizeof(after)), "cut at word %u: no append after", cut);
+      d = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+      CHECK(d && !memcmp(d, &after, sizeof(after)), "cut at word %u: append after is lost", cut);
+    }
+  }
+  printf("%ld x %u cuts in a delta append, newest complete record found\n", cases, record_words);
+}
+
+// Random records with random cuts until the log is full
+static void fill_log(long cases) {
+  PowerLossLog log;
+  uint32_t appended = 0, torn = 0;
+  for (long c = 0; c < cases; c++) {
+    fresh(log);
+    pl_delta_t last;
+    bool have = false;
+    for (uint32_t n = 0; ; n++) {
+      pl_delta_t d = delta_of(c * 1000 + n);
+      if (rand() % 4 == 0) {
+        cut_after = 1 + rand() % (sizeof(d) / 4 + 1);
+      }
+      bool ok = log.append(PL_RECORD_DELTA, &d, sizeof(d));
+      bool cut = cut_after == 0;
+      cut_after = -1;
+      if (!ok) {
+        break;
+      }
+      log.scan();
+      const pl_delta_t *found = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+      if (!cut) {
+        last = d;
+        have = true;
+      }
+      torn += cut;
+      CHECK(have ? found && !memcmp(found, &last, sizeof(last)) : !found,
+            "case %ld record %u: newest delta wrong", c, n);
+      appended++;
+    }
+  }
+  printf("%ld logs filled with %u deltas, %u of them torn\n", cases, appended, torn);
+}
+
+// Records of a page as journal() leaves them
+static void fill_page(PowerLossLog &log, uint32_t seed, bool with_delta) {
+  pl_job_t job;
+  pl_state_t state;
+  fill(&job, sizeof(job), seed);
+  fill(&state, sizeof(state), seed + 1);
+  log.append(PL_RECORD_JOB, &job, sizeof(job));
+  log.append(PL_RECORD_STATE, &state, sizeof(state));
+  if (with_delta) {
+    pl_delta_t delta = delta_of(seed + 2);
+    log.append(PL_RECORD_DELTA, &delta, sizeof(delta));
+  }
+}
+
+// The job and state of a page as fill_page() wrote them with seed
+static bool page_is(PowerLossLog &log, uint32_t seed) {
+  pl_job_t job;
+  pl_state_t state;
+  fill(&job, sizeof(job), seed);
+  fill(&state, sizeof(state), seed + 1);
+  const void *j = log.newest(PL_RECORD_JOB, sizeof(pl_job_t));
+  const void *s = log.newest(PL_RECORD_STATE, sizeof(pl_state_t));
+  return j && s && !memcmp(j, &job, sizeof(job)) && !memcmp(s, &state, sizeof(state));
+}
+
+// Cut the power at every flash operation of a page start, for both pages
+static void page_starts() {
+  PowerLossLog log;
+  static uint8_t before[SIM_SIZE];
+  uint32_t starts = 0, kept = 0;
+  for (int round = 0; round < 3; round++) {
+    for (long cut = 0; ; cut++) {
+      fresh(log);
+      // Move the first page on round times, so the page in use and the other
+      // page both hold records
+      for (int r = 0; r < round; r++) {
+        fill_page(log, 10 + r * 10, false);
+        log.start_page();
+        log.start_page_done();
+      }
+      fill_page(log, 500, true);
+      memcpy(before, flash, sizeof(flash));
+
+      pl_job_t job;
+      pl_state_t state;
+      fill(&job, sizeof(job), 600);
+      fill(&state, sizeof(state), 601);
+      cut_after = cut ? cut : 0;
+      bool done = log.start_page() && log.keep(PL_RECORD_JOB, &job, sizeof(job)) &&
+                  log.keep(PL_RECORD_STATE, &state, sizeof(state)) && log.start_page_done();
+      bool was_cut = cut_after == 0;
+      cut_after = -1;
+      starts++;
+
+      log.scan();
+      if (!was_cut) {
+        CHECK(done && page_is(log, 600), "round %d: page start without a cut failed", round);
+        break;
+      }
+      bool old = page_is(log, 500);
+      kept += old;
+      CHECK(old || page_is(log, 600), "round %d cut %ld: neither the old nor the moved records", round, cut);
+      if (old) {
+        const pl_delta_t *d = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+        pl_delta_t delta = delta_of(502);
+        CHECK(d && !memcmp(d, &delta, sizeof(delta)), "round %d cut %ld: delta of the old page lost", round, cut);
+      }
+      // The page in use is never written, only the other page
+      uint32_t changed = 0;
+      for (uint32_t p = 0; p < SIM_SIZE; p += SIM_PAGE_SIZE) {
+        changed += memcmp(before + p, flash + p, SIM_PAGE_SIZE) != 0;
+      }
+      CHECK(changed <= 1, "round %d cut %ld: both pages changed", round, cut);
+    }
+  }
+
+  // The power-fail path appends while a page is started: the start is dropped
+  fresh(log);
+  fill_page(log, 700, false);
+  pl_job_t job;
+  fill(&job, sizeof(job), 800);
+  log.start_page();
+  log.keep(PL_RECORD_JOB, &job, sizeof(job));
+  pl_delta_t delta = delta_of(702);
+  log.append(PL_RECORD_DELTA, &delta, sizeof(delta));
+  CHECK(!log.start_page_done(), "start not dropped after an append to the page in use");
+  log.scan();
+  const pl_delta_t *d = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+  CHECK(page_is(log, 700) && d && !memcmp(d, &delta, sizeof(delta)), "records lost after a dropped start");
+
+  // A clear hides the records, also after a rescan, without an erase
+  erases = 0;
+  CHECK(log.clear() && log.empty() && !log.newest(PL_RECORD_JOB, sizeof(pl_job_t)), "clear left records");
+  log.scan();
+  CHECK(log.empty() && !log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t)) && !erases, "clear lost by a rescan");
+  fill_page(log, 900, true);
+  log.scan();
+  CHECK(page_is(log, 900), "records after a clear lost");
+
+  printf("%u page starts, %u cut at the erase or a word, the old records kept by %u\n", starts, starts - 3, kept);
+}
+
+int main(int argc, char **argv) {
+  double word_us = 40.0;     // GD32F30x word program, typical
+  double erase_ms = 45.0;    // 4 KB page erase, typical
+  long cases = 200;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-w") && i + 1 < argc) {
+      word_us = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+      erase_ms = atof(argv[++i]);
+    } else {
+      cases = atol(argv[i]);
+    }
+  }
+  srand(1);
+
+  report_power_fail(word_us, erase_ms);
+  torn_appends(cases);
+  fill_log(cases / 10 + 1);
+  page_starts();
+
+  if (failures) {
+    printf("%d FAILED\n", failures);
+    return 1;
+  }
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Equivalence check and benchmark of the SACP CRC-8 and checksum.
+
+ sacp_calc_crc8() and sacp_calc_checksum() are compared with the original
+ bit by bit versions in sacp_reference.h on random buffers of every length
+ up to PACK_PACKET_MAX_SIZE, at every alignment, plus all zero and all 0xFF
+ buffers. Then both are timed on whole frames, header CRC plus payload
+ checksum, for typical frame sizes.
+
+ build: make -C snapmaker/host
+ usage: sacp_crc_bench [fuzz cases]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../protocol/protocol_sacp.h"
+#include "sacp_reference.h"
+
+#define BENCH_BYTES (64 * 1024 * 1024)
+
+static uint8_t buffer[PACK_PACKET_MAX_SIZE + 8];
+
+static uint32_t next_rand() {
+  static uint32_t seed = 12345;
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static bool same(uint8_t *data, uint16_t len) {
+  bool ok = sacp_calc_checksum(data, len) == reference_checksum(data, len);
+  ok = ok && sacp_calc_crc8(data, len) == reference_crc8(data, len);
+  if (!ok) {
+    printf("MISMATCH len %u align %u\n", len, (unsigned)((uintptr_t)data & 3));
+  }
+  return ok;
+}
+
+static bool fuzz(long cases) {
+  for (uint16_t len = 0; len <= PACK_PACKET_MAX_SIZE; len++) {
+    for (int align = 0; align < 4; align++) {
+      memset(buffer, 0, sizeof(buffer));
+      if (!same(buffer + align, len)) return false;
+      memset(buffer, 0xFF, sizeof(buffer));
+      if (!same(buffer + align, len)) return false;
+    }
+  }
+  for (long i = 0; i < cases; i++) {
+    uint16_t len = next_rand() % (PACK_PACKET_MAX_SIZE + 1);
+    int align = next_rand() % 4;
+    for (uint16_t j = 0; j < len; j++) {
+      buffer[align + j] = (uint8_t)next_rand();
+    }
+    if (!same(buffer + align, len)) return false;
+  }
+  return true;
+}
+
+// Header CRC and payload checksum of a frame of size bytes, like parse()
+template <bool REFERENCE>
+static double frame_ns(uint16_t size) {
+  long frames = BENCH_BYTES / size;
+  volatile uint32_t sink = 0;
+  auto st = std::chrono::steady_clock::now();
+  for (long i = 0; i < frames; i++) {
+    buffer[0] = (uint8_t)i;
+    if (REFERENCE) {
+      sink += reference_crc8(buffer, 6) + reference_checksum(buffer + 7, size - 9);
+    } else {
+      sink += sacp_calc_crc8(buffer, 6) + sacp_calc_checksum(buffer + 7, size - 9);
+    }
+  }
+  auto et = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(et - st).count() / frames;
+}
+
+int main(int argc, char **argv) {
+  long cases = argc > 1 ? atol(argv[1]) : 1000000;
+  if (!fuzz(cases)) {
+    return 2;
+  }
+  printf("%ld random buffers and all lengths 0-%d identical\n", cases, PACK_PACKET_MAX_SIZE);
+
+  for (int i = 0; i < PACK_PACKET_MAX_SIZE; i++) {
+    buffer[i] = (uint8_t)next_rand();
+  }
+  const uint16_t sizes[] = {9, 16, 32, 64, 128, 256, 512};
+  printf("frame  bitwise ns  MB/s    table ns  MB/s\n");
+  for (uint16_t size : sizes) {
+    double ref = frame_ns<true>(size);
+    double now = frame_ns<false>(size);
+    printf("%5u  %10.1f  %6.0f  %8.1f  %6.0f\n", size, ref, size / ref * 1000, now, size / now * 1000);
+  }
+  return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Host loopback benchmark of the SACP receive path.
+
+ A stream of packets, G-code packs and short requests mixed with line noise
+ and packets with a broken checksum, is pushed through the libmaple RX ring
+ buffer in bursts of random length as the USART interrupt would. Each burst
+ is drained by one of the receive paths:
+
+   per byte  rb_remove() and the old one byte ProtocolSACP::parse() with
+             the original CRC and checksum, then the payload is copied
+             byte by byte into the event parameters
+   bulk      rb_span() / rb_skip() and the run based ProtocolSACP::parse(),
+             packets are checked in the ring and copied once with memcpy
+
+ Both must deliver the same packets. Reported are bytes/s through the
+ loopback and the receive CPU time per byte, with the cost of filling the
+ ring taken out.
+
+ build: make -C snapmaker/host
+ usage: sacp_recv_bench [MB]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../protocol/protocol_sacp.h"
+#include <libmaple/ring_buffer.h>
+#include "sacp_reference.h"
+
+#define RX_BUF_SIZE 1024
+#define BENCH_ROUNDS 5
+
+struct Delivered {
+  long packets;
+  uint32_t sum;
+  uint8_t data[PACK_PARSE_MAX_SIZE];
+};
+
+static std::vector<uint8_t> stream;
+static long expect_packets;
+static uint8_t rx_storage[RX_BUF_SIZE];
+static ring_buffer rb;
+
+// The receive path before the bulk parser, one byte per call
+static ErrCode legacy_parse(uint8_t *data, uint16_t len, SACP_param_t &out) {
+  uint8_t *parse_buff = out.buff;
+  if (parse_buff[0] != SACP_PDU_SOF_H) {
+    out.lenght = 0;
+  }
+  for (uint16_t i = 0; i < len; i++) {
+    uint8_t ch = data[i];
+    if (out.lenght == 0) {
+      if (ch == SACP_PDU_SOF_H) {
+        parse_buff[out.lenght++] = ch;
+      }
+    } else if (out.lenght == 1) {
+      if (ch == SACP_PDU_SOF_L) {
+        parse_buff[out.lenght++] = ch;
+      } else {
+        out.lenght = 0;
+      }
+    } else {
+      parse_buff[out.lenght++] = ch;
+    }
+
+    if (out.lenght < 7) {
+      break;
+    }
+    else if (out.lenght == 7) {
+      if (reference_crc8(parse_buff, 6) != parse_buff[6]) {
+        out.lenght = 0;
+      }
+    }
+    else {
+      uint16_t data_len = (parse_buff[3] << 8 | parse_buff[2]);
+      uint16_t total_len = data_len + 7;
+      if (out.lenght == total_len) {
+        uint16_t checksum = reference_checksum(&parse_buff[7], data_len - 2);
+        uint16_t checksum1 = (parse_buff[total_len - 1] << 8) | parse_buff[total_len - 2];
+        out.lenght = 0;
+        return checksum == checksum1 ? E_SUCCESS : E_PARAM;
+      } else if (out.lenght > total_len) {
+        out.lenght = 0;
+        return E_PARAM;
+      }
+    }
+  }
+  return E_IN_PROGRESS;
+}
+
+static uint32_t next_rand() {
+  static uint32_t seed = 12345;
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static void build_stream(size_t bytes) {
+  uint8_t payload[PACK_PARSE_MAX_SIZE];
+  uint8_t packet[PACK_PACKET_MAX_SIZE];
+  SACP_head_base_t head = {SACP_ID_CONTROLLER, SACP_ATTR_ACK, 0, 0xAC, 0x02};
+  stream.clear();
+  expect_packets = 0;
+  while (stream.size() < bytes) {
+    // Mostly G-code packs near the size limit, some short requests
+    uint16_t len = (next_rand() % 4) ? 300 + next_rand() % 190 : 1 + next_rand() % 24;
+    for (uint16_t i = 0; i < len; i++) {
+      payload[i] = (uint8_t)next_rand();
+    }
+    head.sequence++;
+    uint16_t n = protocol_sacp.package(head, payload, len, packet);
+    bool broken = next_rand() % 50 == 0;
+    if (broken) {
+      packet[n - 1] ^= 0x5A;
+    } else {
+      expect_packets++;
+    }
+    if (next_rand() % 20 == 0) {
+      // Line noise, no start of frame in it
+      for (int i = next_rand() % 16; i > 0; i--) {
+        stream.push_back((uint8_t)(next_rand() % SACP_PDU_SOF_H));
+      }
+    }
+    stream.insert(stream.end(), packet, packet + n);
+  }
+}
+
+static void deliver_per_byte(Delivered &out, SACP_struct_t *packet) {
+  uint16_t length = packet->length - 8;
+  // The payload follows the packet head in the receive buffer
+  const uint8_t *data = (const uint8_t *)packet + sizeof(SACP_struct_t);
+  for (uint32_t i = 0; i < length; i++) {
+    out.data[i] = data[i];
+  }
+  out.packets++;
+  out.sum += out.data[0] + out.data[length - 1] + length;
+}
+
+static void deliver_bulk(Delivered &out, SACP_struct_t *packet) {
+  uint16_t length = packet->length - 8;
+  memcpy(out.data, packet->data, length);
+  out.packets++;
+  out.sum += out.data[0] + out.data[length - 1] + length;
+}
+
+static void drain_per_byte(SACP_param_t &params, Delivered &out) {
+  while (!rb_is_empty(&rb)) {
+    uint8_t data = rb_remove(&rb);
+    if (legacy_parse(&data, 1, params) == E_SUCCESS) {
+      deliver_per_byte(out, &params.sacp);
+    }
+  }
+}
+
+static void drain_bulk(SACP_param_t &params, Delivered &out) {
+  uint8_t *data;
+  uint16_t len;
+  while ((len = rb_span(&rb, &data)) > 0) {
+    uint16_t offset = 0;
+    while (offset < len) {
+      uint16_t used;
+      SACP_struct_t *packet;
+      ErrCode ret = protocol_sacp.parse(data + offset, len - offset, params, used, packet);
+      offset += used;
+      if (ret == E_SUCCESS) {
+        deliver_bulk(out, packet);
+      }
+    }
+    rb_skip(&rb, len);
+  }
+}
+
+// Feed the stream in bursts like the RX interrupt, mode 0 only fills
+static double loopback(int mode, Delivered &out) {
+  static SACP_param_t params;
+  memset(&params, 0, sizeof(params));
+  memset(&out, 0, sizeof(out));
+  rb_init(&rb, RX_BUF_SIZE, rx_storage);
+  uint32_t seed = 1;
+
+  auto st = std::chrono::steady_clock::now();
+  size_t pos = 0;
+  while (pos < stream.size()) {
+    seed = seed * 1103515245 + 12345;
+    size_t burst = 1 + (seed >> 8) % 256;
+    if (burst > stream.size() - pos) {
+      burst = stream.size() - pos;
+    }
+    for (size_t i = 0; i < burst; i++) {
+      rb_insert(&rb, stream[pos++]);
+    }
+    if (mode == 0) {
+      rb_reset(&rb);
+    } else if (mode == 1) {
+      drain_per_byte(params, out);
+    } else {
+      drain_bulk(params, out);
+    }
+  }
+  auto et = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(et - st).count();
+}
+
+int main(int argc, char **argv) {
+  double mb = argc > 1 ? atof(argv[1]) : 4;
+  build_stream((size_t)(mb * 1024 * 1024));
+
+  static Delivered result[3];
+  double best[3] = {1e9, 1e9, 1e9};
+  for (int r = 0; r < BENCH_ROUNDS; r++) {
+    for (int mode = 0; mode < 3; mode++) {
+      double t = loopback(mode, result[mode]);
+      if (t < best[mode]) {
+        best[mode] = t;
+      }
+    }
+  }
+
+  const char *name[3] = {"fill only", "per byte", "bulk"};
+  double bytes = (double)stream.size();
+  printf("%u bytes, %ld packets\n", (unsigned)stream.size(), expect_packets);
+  printf("path       packets      MB/s  rx ns/byte\n");
+  for (int mode = 1; mode < 3; mode++) {
+    double rx = best[mode] > best[0] ? best[mode] - best[0] : 0;
+    printf("%-9s  %7ld  %8.1f  %10.2f\n", name[mode], result[mode].packets, bytes / best[mode] / 1e6, rx * 1e9 / bytes);
+  }
+
+  bool same = result[1].packets == expect_packets && result[2].packets == expect_packets && result[1].sum == result[2].sum;
+  if (!same) {
+    printf("MISMATCH\n");
+  }
+  return same ? 0 : 2;
+}
@@ -0,0 +1,66 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*
+ The original bit by bit SACP CRC-8 and checksum, kept as the reference the
+ host benchmarks compare the firmware implementation against.
+*/
+
+#include <stdint.h>
+
+static inline uint8_t reference_crc8(uint8_t *buffer, uint16_t len) {
+  int crc = 0x00;
+  int poly = 0x07;
+  for (int i = 0; i < len; i++) {
+    for (int j = 0; j < 8; j++) {
+      bool bit = ((buffer[i] >> (7 - j) & 1) == 1);
+      bool c07 = ((crc >> 7 & 1) == 1);
+      crc <<= 1;
+      if (c07 ^ bit) {
+        crc ^= poly;
+      }
+    }
+  }
+  crc &= 0xff;
+  return crc;
+}
+
+static inline uint16_t reference_checksum(uint8_t *buffer, uint16_t length) {
+  uint32_t volatile checksum = 0;
+
+  if (!length || !buffer)
+    return 0;
+
+  for (int j = 0; j < (length - 1); j = j + 2)
+    checksum += (uint32_t)(buffer[j] << 8 | buffer[j + 1]);
+
+  if (length % 2)
+    checksum += buffer[length - 1];
+
+  while (checksum > 0xffff)
+    checksum = ((checksum >> 16) & 0xffff) + (checksum & 0xffff);
+
+  checksum = ~checksum;
+
+  return (uint16_t)checksum;
+}
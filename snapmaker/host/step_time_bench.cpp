@@ -0,0 +1,235 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ Host benchmark of the step time solvers in StepTimeKernel.h.
+
+ Every segment of a move stream is walked step by step the way
+ FuncManager::getNextPosTime() does, once with the closed form solver and once
+ with the Newton solver. The step counts must be identical, the largest time
+ difference and ns/step of both solvers are reported per axis.
+
+ A move stream is the "fp: ..." lines logged with STEP_TIME_KERNEL_RECORD,
+ other lines of the log are ignored. Without a file a synthetic stream of
+ trapezoid moves is used.
+
+ build: make -C snapmaker/host
+ usage: step_time_bench [log.txt]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "StepTimeKernel.h"
+
+#define AXIS_COUNT 4
+#define BENCH_ROUNDS 20
+
+static const char *axis_name[AXIS_COUNT] = {"X", "Y", "Z", "E"};
+
+struct Segment {
+    int8_t type;
+    double right_time;
+    double a, b, c, right_pos;
+};
+
+struct AxisResult {
+    long steps;
+    double max_diff_ms;
+    double ns_sqrt;
+    double ns_newton;
+    bool exact;
+};
+
+static std::vector<Segment> segments[AXIS_COUNT];
+
+static bool load_stream(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        return false;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        const char *p = strstr(line, "fp: ");
+        if (!p) {
+            continue;
+        }
+        int axis, type, ti;
+        double td;
+        Segment s;
+        if (sscanf(p + 4, "%d %d %d %lf %lf %lf %lf %lf", &axis, &type, &ti, &td, &s.a, &s.b, &s.c, &s.right_pos) != 8
+            || axis < 0 || axis >= AXIS_COUNT) {
+            continue;
+        }
+        s.type = type;
+        s.right_time = ti + td;
+        segments[axis].push_back(s);
+    }
+    fclose(f);
+    return true;
+}
+
+// Accelerate, cruise, decelerate, positions in steps and time in ms
+static void add_trapezoid(int axis, double &pos, double &time, double dist, double v, double acc) {
+    int8_t type = dist > 0 ? 1 : -1;
+    double d = dist > 0 ? dist : -dist;
+    double t_acc = v / acc;
+    double d_acc = 0.5 * acc * t_acc * t_acc;
+    if (2 * d_acc > d) {
+        d_acc = d / 2;
+        t_acc = sqrt(2 * d_acc / acc);
+        v = acc * t_acc;
+    }
+    double t_cruise = (d - 2 * d_acc) / v;
+
+    Segment s;
+    s.type = type;
+    s.a = type * 0.5 * acc; s.b = 0; s.c = pos;
+    pos += type * d_acc; time += t_acc;
+    s.right_time = time; s.right_pos = pos;
+    segments[axis].push_back(s);
+
+    if (t_cruise > 0) {
+        s.a = 0; s.b = type * v; s.c = pos;
+        pos += type * (d - 2 * d_acc); time += t_cruise;
+        s.right_time = time; s.right_pos = pos;
+        segments[axis].push_back(s);
+    }
+
+    s.a = -type * 0.5 * acc; s.b = type * v; s.c = pos;
+    pos += type * d_acc; time += t_acc;
+    s.right_time = time; s.right_pos = pos;
+    segments[axis].push_back(s);
+}
+
+static void synthetic_stream() {
+    // steps/mm, speed mm/s and acceleration mm/s^2 of a typical print
+    const double steps_per_mm[AXIS_COUNT] = {80, 80, 400, 138};
+    const double speed[AXIS_COUNT] = {300, 300, 10, 40};
+    const double accel[AXIS_COUNT] = {10000, 10000, 100, 3000};
+    const double dist[AXIS_COUNT] = {40, 25, 0.2, 1.5};
+
+    for (int axis = 0; axis < AXIS_COUNT; ++axis) {
+        double pos = axis == 3 ? 16.0 * 4157 * 138 : 0;
+        double time = 0;
+        for (int i = 0; i < 200; ++i) {
+            double d = dist[axis] * (1 + (i % 7)) / 4 * steps_per_mm[axis];
+            if (axis != 3 && (i & 1)) {
+                d = -d;
+            }
+            add_trapezoid(axis, pos, time, d, speed[axis] * steps_per_mm[axis] / 1000,
+                          accel[axis] * steps_per_mm[axis] / 1000000);
+        }
+    }
+}
+
+/*
+ Walk the stream like FuncManager::getNextPosTime(). XYZ solve in float,
+ E in double as FuncParamsExtend does.
+*/
+template <typename T, bool NEWTON>
+static long walk(const std::vector<Segment> &stream, double *times) {
+    long steps = 0;
+    int print_step = (int)(stream.empty() ? 0 : stream[0].c + (stream[0].c >= 0 ? 0.5 : -0.5));
+    double left_time = 0;
+    for (size_t i = 0; i < stream.size(); ++i) {
+        const Segment &s = stream[i];
+        T a = (T)s.a, b = (T)s.b, c = (T)s.c, right_pos = (T)s.right_pos;
+        T seed = -1;
+        while (s.type != 0) {
+            int next_step = print_step + s.type;
+            T next_pos = (T)((float)next_step - 0.5f * s.type);
+            if (s.type > 0 ? next_pos > right_pos + STEP_TIME_EPSILON : next_pos < right_pos - STEP_TIME_EPSILON) {
+                break;
+            }
+            T t = NEWTON ? step_time_newton(a, b, c, s.type, next_pos, seed) : step_time_sqrt(a, b, c, s.type, next_pos);
+            if (times) {
+                times[steps] = left_time + t;
+            }
+            seed = t;
+            print_step = next_step;
+            ++steps;
+        }
+        left_time = s.right_time;
+    }
+    return steps;
+}
+
+template <typename T>
+static AxisResult bench_axis(const std::vector<Segment> &stream) {
+    AxisResult r;
+    r.steps = walk<T, false>(stream, nullptr);
+    std::vector<double> t_sqrt(r.steps + 1), t_newton(r.steps + 1);
+    long steps_newton = walk<T, true>(stream, nullptr);
+    r.exact = steps_newton == r.steps;
+
+    r.max_diff_ms = 0;
+    if (r.exact) {
+        walk<T, false>(stream, t_sqrt.data());
+        walk<T, true>(stream, t_newton.data());
+        for (long i = 0; i < r.steps; ++i) {
+            double diff = t_sqrt[i] > t_newton[i] ? t_sqrt[i] - t_newton[i] : t_newton[i] - t_sqrt[i];
+            if (diff > r.max_diff_ms) {
+                r.max_diff_ms = diff;
+            }
+        }
+    }
+
+    volatile long sink = 0;
+    auto st = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        sink += walk<T, false>(stream, nullptr);
+    }
+    auto mt = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ROUNDS; ++i) {
+        sink += walk<T, true>(stream, nullptr);
+    }
+    auto et = std::chrono::steady_clock::now();
+
+    double total = (double)r.steps * BENCH_ROUNDS;
+    r.ns_sqrt = total ? std::chrono::duration<double, std::nano>(mt - st).count() / total : 0;
+    r.ns_newton = total ? std::chrono::duration<double, std::nano>(et - mt).count() / total : 0;
+    return r;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        if (!load_stream(argv[1])) {
+            fprintf(stderr, "can not open %s\n", argv[1]);
+            return 1;
+        }
+    } else {
+        synthetic_stream();
+    }
+
+    bool exact = true;
+    printf("axis  segments     steps  sqrt ns/step  newton ns/step  max diff us  counts\n");
+    for (int axis = 0; axis < AXIS_COUNT; ++axis) {
+        AxisResult r = axis == 3 ? bench_axis<double>(segments[axis]) : bench_axis<float>(segments[axis]);
+        exact = exact && r.exact;
+        printf("%-4s  %8u  %8ld  %12.2f  %14.2f  %11.3f  %s\n", axis_name[axis], (unsigned)segments[axis].size(),
+               r.steps, r.ns_sqrt, r.ns_newton, r.max_diff_ms * 1000, r.exact ? "exact" : "MISMATCH");
+    }
+
+    return exact ? 0 : 2;
+}
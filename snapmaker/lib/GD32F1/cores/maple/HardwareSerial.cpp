@@ -157,6 +157,18 @@ int HardwareSerial::available(void) {
     return usart_data_available(this->usart_device);
 }
 
+uint16_t HardwareSerial::read_span(uint8_t **data) {
+    return rb_span(this->usart_device->rb, data);
+}
+
+void HardwareSerial::read_skip(uint16_t len) {
+    rb_skip(this->usart_device->rb, len);
+}
+
+void HardwareSerial::attach_rx_notify(voidFuncPtr fn) {
+    usart_attach_rx_notify(this->usart_device, fn);
+}
+
 /* Roger Clark. Added function missing from LibMaple code */
 
 int HardwareSerial::peek(void)
@@ -194,7 +206,7 @@ size_t HardwareSerial::write(unsigned char ch) {
       if (sta == taskSCHEDULER_RUNNING)
           taskEXIT_CRITICAL();
 
-      LOG_I(logger.get_read());
+      debug.Write(SNAP_DEBUG_LEVEL_INFO, logger.get_read(), BB_BUF_SIZE - 1);
 
       return 1;
   }
@@ -204,13 +216,15 @@ size_t HardwareSerial::write(unsigned char ch) {
       if (sta == taskSCHEDULER_RUNNING)
           taskENTER_CRITICAL();
 
+      uint32_t len = logger.index;
       logger.write(0);
       logger.swap();
 
       if (sta == taskSCHEDULER_RUNNING)
           taskEXIT_CRITICAL();
 
-      LOG_I(logger.get_read());
+      // Queued as is, the snap_log task sends it with the next lines
+      debug.Write(SNAP_DEBUG_LEVEL_INFO, logger.get_read(), len);
   }
 
   return 1;
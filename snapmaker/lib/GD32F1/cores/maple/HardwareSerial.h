@@ -146,6 +146,14 @@ public:
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
     inline size_t write(int n) { return write((uint8_t)n); }
     using Print::write;
+    // Bulk access to the RX buffer: the received bytes that lie contiguous,
+    // removed with read_skip() once they are used. Only with rx_notify
+    // attached, the IRQ then drops new bytes on a full buffer instead of
+    // overwriting the ones handed out
+    uint16_t read_span(uint8_t **data);
+    void read_skip(uint16_t len);
+    // Called from the IRQ when the RX line goes idle after a burst
+    void attach_rx_notify(voidFuncPtr fn);
     void enable_sacp(bool enable) {enable_sacp_ = enable; }
     bool enable_sacp() {return enable_sacp_; }
 
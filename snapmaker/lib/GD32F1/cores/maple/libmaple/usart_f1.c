@@ -201,23 +201,23 @@ void usart_foreach(void (*fn)(usart_dev*)) {
  */
 
 __weak void __irq_usart1(void) {
-    usart_irq(&usart1_rb, &usart1_wb, USART1_BASE);
+    usart_irq(&usart1_rb, &usart1_wb, USART1_BASE, usart1.rx_notify);
 }
 
 __weak void __irq_usart2(void) {
-    usart_irq(&usart2_rb, &usart2_wb, USART2_BASE);
+    usart_irq(&usart2_rb, &usart2_wb, USART2_BASE, usart2.rx_notify);
 }
 
 __weak void __irq_usart3(void) {
-    usart_irq(&usart3_rb, &usart3_wb, USART3_BASE);
+    usart_irq(&usart3_rb, &usart3_wb, USART3_BASE, usart3.rx_notify);
 }
 
 #if defined(STM32_HIGH_DENSITY) || (STM32_F1_LINE == STM32_F1_LINE_CONNECTIVITY)
 __weak void __irq_uart4(void) {
-    usart_irq(&uart4_rb, &uart4_wb, UART4_BASE);
+    usart_irq(&uart4_rb, &uart4_wb, UART4_BASE, uart4.rx_notify);
 }
 
 __weak void __irq_uart5(void) {
-    usart_irq(&uart5_rb, &uart5_wb, UART5_BASE);
+    usart_irq(&uart5_rb, &uart5_wb, UART5_BASE, uart5.rx_notify);
 }
 #endif
@@ -54,7 +54,7 @@
 #define configTICK_RATE_HZ				( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES			( 4 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 120 )
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 22 * 1024 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 25 * 1024 ) )
 #define configMAX_TASK_NAME_LEN			( 10 )
 #define configUSE_TRACE_FACILITY		1
 #define configUSE_16_BIT_TICKS			0
@@ -66,7 +66,22 @@
 #define configUSE_MALLOC_FAILED_HOOK	1
 #define configUSE_APPLICATION_TASK_TAG	0
 #define configUSE_COUNTING_SEMAPHORES	1
-#define configGENERATE_RUN_TIME_STATS	0
+#define configGENERATE_RUN_TIME_STATS	1
+
+/* Run time stats clock, DWT cycles / 1024, see snapmaker/debug/profiler.cpp */
+#ifndef __ASSEMBLER__
+	#include <stdint.h>
+	#ifdef __cplusplus
+	extern "C" {
+	#endif
+	void rtos_run_time_init(void);
+	uint32_t rtos_run_time_counter(void);
+	#ifdef __cplusplus
+	}
+	#endif
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	rtos_run_time_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()			rtos_run_time_counter()
 
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
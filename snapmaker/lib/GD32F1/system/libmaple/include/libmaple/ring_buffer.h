@@ -193,6 +193,34 @@ static inline int rb_push_insert(ring_buffer *rb, uint8 element) {
     return ret;
 }
 
+/**
+ * @brief Return the items that lie contiguous from the first one,
+ *        without removing them.
+ *
+ * Items that wrap around the end of the storage are returned by the
+ * next call once these are removed with rb_skip().
+ *
+ * @param rb Buffer to read from.
+ * @param data Set to the first item.
+ * @return Number of contiguous items, 0 if the buffer is empty.
+ */
+static inline uint16 rb_span(ring_buffer *rb, uint8 **data) {
+    uint16 head = rb->head;
+    uint16 tail = rb->tail;
+    *data = (uint8 *)&rb->buf[head];
+    return tail >= head ? tail - head : rb->size + 1 - head;
+}
+
+/**
+ * @brief Remove the first count items from a ring buffer.
+ * @param rb Buffer to remove from, must contain at least count items.
+ * @param count Number of items to remove.
+ */
+static inline void rb_skip(ring_buffer *rb, uint16 count) {
+    uint16 head = rb->head + count;
+    rb->head = head > rb->size ? head - rb->size - 1 : head;
+}
+
 /**
  * @brief Discard all items from a ring buffer.
  * @param rb Ring buffer to discard all items from.
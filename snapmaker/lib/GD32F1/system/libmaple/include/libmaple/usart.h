@@ -385,6 +385,12 @@ typedef struct usart_reg_map {
 #define USART_TX_BUF_SIZE               1024
 #endif
 
+/* RX fill level that calls rx_notify, so a long burst is drained
+ * before the buffer overflows */
+#ifndef USART_RX_NOTIFY_LEVEL
+#define USART_RX_NOTIFY_LEVEL           (USART_RX_BUF_SIZE / 2)
+#endif
+
 /** USART device type */
 typedef struct usart_dev {
     usart_reg_map *regs;             /**< Register map */
@@ -399,6 +405,9 @@ typedef struct usart_dev {
     uint8 tx_buf[USART_TX_BUF_SIZE]; /**< Actual TX buffer used by wb */
     rcc_clk_id clk_id;               /**< RCC clock information */
     nvic_irq_num irq_num;            /**< USART NVIC interrupt */
+    voidFuncPtr rx_notify;           /**< Called from the IRQ when the RX
+                                      * line goes idle or the RX buffer
+                                      * reaches USART_RX_NOTIFY_LEVEL */
 } usart_dev;
 
 void usart_init(usart_dev *dev);
@@ -517,6 +526,26 @@ static inline void usart_reset_tx(usart_dev *dev) {
     rb_reset(dev->wb);
 }
 
+/**
+ * @brief Call a function from the USART IRQ when received data is ready.
+ *
+ * The function is called once the RX line goes idle after a burst and
+ * when the RX buffer reaches USART_RX_NOTIFY_LEVEL, it runs in interrupt
+ * context. While it is attached a full RX buffer drops new bytes
+ * instead of overwriting the oldest, so they can be read in place.
+ *
+ * @param dev Serial port to watch
+ * @param fn Function to call, NULL to stop watching
+ */
+static inline void usart_attach_rx_notify(usart_dev *dev, voidFuncPtr fn) {
+    dev->rx_notify = fn;
+    if (fn) {
+        dev->regs->CR1 |= USART_CR1_IDLEIE;
+    } else {
+        dev->regs->CR1 &= ~USART_CR1_IDLEIE;
+    }
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
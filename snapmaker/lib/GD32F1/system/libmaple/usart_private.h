@@ -37,21 +37,38 @@
 #include <libmaple/ring_buffer.h>
 #include <libmaple/usart.h>
 
-static inline __always_inline void usart_irq(ring_buffer *rb, ring_buffer *wb, usart_reg_map *regs) {
+static inline __always_inline void usart_irq(ring_buffer *rb, ring_buffer *wb, usart_reg_map *regs, voidFuncPtr rx_notify) {
+    uint32 sr = regs->SR;
     /* Handling RXNEIE and TXEIE interrupts. 
      * RXNE signifies availability of a byte in DR.
      *
      * See table 198 (sec 27.4, p809) in STM document RM0008 rev 15.
      * We enable RXNEIE. */
-    if ((regs->CR1 & USART_CR1_RXNEIE) && (regs->SR & USART_SR_RXNE)) {
+    if ((regs->CR1 & USART_CR1_RXNEIE) && (sr & USART_SR_RXNE)) {
 #ifdef USART_SAFE_INSERT
         /* If the buffer is full and the user defines USART_SAFE_INSERT,
          * ignore new bytes. */
         rb_safe_insert(rb, (uint8)regs->DR);
 #else
-        /* By default, push bytes around in the ring buffer. */
-        rb_push_insert(rb, (uint8)regs->DR);
+        /* A port with rx_notify is read in place with rb_span(), moving
+         * the head under the reader would hand it overwritten bytes, so
+         * new bytes are ignored there when the buffer is full. */
+        if (rx_notify)
+            rb_safe_insert(rb, (uint8)regs->DR);
+        else
+            /* By default, push bytes around in the ring buffer. */
+            rb_push_insert(rb, (uint8)regs->DR);
 #endif
+        if (rx_notify && rb_full_count(rb) == USART_RX_NOTIFY_LEVEL)
+            rx_notify();
+    }
+    /* IDLE is set when the line stays quiet for a frame after a burst,
+     * reading SR then DR clears it. IDLEIE is only enabled with rx_notify. */
+    if ((regs->CR1 & USART_CR1_IDLEIE) && (sr & USART_SR_IDLE)) {
+        if (!(sr & USART_SR_RXNE))
+            (void)regs->DR;
+        if (rx_notify)
+            rx_notify();
     }
     /* TXE signifies readiness to send a byte to DR. */
     if ((regs->CR1 & USART_CR1_TXEIE) && (regs->SR & USART_SR_TXE)) {
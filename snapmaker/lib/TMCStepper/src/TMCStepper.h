@@ -850,6 +850,15 @@ class TMC2208Stepper : public TMCStepper {
 		#endif
 		bool isEnabled();
 
+		// Writes are queued and sent by the tmc_uart task once it runs,
+		// a write of the value a register already holds is dropped
+		static void uart_queue_start();
+		static void uart_flush();
+		void shadow_clear();
+		// A read with its CRC status taken while the bus is still held,
+		// false on a CRC error
+		bool read_checked(uint8_t addr, uint32_t &value);
+
 		// RW: GCONF
 		void GCONF(uint32_t input);
 		void I_scale_analog(bool B);
@@ -1020,7 +1029,23 @@ class TMC2208Stepper : public TMCStepper {
 		void postReadCommunication();
 		void write(uint8_t, uint32_t);
 		uint32_t read(uint8_t);
+		uint32_t read(uint8_t, bool &);
+		void send_write(uint8_t, uint32_t);
+		bool queue_write(uint8_t, uint8_t, uint32_t);
+		static void uart_drain();
+		static void uart_task(void *);
+		void shadow_resend();
 		const uint8_t slave_address;
+		// Last value queued for each register in shadow_regs, bit n of
+		// shadow_valid set once shadow[n] holds one
+		static constexpr uint8_t SHADOW_REGS = 12;
+		static const uint8_t shadow_regs[SHADOW_REGS];
+		uint32_t shadow[SHADOW_REGS];
+		uint16_t shadow_valid = 0;
+		// A write was lost to a full queue in an ISR, lost_next links the
+		// drivers waiting for their shadow to be sent again
+		bool write_lost = false;
+		TMC2208Stepper *lost_next = nullptr;
 		uint8_t calcCRC(uint8_t datagram[], uint8_t len);
 		static constexpr uint8_t  TMC2208_SYNC = 0x05,
 															TMC2208_SLAVE_ADDR = 0x00;
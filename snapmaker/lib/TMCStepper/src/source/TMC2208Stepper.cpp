@@ -2,6 +2,7 @@
 #include "TMC_MACROS.h"
 #include "SERIAL_SWITCH.h"
 #include "HAL.h"
+#include "MapleFreeRTOS1030.h"
 #include <src/pins/pins.h>
 
 
@@ -115,6 +116,7 @@ void TMC2208Stepper::defaults() {
 }
 
 void TMC2208Stepper::push() {
+	shadow_clear();
 	GCONF(GCONF_register.sr);
 	IHOLD_IRUN(IHOLD_IRUN_register.sr);
 	SLAVECONF(SLAVECONF_register.sr);
@@ -222,10 +224,233 @@ void TMC2208Stepper::postReadCommunication() {
 	#endif
 }
 
+/*
+ * Queued writes
+ *
+ * All drivers share one UART behind the SEL mux. A write used to select its
+ * driver and spin 2 ms before and after the datagram in the caller, so
+ * reconfiguring the axes held marlin_loop for tens of ms. Now write() puts
+ * the value in the shadow of the register and queues it, and the tmc_uart
+ * task sends the queue and sleeps out the gaps.
+ *
+ * A write of the value the shadow already holds is dropped, one to a
+ * register still waiting in the queue replaces the queued value unless
+ * another register of the driver is queued behind it. The
+ * write-only registers are read back from the register copies of the
+ * class, so only the RW and status registers go to the bus. read() takes
+ * the bus and sends what is queued first, so a driver sees the writes in
+ * order. Until the scheduler runs a write is sent at once like before.
+ * uart_flush() waits until the queue has reached the drivers, for the
+ * callers whose next step depends on the new values.
+ *
+ * An ISR can wait neither for the bus nor for a free slot. When the queue
+ * is full there the value only goes to the shadow, and the driver is marked
+ * so the queue is followed by all of its shadowed registers again.
+ */
+
+#define TMC_UART_QUEUE_SIZE   32
+#define TMC_UART_TASK_STACK   256
+
+typedef struct {
+	TMC2208Stepper *drv;
+	uint8_t addr;
+	uint32_t value;
+} tmc_uart_write_t;
+
+static tmc_uart_write_t uart_queue[TMC_UART_QUEUE_SIZE];
+static volatile uint8_t uart_head = 0;
+static volatile uint8_t uart_tail = 0;
+static TaskHandle_t thandle_tmc_uart = NULL;
+static SemaphoreHandle_t uart_bus = NULL;
+// Drivers that lost a write in an ISR, linked through lost_next
+static TMC2208Stepper * volatile uart_lost = NULL;
+
+// GCONF, SLAVECONF, FACTORY_CONF, IHOLD_IRUN, TPOWERDOWN, TPWMTHRS,
+// TCOOLTHRS, VACTUAL, SGTHRS, COOLCONF, CHOPCONF, PWMCONF. GSTAT and
+// OTP_PROG writes act on the driver every time and are always sent.
+const uint8_t TMC2208Stepper::shadow_regs[SHADOW_REGS] = {
+	0x00, 0x03, 0x07, 0x10, 0x11, 0x13, 0x14, 0x22, 0x40, 0x42, 0x6C, 0x70
+};
+
+static bool uart_running() {
+	return thandle_tmc_uart && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING;
+}
+
+static void uart_wait(uint32_t ms) {
+	if (uart_running()) {
+		vTaskDelay(pdMS_TO_TICKS(ms));
+	} else {
+		delay(ms);
+	}
+}
+
+void TMC2208Stepper::uart_queue_start() {
+	if (thandle_tmc_uart) {
+		return;
+	}
+	uart_bus = xSemaphoreCreateMutex();
+	if (!uart_bus) {
+		return;
+	}
+	// At the priority of marlin_loop, it sleeps in the gaps between datagrams
+	if (xTaskCreate(uart_task, "tmc_uart", TMC_UART_TASK_STACK, NULL, 3, &thandle_tmc_uart) != pdPASS) {
+		thandle_tmc_uart = NULL;
+	}
+}
+
+void TMC2208Stepper::uart_flush() {
+	if (!uart_running() || xPortIsInsideInterrupt()) {
+		return;
+	}
+	xSemaphoreTake(uart_bus, portMAX_DELAY);
+	uart_drain();
+	xSemaphoreGive(uart_bus);
+}
+
+// After a reset of the driver the shadow no longer holds what it has
+void TMC2208Stepper::shadow_clear() {
+	shadow_valid = 0;
+}
+
+void TMC2208Stepper::uart_task(void *arg) {
+	for (;;) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		xSemaphoreTake(uart_bus, portMAX_DELAY);
+		uart_drain();
+		xSemaphoreGive(uart_bus);
+	}
+}
+
+// Send the queued writes, then the shadows of the drivers that lost one.
+// The caller holds the bus.
+void TMC2208Stepper::uart_drain() {
+	for (;;) {
+		taskENTER_CRITICAL();
+		if (uart_tail != uart_head) {
+			tmc_uart_write_t w = uart_queue[uart_tail];
+			uart_tail = (uart_tail + 1) % TMC_UART_QUEUE_SIZE;
+			taskEXIT_CRITICAL();
+			w.drv->send_write(w.addr, w.value);
+			continue;
+		}
+		TMC2208Stepper *drv = uart_lost;
+		if (!drv) {
+			taskEXIT_CRITICAL();
+			return;
+		}
+		uart_lost = drv->lost_next;
+		drv->write_lost = false;
+		taskEXIT_CRITICAL();
+		drv->shadow_resend();
+	}
+}
+
+// Send every register the shadow holds, the caller holds the bus
+void TMC2208Stepper::shadow_resend() {
+	for (uint8_t n = 0; n < SHADOW_REGS; n++) {
+		taskENTER_CRITICAL();
+		bool valid = shadow_valid & _BV(n);
+		uint32_t value = shadow[n];
+		taskEXIT_CRITICAL();
+		if (valid) {
+			send_write(shadow_regs[n], value);
+		}
+	}
+}
+
+// Put a write in the shadow and the queue, the caller holds the critical
+// section. False when the queue is full.
+bool TMC2208Stepper::queue_write(uint8_t n, uint8_t addr, uint32_t regVal) {
+	bool shadowed = n < SHADOW_REGS;
+	if (shadowed && (shadow_valid & _BV(n)) && shadow[n] == regVal) {
+		return true;
+	}
+	bool queued = false;
+	if (shadowed) {
+		// Only the last write queued for the driver may take the new value,
+		// the driver has to see the writes in order
+		uint8_t last = TMC_UART_QUEUE_SIZE;
+		for (uint8_t i = uart_tail; i != uart_head; i = (i + 1) % TMC_UART_QUEUE_SIZE) {
+			if (uart_queue[i].drv == this) {
+				last = uart_queue[i].addr == addr ? i : TMC_UART_QUEUE_SIZE;
+			}
+		}
+		if (last < TMC_UART_QUEUE_SIZE) {
+			uart_queue[last].value = regVal;
+			queued = true;
+		}
+	}
+	uint8_t head = (uart_head + 1) % TMC_UART_QUEUE_SIZE;
+	if (!queued && head != uart_tail) {
+		uart_queue[uart_head].drv = this;
+		uart_queue[uart_head].addr = addr;
+		uart_queue[uart_head].value = regVal;
+		uart_head = head;
+		queued = true;
+	}
+	if (queued && shadowed) {
+		shadow[n] = regVal;
+		shadow_valid |= _BV(n);
+	}
+	return queued;
+}
+
 void TMC2208Stepper::write(uint8_t addr, uint32_t regVal) {
+	uint8_t n = 0;
+	while (n < SHADOW_REGS && shadow_regs[n] != addr) n++;
+
+	if (xPortIsInsideInterrupt()) {
+		if (!thandle_tmc_uart) {
+			return;
+		}
+		UBaseType_t state = taskENTER_CRITICAL_FROM_ISR();
+		if (!queue_write(n, addr, regVal) && n < SHADOW_REGS) {
+			// Queue full, the tmc_uart task sends the shadow again
+			shadow[n] = regVal;
+			shadow_valid |= _BV(n);
+			if (!write_lost) {
+				write_lost = true;
+				lost_next = uart_lost;
+				uart_lost = this;
+			}
+		}
+		taskEXIT_CRITICAL_FROM_ISR(state);
+		BaseType_t woken = pdFALSE;
+		vTaskNotifyGiveFromISR(thandle_tmc_uart, &woken);
+		portYIELD_FROM_ISR(woken);
+		return;
+	}
+
+	if (!uart_running()) {
+		if (n < SHADOW_REGS) {
+			if ((shadow_valid & _BV(n)) && shadow[n] == regVal) return;
+			shadow[n] = regVal;
+			shadow_valid |= _BV(n);
+		}
+		send_write(addr, regVal);
+		return;
+	}
+
+	for (;;) {
+		taskENTER_CRITICAL();
+		bool queued = queue_write(n, addr, regVal);
+		taskEXIT_CRITICAL();
+
+		if (queued) {
+			xTaskNotifyGive(thandle_tmc_uart);
+			return;
+		}
+		// Queue full, send it from here
+		xSemaphoreTake(uart_bus, portMAX_DELAY);
+		uart_drain();
+		xSemaphoreGive(uart_bus);
+	}
+}
+
+void TMC2208Stepper::send_write(uint8_t addr, uint32_t regVal) {
 	uint8_t len = 7;
 	select(slave_address);
-	delay(2);
+	uart_wait(2);
 	addr |= TMC_WRITE;
 	uint8_t datagram[] = {TMC2208_SYNC, st_slave_address, addr, (uint8_t)(regVal>>24), (uint8_t)(regVal>>16), (uint8_t)(regVal>>8), (uint8_t)(regVal>>0), 0x00};
 
@@ -238,7 +463,8 @@ void TMC2208Stepper::write(uint8_t addr, uint32_t regVal) {
 	}
 	postWriteCommunication();
 
-	delay(replyDelay);
+	// The datagram leaves the line before the mux may switch
+	uart_wait(replyDelay);
 }
 
 uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, uint16_t timeout) {
@@ -259,7 +485,7 @@ uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, ui
 		}
 	#endif
 
-	delay(this->replyDelay);
+	uart_wait(this->replyDelay);
 
 	// scan for the rx frame and read it
 	uint32_t ms = millis();
@@ -319,7 +545,25 @@ uint64_t TMC2208Stepper::_sendDatagram(uint8_t datagram[], const uint8_t len, ui
 }
 
 uint32_t TMC2208Stepper::read(uint8_t addr) {
+	bool crc_error;
+	return read(addr, crc_error);
+}
+
+bool TMC2208Stepper::read_checked(uint8_t addr, uint32_t &value) {
+	bool crc_error;
+	value = read(addr, crc_error);
+	return !crc_error;
+}
+
+// CRCerror is shared with the other tasks that read this driver, crc_error
+// is the status of this read
+uint32_t TMC2208Stepper::read(uint8_t addr, bool &crc_error) {
 	constexpr uint8_t len = 3;
+	bool bus = uart_running();
+	if (bus) {
+		xSemaphoreTake(uart_bus, portMAX_DELAY);
+		uart_drain();
+	}
 	addr |= TMC_READ;
 	select(slave_address);
 	uint8_t datagram[] = {TMC2208_SYNC, st_slave_address, addr, 0x00};
@@ -331,7 +575,7 @@ uint32_t TMC2208Stepper::read(uint8_t addr) {
 		out = _sendDatagram(datagram, len, abort_window);
 		postReadCommunication();
 
-		delay(replyDelay);
+		uart_wait(replyDelay);
 
 		CRCerror = false;
 		uint8_t out_datagram[] = {
@@ -352,7 +596,11 @@ uint32_t TMC2208Stepper::read(uint8_t addr) {
 			break;
 		}
 	}
+	crc_error = CRCerror;
 
+	if (bus) {
+		xSemaphoreGive(uart_bus);
+	}
 	return out>>8;
 }
 
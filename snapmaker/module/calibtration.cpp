@@ -466,6 +466,11 @@ probe_result_e Calibtration::probe(uint8_t axis, float distance, uint16_t feedra
   current_position[axis] = stepper.position((AxisEnum)axis) / planner.settings.axis_steps_per_mm[axis];
   sync_plan_position();
 
+  // The axis stopped a little past the release
+  if (!switch_detect.probe_trigger_position(axis, probe_trigger_pos))
+    probe_trigger_pos = current_position[axis];
+  LOG_I("probe released at %f, stopped at %f\r\n", probe_trigger_pos, current_position[axis]);
+
   float move_d = fabs(pos_before_probe - current_position[axis]);
   LOG_I("Actrual probe distance: %f\r\n", move_d);
   if (move_d >= fabs(distance)) {
@@ -568,7 +573,7 @@ ErrCode Calibtration::probe_hight_offset(calibtration_position_e pos, uint8_t ex
     LOG_E("CAlIBRATIONING_ERR_CODE\r\n");
   }
   else {
-    probe_offset = current_position[Z_AXIS] + home_offset[Z_AXIS] + build_plate_thickness;
+    probe_offset = probe_trigger_pos + home_offset[Z_AXIS] + build_plate_thickness;
     LOG_I("JF-Z offset height:%f\n", probe_offset);
   }
   last_z_probe_distance = fabs(current_position[Z_AXIS] - before_probe_z);
@@ -724,33 +729,25 @@ void Calibtration::reset_xy_calibtration_env() {
 
 float Calibtration::multiple_probe(uint8_t axis, float distance, uint16_t freerate) {
 
-  float pos = 0;
-  uint16_t probe_fr;
-  float probe_distance;
-  bool do_sg;
-  float max_ = 0.0;
-  float min_ = 10000.0;
-  float max_delta;
+  float samples[PROBE_MAX_TIMES];
+  uint8_t count = 0;
+  float spread = 0;
+  bool converged = false;
 
-  for (uint8_t i = 0; i < PROBE_TIMES; i++) {
+  for (uint8_t i = 0; i <= PROBE_MAX_TIMES; i++) {
 
     /*
-    Do stall guard test for first time
+    The first touch is the coarse one over the whole distance, with the stall
+    guard test. The fine passes start a short backoff from the contact.
     */
-    do_sg = (i == 0);
-    probe_fr = (i == 0) ? freerate : (freerate / XY_PROBE_SPEED_SLOW_SCALER);
-    if (0 == i) {
-      max_delta = 0;
+    bool do_sg = (i == 0);
+    uint16_t probe_fr = (i == 0) ? freerate : (freerate / XY_PROBE_SPEED_SLOW_SCALER);
+    float max_delta = (1 == i) ? 2 * MAX_DELTA_DISTANCE : MAX_DELTA_DISTANCE;
+    float probe_distance;
+    if (0 == i)
       probe_distance = distance;
-    }
-    else if (1 == i) {
-      max_delta = 2 * MAX_DELTA_DISTANCE;
-      probe_distance = (distance > EPSILON) ? PROBE_BACKOFF_DISTANCE + 2 * max_delta : -PROBE_BACKOFF_DISTANCE - 2 * max_delta;
-    }
-    else {
-      max_delta = MAX_DELTA_DISTANCE;
-      probe_distance = (distance > EPSILON) ? PROBE_BACKOFF_DISTANCE + 2 * max_delta : -PROBE_BACKOFF_DISTANCE - 2 * max_delta;
-    }
+    else
+      probe_distance = (distance > EPSILON) ? PROBE_FINE_BACKOFF_DISTANCE + 2 * max_delta : -PROBE_FINE_BACKOFF_DISTANCE - 2 * max_delta;
 
     float before_probe_pos = current_position[axis];
     probe_result_e probe_result = probe(axis, probe_distance, probe_fr, do_sg);
@@ -769,16 +766,81 @@ float Calibtration::multiple_probe(uint8_t axis, float distance, uint16_t freera
     float actrual_probe_distance = fabs(after_probe_pos - before_probe_pos);
     LOG_I("%dth actrual probe distance %f\r\n", i, actrual_probe_distance);
 
+    // Running spread of the last PROBE_MIN_TIMES fine passes
     if (0 != i) {
-      pos += current_position[axis];
-      if (current_position[axis] > max_) max_ = current_position[axis];
-      if (current_position[axis] < min_) min_ = current_position[axis];
+      samples[count++] = probe_trigger_pos;
+      if (count >= PROBE_MIN_TIMES) {
+        float max_ = samples[count - 1];
+        float min_ = samples[count - 1];
+        for (uint8_t j = count - PROBE_MIN_TIMES; j < count; j++) {
+          if (samples[j] > max_) max_ = samples[j];
+          if (samples[j] < min_) min_ = samples[j];
+        }
+        spread = max_ - min_;
+        converged = (spread <= probe_tolerance);
+      }
+    }
+
+    bool last = converged || count == PROBE_MAX_TIMES;
+    float backoff = last ? PROBE_BACKOFF_DISTANCE : PROBE_FINE_BACKOFF_DISTANCE;
+    motion_control.move(axis, (distance > EPSILON) ? -backoff : backoff, freerate);
+    if (last)
+      break;
+  }
+
+  float pos = 0;
+  if (converged) {
+    for (uint8_t j = count - PROBE_MIN_TIMES; j < count; j++)
+      pos += samples[j];
+    pos /= PROBE_MIN_TIMES;
+  }
+  else {
+    // No run of passes agreed, average all but the highest and lowest
+    float max_ = samples[0];
+    float min_ = samples[0];
+    for (uint8_t j = 0; j < count; j++) {
+      pos += samples[j];
+      if (samples[j] > max_) max_ = samples[j];
+      if (samples[j] < min_) min_ = samples[j];
     }
+    pos = (pos - max_ - min_) / (count - 2);
+    spread = max_ - min_;
+  }
+  LOG_I("axis %d probed %f in %d passes, spread %f%s\r\n", axis, pos, count, spread, converged ? "" : " (not converged)");
 
-    motion_control.move(axis, (distance > EPSILON) ? -PROBE_BACKOFF_DISTANCE : PROBE_BACKOFF_DISTANCE, freerate);
+  // The Z probes record here too, keep the last PROBE_QUALITY_POINTS
+  probe_quality_t &quality = probe_quality[probe_quality_next];
+  probe_quality_next = (probe_quality_next + 1) % PROBE_QUALITY_POINTS;
+  if (probe_quality_count < PROBE_QUALITY_POINTS) {
+    probe_quality_count++;
   }
+  quality.extruder = active_extruder;
+  quality.axis = axis;
+  quality.dir = (distance > EPSILON);
+  quality.samples = count;
+  quality.converged = converged;
+  quality.spread = spread;
+
+  return pos;
+}
 
-  return (pos - max_ - min_) / (PROBE_TIMES - 3);
+void Calibtration::reset_probe_quality() {
+  probe_quality_count = 0;
+  probe_quality_next = 0;
+}
+
+// The i-th of the kept entries, oldest first
+const probe_quality_t &Calibtration::get_probe_quality(uint8_t i) {
+  uint8_t first = (probe_quality_next + PROBE_QUALITY_POINTS - probe_quality_count) % PROBE_QUALITY_POINTS;
+  return probe_quality[(first + i) % PROBE_QUALITY_POINTS];
+}
+
+ErrCode Calibtration::set_probe_tolerance(float tolerance) {
+  if (tolerance < 0.001 || tolerance > MAX_DELTA_DISTANCE) {
+    return E_PARAM;
+  }
+  probe_tolerance = tolerance;
+  return E_SUCCESS;
 }
 
 ErrCode Calibtration::calibtration_xy() {
@@ -801,6 +863,7 @@ ErrCode Calibtration::calibtration_xy() {
   X_standby();
   backup_offset();
   reset_xy_calibtration_env();
+  reset_probe_quality();
 
   HOTEND_LOOP() {
 
@@ -921,6 +984,7 @@ ErrCode Calibtration::calibtration_xy_center_offset() {
   X_standby();
   backup_offset();
   reset_xy_calibtration_env();
+  reset_probe_quality();
 
   bed_preapare(0);
   goto_calibtration_position(CAlIBRATION_POS_0);
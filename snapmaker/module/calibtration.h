@@ -29,10 +29,16 @@
 
 #define CAlIBRATIONING_ERR_CODE               (10000)
 #define CAlIBRATIONIN_RETRACK_E_MM            (5)
-#define PROBE_TIMES                           (6)
 #define XY_PROBE_SPEED_SLOW_SCALER            (10)
 #define Z_PROBE_SPEED_SLOW_SCALER             (4)
 #define MAX_DELTA_DISTANCE                    (0.25)
+// Fine passes after the first touch: at least PROBE_MIN_TIMES, stopped as
+// soon as the last PROBE_MIN_TIMES spread no more than the tolerance
+#define PROBE_MIN_TIMES                       (3)
+#define PROBE_MAX_TIMES                       (5)
+#define PROBE_SPREAD_TOLERANCE                (0.02)  // mm
+#define PROBE_FINE_BACKOFF_DISTANCE           (0.3)   // mm
+#define PROBE_QUALITY_POINTS                  (8)
 
 #define CALIBRATION_ACC                       (1000)
 #define CALIBRATION_FEEDRATE                  (0.0)
@@ -95,6 +101,16 @@ typedef enum {
   CAlIBRATION_POS_INVALID,
 } calibtration_position_e;
 
+// How well the fine passes of a multiple_probe() agreed
+typedef struct {
+  uint8_t extruder;
+  uint8_t axis;
+  uint8_t dir;        // 0: probed towards min, 1: towards max
+  uint8_t samples;
+  bool converged;     // the spread came within the tolerance
+  float spread;       // mm
+} probe_quality_t;
+
 class Calibtration {
   public:
     void set_calibtration_mode(calibtration_mode_e m) {mode = m;};
@@ -133,6 +149,12 @@ class Calibtration {
     void Z_standby(void);
     void Z_prepare(void);
 
+    void reset_probe_quality();
+    ErrCode set_probe_tolerance(float tolerance);
+    float get_probe_tolerance() {return probe_tolerance;};
+    uint8_t get_probe_quality_count() {return probe_quality_count;};
+    const probe_quality_t &get_probe_quality(uint8_t i);
+
   private:
     ErrCode probe_z_offset(calibtration_position_e pos);
     void reset_xy_calibtration_env();
@@ -156,6 +178,13 @@ class Calibtration {
     uint32_t z_probe_cnt = 0;
   private:
     float last_probe_pos = 0;
+    // Axis position where the probe of the last probe() released
+    float probe_trigger_pos = 0;
+    float probe_tolerance = PROBE_SPREAD_TOLERANCE;
+    // One entry per multiple_probe() of the last calibration
+    probe_quality_t probe_quality[PROBE_QUALITY_POINTS];
+    uint8_t probe_quality_count = 0;
+    uint8_t probe_quality_next = 0;
 };
 
 extern Calibtration calibtration;
@@ -0,0 +1,129 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#include "driver_load.h"
+#include "src/module/stepper.h"
+#include "src/module/stepper/indirection.h"
+#include "src/module/AxisManager.h"
+#include "../debug/debug.h"
+#include "power_loss.h"
+#include "system.h"
+#include "MapleFreeRTOS1030.h"
+
+DriverLoad driver_load;
+
+typedef struct {
+  TMC2209Stepper *driver;
+  uint8_t axis;
+  uint8_t speed_axis;   // axis of the axis manager that gives the speed
+} driver_load_src_t;
+
+// Both X carriages take the X speed of the planned stream
+static const driver_load_src_t load_src[DRIVER_LOAD_COUNT] = {
+  {&stepperX,  AXIS_X1, X_AXIS},
+  {&stepperY,  AXIS_Y1, Y_AXIS},
+  {&stepperZ,  AXIS_Z1, Z_AXIS},
+  {&stepperX2, AXIS_X2, X_AXIS},
+  {&stepperE0, AXIS_E0, E_AXIS},
+  {&stepperE1, AXIS_E1, E_AXIS},
+};
+
+static void driver_load_task(void *arg) {
+  TickType_t wake = xTaskGetTickCount();
+  for (;;) {
+    if (driver_load.active()) {
+      driver_load.sample();
+    }
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(DRIVER_LOAD_PERIOD_MS));
+  }
+}
+
+void DriverLoad::init() {
+  for (uint8_t i = 0; i < DRIVER_LOAD_COUNT; i++) {
+    load_[i].axis = load_src[i].axis;
+    load_[i].sg_result = DRIVER_LOAD_SG_NONE;
+    load_[i].sg_min = DRIVER_LOAD_SG_NONE;
+  }
+  // Below marlin_loop and tmc_uart (3), configMAX_PRIORITIES is 4
+  BaseType_t ret = xTaskCreate(driver_load_task, "drv_load", DRIVER_LOAD_TASK_STACK, NULL, DRIVER_LOAD_TASK_PRIORITY, NULL);
+  if (ret != pdPASS) {
+    SERIAL_ECHO("Failed to create drv_load!\n");
+  }
+}
+
+bool DriverLoad::active() {
+  return requested_ && (millis() - last_report_) < DRIVER_LOAD_IDLE_MS;
+}
+
+// Read every driver once, from the drv_load task. DRV_STATUS carries the
+// coil current, SG_RESULT is only read while the axis moves.
+void DriverLoad::sample() {
+  bool printing = system_service.get_status() == SYSTEM_STATUE_PRINTING;
+  for (uint8_t i = 0; i < DRIVER_LOAD_COUNT; i++) {
+    const driver_load_src_t &src = load_src[i];
+    float speed = axisManager.axis[src.speed_axis].cur_speed;
+    uint32_t line = printing ? power_loss.cur_line : 0;
+    bool moving = fabs(speed) > DRIVER_LOAD_MIN_SPEED;
+
+    // The CRC status comes with the read, CRCerror may already be that of
+    // a read of marlin_loop
+    uint16_t sg = load_[i].sg_result;
+    if (moving) {
+      uint32_t value;
+      if (!src.driver->read_checked(TMC2209_n::SG_RESULT_t::address, value)) {
+        continue;
+      }
+      sg = value;
+    }
+    TMC2208_n::DRV_STATUS_t status{0};
+    if (!src.driver->read_checked(TMC2208_n::DRV_STATUS_t::address, status.sr)) {
+      continue;
+    }
+
+    taskENTER_CRITICAL();
+    driver_load_info_t &load = load_[i];
+    load.sg_result = sg;
+    load.cs_actual = status.cs_actual;
+    load.drv_status = status.sr;
+    load.speed = speed;
+    load.line = line;
+    if (moving && sg < load.sg_min) {
+      load.sg_min = sg;
+    }
+    taskEXIT_CRITICAL();
+  }
+}
+
+// Latest samples of all drivers, the count is returned. Keeps the task
+// sampling and starts a new minimum.
+uint8_t DriverLoad::report(driver_load_info_t *info) {
+  taskENTER_CRITICAL();
+  for (uint8_t i = 0; i < DRIVER_LOAD_COUNT; i++) {
+    info[i] = load_[i];
+    load_[i].sg_min = DRIVER_LOAD_SG_NONE;
+  }
+  last_report_ = millis();
+  requested_ = true;
+  taskEXIT_CRITICAL();
+  return DRIVER_LOAD_COUNT;
+}
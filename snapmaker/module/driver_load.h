@@ -0,0 +1,83 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef DRIVER_LOAD_H
+#define DRIVER_LOAD_H
+
+/*
+ Load telemetry of the stepper drivers.
+
+ While a host subscribes to SYS_ID_SUBSCRIBE_DRIVER_LOAD, the drv_load task
+ reads DRV_STATUS of every TMC2209 over the driver UART once per
+ DRIVER_LOAD_PERIOD_MS, and SG_RESULT of the drivers whose axis runs faster
+ than DRIVER_LOAD_MIN_SPEED. The task runs at priority 1, below
+ marlin_loop and tmc_uart at 3, sleeps while it waits for a reply, and
+ stops DRIVER_LOAD_IDLE_MS after the last report was taken. A read of
+ marlin_loop still waits for the one drv_load has on the bus to end, the
+ bus mutex lifts drv_load to 3 for that read. Each sample keeps the G-code
+ line of the block the stepper runs and the speed of its axis at the time
+ of the read, so load and coil current can be set against speed and
+ acceleration.
+
+ A lower SG_RESULT is a higher load. Between two reports the lowest value
+ read while the axis ran faster than DRIVER_LOAD_MIN_SPEED is kept as
+ well, a carriage that starts to bind shows there before it skips steps.
+*/
+
+#include "../J1/common_type.h"
+
+#define DRIVER_LOAD_PERIOD_MS   100
+#define DRIVER_LOAD_IDLE_MS     3000
+#define DRIVER_LOAD_MIN_SPEED   5.0f    // mm/s
+#define DRIVER_LOAD_TASK_STACK  256
+#define DRIVER_LOAD_TASK_PRIORITY 1
+#define DRIVER_LOAD_COUNT       6
+#define DRIVER_LOAD_SG_NONE     0xFFFF
+
+#pragma pack(1)
+typedef struct {
+  uint8_t axis;         // AXIS_X1 ... AXIS_E1 of system.h
+  uint16_t sg_result;   // last read at speed, or DRIVER_LOAD_SG_NONE
+  uint16_t sg_min;      // lowest SG_RESULT at speed since the last report, or DRIVER_LOAD_SG_NONE
+  uint8_t cs_actual;    // coil current scale, 0 - 31
+  uint32_t drv_status;
+  float speed;          // mm/s of the axis at the read
+  uint32_t line;        // G-code line of the block being stepped
+} driver_load_info_t;
+#pragma pack()
+
+class DriverLoad {
+  public:
+    void init();
+    uint8_t report(driver_load_info_t *info);
+    void sample();
+    bool active();
+
+  private:
+    driver_load_info_t load_[DRIVER_LOAD_COUNT];
+    uint32_t last_report_ = 0;
+    bool requested_ = false;
+};
+
+extern DriverLoad driver_load;
+
+#endif
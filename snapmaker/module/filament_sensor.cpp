@@ -39,17 +39,9 @@ void FilamentSensor::init() {
   reset();
 }
 
+// Mean of the last conversions the ADC DMA scan made of the sensor
 uint16_t FilamentSensor::get_adc_val(uint8_t e) {
-  uint32_t val = 0;
-  uint8_t times = 5;
-  for (uint8_t i = 0; i < times; i++) {
-    if (e == 0) {
-      val += analogRead(FILAMENT0_ADC_PIN);
-    } else {
-      val += analogRead(FILAMENT1_ADC_PIN);
-    }
-  }
-  return val / times;
+  return HAL_adc_read(e == 0 ? FILAMENT0_ADC_PIN : FILAMENT1_ADC_PIN);
 }
 
 void FilamentSensor::reset() {
@@ -0,0 +1,246 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <libmaple/libmaple_types.h>
+#include "flash_eeprom.h"
+#include "flash_stm32.h"
+
+#ifdef __PLAT_LINUX__
+  // Host flash simulator of snapmaker/host
+  extern const uint8_t *flash_sim_map(uint32_t addr);
+  #define FE_PTR(addr) flash_sim_map(addr)
+#else
+  #define FE_PTR(addr) ((const uint8_t *)(addr))
+#endif
+
+static inline uint32_t read_word(uint32_t addr) {
+  uint32_t word;
+  memcpy(&word, FE_PTR(addr), sizeof(word));
+  return word;
+}
+
+static inline bool test_bit(const uint8_t *bits, uint32_t i) {
+  return bits[i >> 3] & (1 << (i & 7));
+}
+
+static inline void set_bit(uint8_t *bits, uint32_t i) {
+  bits[i >> 3] |= 1 << (i & 7);
+}
+
+void FlashEeprom::init(uint32_t base, uint32_t page_size, uint8_t *image, uint32_t size) {
+  base_ = base;
+  page_size_ = page_size;
+  image_ = image;
+  words_ = size / 4;
+  if (words_ > page_size / 4 - FLASH_EEPROM_HEAD_WORDS) {
+    words_ = page_size / 4 - FLASH_EEPROM_HEAD_WORDS;
+  }
+  if (words_ > FLASH_EEPROM_MAX_WORDS) {
+    words_ = FLASH_EEPROM_MAX_WORDS;
+  }
+}
+
+uint16_t FlashEeprom::check(uint16_t index, uint32_t value) {
+  uint8_t data[6];
+  memcpy(data, &index, 2);
+  memcpy(data + 2, &value, 4);
+  uint16_t a = 0x5A, b = 0;
+  for (uint8_t i = 0; i < sizeof(data); i++) {
+    a += data[i];
+    b += a;
+  }
+  uint16_t sum = (b << 8) ^ a;
+  return sum == 0xFFFF ? 0 : sum;
+}
+
+// The valid page with the newer generation, -1 without one
+int8_t FlashEeprom::find_page() {
+  int8_t found = -1;
+  for (int8_t page = 0; page < 2; page++) {
+    uint32_t addr = page_addr(page);
+    uint32_t gen = read_word(addr + 4);
+    if (read_word(addr) != FLASH_EEPROM_MAGIC || read_word(addr + 8) != ~gen ||
+        read_word(addr + 16) != 0 || read_word(addr + 12) > page_size_ / 4 - FLASH_EEPROM_HEAD_WORDS) {
+      continue;
+    }
+    if (found < 0 || (int32_t)(gen - generation_) > 0) {
+      found = page;
+      generation_ = gen;
+    }
+  }
+  return found;
+}
+
+void FlashEeprom::scan(int8_t page) {
+  uint32_t end = page_addr(page) + page_size_;
+  page_ = page;
+  entries_ = page_addr(page) + (FLASH_EEPROM_HEAD_WORDS + read_word(page_addr(page) + 12)) * 4;
+  committed_ = entries_;
+  free_ = entries_;
+  for (; free_ + 8 <= end; free_ += 8) {
+    uint32_t value = read_word(free_);
+    uint32_t tag = read_word(free_ + 4);
+    if (value == FLASH_EEPROM_BLANK && tag == FLASH_EEPROM_BLANK) {
+      return;
+    }
+    if ((tag & 0xFFFF) == FLASH_EEPROM_COMMIT && (tag >> 16) == check(FLASH_EEPROM_COMMIT, value)) {
+      committed_ = free_ + 8;
+    }
+  }
+  free_ = end;
+}
+
+// Word of the base image, blank past its end
+uint32_t FlashEeprom::stored_word(uint32_t index) {
+  uint32_t words = read_word(page_addr(page_) + 12);
+  return index < words ? read_word(page_addr(page_) + (FLASH_EEPROM_HEAD_WORDS + index) * 4) : FLASH_EEPROM_BLANK;
+}
+
+void FlashEeprom::load(uint32_t len) {
+  if (len > words_ * 4) {
+    len = words_ * 4;
+  }
+  int8_t page = find_page();
+  if (page < 0) {
+    memcpy(image_, FE_PTR(base_), len);
+    return;
+  }
+  scan(page);
+  for (uint32_t i = 0; i < len; i += 4) {
+    uint32_t word = stored_word(i / 4);
+    memcpy(image_ + i, &word, len - i < 4 ? len - i : 4);
+  }
+  for (uint32_t addr = entries_; addr < committed_; addr += 8) {
+    uint32_t value = read_word(addr);
+    uint32_t tag = read_word(addr + 4);
+    uint16_t index = tag & 0xFFFF;
+    if (index >= words_ || (tag >> 16) != check(index, value) || index * 4 >= len) {
+      continue;
+    }
+    memcpy(image_ + index * 4, &value, len - index * 4 < 4 ? len - index * 4 : 4);
+  }
+}
+
+bool FlashEeprom::save() {
+  int8_t page = find_page();
+  if (page < 0) {
+    return compact(-1);
+  }
+  scan(page);
+  if (free_ != committed_) {
+    // A save cut before its commit
+    return compact(page);
+  }
+
+  // The newest entry of a word is its stored value
+  memset(seen_, 0, sizeof(seen_));
+  memset(dirty_, 0, sizeof(dirty_));
+  uint32_t count = 0;
+  for (uint32_t addr = committed_; addr > entries_; addr -= 8) {
+    uint32_t value = read_word(addr - 8);
+    uint32_t tag = read_word(addr - 4);
+    uint16_t index = tag & 0xFFFF;
+    if (index >= words_ || (tag >> 16) != check(index, value) || test_bit(seen_, index)) {
+      continue;
+    }
+    set_bit(seen_, index);
+    if (memcmp(&value, image_ + index * 4, 4)) {
+      set_bit(dirty_, index);
+      count++;
+    }
+  }
+  for (uint32_t i = 0; i < words_; i++) {
+    if (!test_bit(seen_, i)) {
+      uint32_t word = stored_word(i);
+      if (memcmp(&word, image_ + i * 4, 4)) {
+        set_bit(dirty_, i);
+        count++;
+      }
+    }
+  }
+  if (!count) {
+    return true;
+  }
+  if (free_ + (count + 1) * 8 > page_addr(page) + page_size_) {
+    return compact(page);
+  }
+
+  bool ok = true;
+  FLASH_Unlock();
+  for (uint32_t i = 0; i < words_ && ok; i++) {
+    if (test_bit(dirty_, i)) {
+      uint32_t value;
+      memcpy(&value, image_ + i * 4, 4);
+      ok = program(free_, value) && program(free_ + 4, i | (uint32_t)check(i, value) << 16);
+      free_ += 8;
+    }
+  }
+  if (ok) {
+    ok = program(free_, count) && program(free_ + 4, FLASH_EEPROM_COMMIT | (uint32_t)check(FLASH_EEPROM_COMMIT, count) << 16);
+    free_ += 8;
+  }
+  FLASH_Lock();
+  committed_ = ok ? free_ : committed_;
+  return ok;
+}
+
+// Writes the image as the base of the other page and makes it the valid one
+bool FlashEeprom::compact(int8_t from) {
+  // The first page may hold the old layout
+  int8_t to = from == 1 ? 0 : 1;
+  uint32_t gen = from < 0 ? 1 : generation_ + 1;
+  uint32_t words = words_;
+  while (words && !memcmp(image_ + (words - 1) * 4, "\xFF\xFF\xFF\xFF", 4)) {
+    words--;
+  }
+
+  uint32_t addr = page_addr(to);
+  FLASH_Unlock();
+  bool ok = erase(to) && program(addr, FLASH_EEPROM_MAGIC) && program(addr + 4, gen) &&
+            program(addr + 8, ~gen) && program(addr + 12, words);
+  for (uint32_t i = 0; i < words && ok; i++) {
+    uint32_t value;
+    memcpy(&value, image_ + i * 4, 4);
+    ok = value == FLASH_EEPROM_BLANK || program(addr + (FLASH_EEPROM_HEAD_WORDS + i) * 4, value);
+  }
+  ok = ok && program(addr + 16, 0);
+  // A cut from here on leaves two valid pages, the new one is newer
+  ok = ok && erase(1 - to);
+  FLASH_Lock();
+
+  if (ok) {
+    generation_ = gen;
+    compactions++;
+  }
+  return ok;
+}
+
+bool FlashEeprom::program(uint32_t addr, uint32_t data) {
+  words_programmed++;
+  return FLASH_ProgramWord(addr, data) == FLASH_COMPLETE && read_word(addr) == data;
+}
+
+bool FlashEeprom::erase(int8_t page) {
+  pages_erased++;
+  return FLASH_ErasePage(page_addr(page)) == FLASH_COMPLETE;
+}
@@ -0,0 +1,96 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef FLASH_EEPROM_H
+#define FLASH_EEPROM_H
+
+/*
+ EEPROM emulation of the settings in two data flash pages.
+
+ The valid page holds a header, a base image of the settings and after it
+ the entries of the words changed since:
+
+   | magic | gen | ~gen | image words | valid | image ... | entries ... |
+
+ An entry is the new value of a word and a tag with the word index and a
+ 16 bit check, the value is programmed first. A save appends an entry for
+ each word that differs from the stored settings and a commit entry after
+ them, entries after the last commit are not applied.
+
+ When the entries do not fit, or a save was cut before its commit, the
+ settings are written as the base image of the other page, which is then
+ marked valid and the old page erased. Of two valid pages the one with the
+ newer generation is used, a page cut while erased fails the check of its
+ generation. So each page is erased once per fill of the entries instead
+ of on every save.
+
+ Without a valid page the first page is read as the raw image of the old
+ layout, the first save moves it to the second page.
+*/
+
+#include <stdint.h>
+
+#define FLASH_EEPROM_MAGIC        0x4B565345UL
+#define FLASH_EEPROM_BLANK        0xFFFFFFFFUL
+#define FLASH_EEPROM_HEAD_WORDS   5
+#define FLASH_EEPROM_MAX_WORDS    1024
+// Index of the entry closing a save
+#define FLASH_EEPROM_COMMIT       0xFFFEU
+
+class FlashEeprom {
+  public:
+    // image is the RAM copy of the settings, size a multiple of 4
+    void init(uint32_t base, uint32_t page_size, uint8_t *image, uint32_t size);
+    // Rebuilds the first len bytes of the image from flash
+    void load(uint32_t len);
+    // Writes the image changes, false if flash failed
+    bool save();
+
+    uint32_t words_programmed = 0;
+    uint32_t pages_erased = 0;
+    uint32_t compactions = 0;
+
+  private:
+    int8_t find_page();
+    void scan(int8_t page);
+    uint32_t stored_word(uint32_t addr);
+    bool compact(int8_t from);
+    bool program(uint32_t addr, uint32_t data);
+    bool erase(int8_t page);
+    uint32_t page_addr(int8_t page) { return base_ + page * page_size_; }
+    uint16_t check(uint16_t index, uint32_t value);
+
+    uint32_t base_;
+    uint32_t page_size_;
+    uint8_t *image_;
+    uint32_t words_;
+    // Found by scan(): the page, its entry area, end of the last commit and first free slot
+    int8_t page_;
+    uint32_t entries_;
+    uint32_t committed_;
+    uint32_t free_;
+    uint32_t generation_;
+    uint8_t seen_[FLASH_EEPROM_MAX_WORDS / 8];
+    uint8_t dirty_[FLASH_EEPROM_MAX_WORDS / 8];
+};
+
+#endif
@@ -0,0 +1,232 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "inactive_x.h"
+#include "src/module/motion.h"
+#include "src/module/planner.h"
+#include "src/module/AxisManager.h"
+#include "src/module/tool_change.h"
+#include "../debug/debug.h"
+#include "print_control.h"
+#include "system.h"
+#include "MapleFreeRTOS1030.h"
+
+InactiveX inactive_x;
+
+#define INACTIVE_X_NEXT(i) (((i) + 1) % INACTIVE_X_QUEUE_SIZE)
+
+ErrCode InactiveX::move_to(float x, float speed, float accel) {
+  if (print_control.get_mode() >= PRINT_DUPLICATION_MODE) {
+    LOG_I("work mode do not support this command\r\n");
+    return E_INVALID_STATE;
+  }
+  if (SYSTEM_STATUE_PRINTING != system_service.get_status()) {
+    LOG_I("Not printing, can not move T0 T1 now\r\n");
+    return E_INVALID_STATE;
+  }
+  if (speed <= 0 || accel <= 0) {
+    return E_PARAM;
+  }
+
+  ErrCode ret = E_SUCCESS;
+  taskENTER_CRITICAL();
+  if (INACTIVE_X_NEXT(head_) == tail_) {
+    ret = E_NO_RESRC;
+  } else {
+    inactive_x_move_t &move = queue_[head_];
+    move.tool = !active_extruder;
+    move.x = x;
+    move.speed = speed;
+    move.accel = accel;
+    head_ = INACTIVE_X_NEXT(head_);
+  }
+  taskEXIT_CRITICAL();
+  if (ret != E_SUCCESS) {
+    LOG_I("inactive x queue full\r\n");
+  }
+  return ret;
+}
+
+void InactiveX::clear() {
+  taskENTER_CRITICAL();
+  tail_ = head_;
+  taskEXIT_CRITICAL();
+}
+
+void InactiveX::reset() {
+  clear();
+  moves = 0;
+  clamped = 0;
+}
+
+bool InactiveX::busy() {
+  return head_ != tail_ || axisManager.T0_T1_simultaneously_move;
+}
+
+void InactiveX::report() {
+  LOG_I("inactive x moves:%u, clamped:%u\n", moves, clamped);
+}
+
+void InactiveX::loop() {
+  if (head_ == tail_) {
+    return;
+  }
+  if (SYSTEM_STATUE_PRINTING != system_service.get_status() ||
+      print_control.get_mode() >= PRINT_DUPLICATION_MODE) {
+    clear();
+    return;
+  }
+  if (axisManager.T0_T1_simultaneously_move || tool_changeing) {
+    return;
+  }
+
+  inactive_x_move_t move = queue_[tail_];
+  taskENTER_CRITICAL();
+  tail_ = INACTIVE_X_NEXT(tail_);
+  taskEXIT_CRITICAL();
+  // Queued for the carriage that is the active one now
+  if (move.tool == active_extruder) {
+    return;
+  }
+  start(move);
+}
+
+// X range of the active carriage: where it is and where the planned blocks take it
+void InactiveX::envelope(float &min, float &max) {
+  min = max = current_position.x;
+  for (uint8_t b = planner.block_buffer_tail; b != planner.block_buffer_head; b = BLOCK_MOD(b + 1)) {
+    float x = planner.block_buffer[b].destination.x;
+    NOMORE(min, x);
+    NOLESS(max, x);
+  }
+  float x = planner.get_axis_position_mm(X_AXIS);
+  NOMORE(min, x);
+  NOLESS(max, x);
+}
+
+ErrCode InactiveX::start(inactive_x_move_t &m) {
+  float min, max;
+  envelope(min, max);
+  float target = m.x;
+  // The home position is always clear of the active carriage
+  if (m.tool == 0) {
+    NOMORE(target, _MIN(min - EXTRUDERS_MIN_DISTANCE, float(X1_MAX_POS)));
+    NOLESS(target, x_home_pos(0));
+  } else {
+    NOLESS(target, _MAX(max + EXTRUDERS_MIN_DISTANCE, float(X2_MIN_POS)));
+    NOMORE(target, x_home_pos(1));
+  }
+  if (target != m.x) {
+    clamped++;
+    LOG_I("inactive x target %f clamped to %f, active in %f..%f\r\n", m.x, target, min, max);
+  }
+
+  float steps_per_mm = planner.settings.axis_steps_per_mm[X_AXIS];
+  float L = target - inactive_extruder_x;
+  int32_t home_steps = m.tool == 0 ? axisManager.X0_home_step_pos : axisManager.X1_home_step_pos;
+  int32_t target_steps = home_steps + LROUND((target - x_home_pos(m.tool)) * steps_per_mm);
+  axisManager.T0_T1_calc_steps = target_steps - axisManager.inactive_x_step_pos;
+  int32_t float_d_to_step_d = L * steps_per_mm;
+  if (abs(float_d_to_step_d - axisManager.T0_T1_calc_steps) > 5) {
+    axisManager.T0_T1_calc_steps = float_d_to_step_d;
+  }
+  if (0 == axisManager.T0_T1_calc_steps) {
+    return E_SUCCESS;
+  }
+
+  float millimeters = fabs(L);
+  float entry_speed = INACTIVE_X_ENTRY_SPEED / 1000.0f;
+  float leave_speed = INACTIVE_X_ENTRY_SPEED / 1000.0f;
+  float nominal_speed = _MAX(m.speed / 1000.0f, entry_speed);
+  float acceleration = m.accel / 1000000.0f;
+  float i_acceleration = 1.0f / acceleration;
+  float i_nominal_speed = 1.0f / nominal_speed;
+  float accelDistance = Planner::estimate_acceleration_distance(entry_speed, nominal_speed, acceleration);
+  float decelDistance = Planner::estimate_acceleration_distance(nominal_speed, leave_speed, -acceleration);
+  if (accelDistance < EPSILON) accelDistance = 0;
+  if (decelDistance < EPSILON) decelDistance = 0;
+  float plateau = millimeters - accelDistance - decelDistance;
+  float accelClocks = (nominal_speed - entry_speed) * i_acceleration;
+  float decelClocks = (nominal_speed - leave_speed) * i_acceleration;
+  float plateauClocks = plateau * i_nominal_speed;
+  if (plateau < 0) {
+    float newAccelDistance = Planner::intersection_distance(entry_speed, leave_speed, acceleration, millimeters);
+    if (newAccelDistance > millimeters) newAccelDistance = millimeters;
+    if (newAccelDistance < EPSILON) newAccelDistance = 0;
+    if ((millimeters - newAccelDistance) < EPSILON) newAccelDistance = millimeters;
+    accelDistance = newAccelDistance;
+    decelDistance = millimeters - accelDistance;
+    if (decelDistance < EPSILON) decelDistance = 0;
+    nominal_speed = SQRT(2 * acceleration * accelDistance + sq(entry_speed));
+    if (nominal_speed < leave_speed) nominal_speed = leave_speed;
+    accelClocks = (nominal_speed - entry_speed) * i_acceleration;
+    decelClocks = (nominal_speed - leave_speed) * i_acceleration;
+    plateauClocks = 0;
+    plateau = 0;
+  }
+
+  axisManager.T0_T1_simultaneously_move_req = true;
+  Move move;
+  axisManager.axis_t0_t1.reset();
+  move.start_t = 0;
+  move.t = 0;
+  move.axis_r[X_AXIS] = L > 0.0 ? steps_per_mm : -steps_per_mm;
+  move.start_pos[X_AXIS] = axisManager.axis_t0_t1.func_manager.last_pos;
+  move.distance = 0;
+  if (accelDistance > 0) {
+    move.accelerate = acceleration;
+    move.t = accelClocks;
+    move.distance = accelDistance;
+    axisManager.axis_t0_t1.generateLineFuncParams(&move, X_AXIS);
+  }
+  if (plateau > 0.0) {
+    move.start_pos[X_AXIS] = move.end_pos(X_AXIS);
+    move.start_t = move.end_t();
+    move.accelerate = 0;
+    move.t = plateauClocks;
+    move.distance = plateau;
+    axisManager.axis_t0_t1.generateLineFuncParams(&move, X_AXIS);
+  }
+  if (decelDistance > 0) {
+    move.start_pos[X_AXIS] = move.end_pos(X_AXIS);
+    move.start_t = move.end_t();
+    move.accelerate = -acceleration;
+    move.t = decelClocks;
+    move.distance = decelDistance;
+    axisManager.axis_t0_t1.generateLineFuncParams(&move, X_AXIS);
+  }
+  axisManager.T0_T1_execute_steps = 0;
+  axisManager.T0_T1_axis = m.tool;
+  axisManager.T0_T1_start_pos = inactive_extruder_x;
+  axisManager.T0_T1_target_pos = target;
+  // Toward the active carriage the target bounds the moves planned from now on,
+  // away from it the start does until the ISR ends the move
+  if ((m.tool == 0) == (L > 0)) {
+    inactive_extruder_x = target;
+  }
+  axisManager.T0_T1_last_print_time = 0;
+  axisManager.axis_t0_t1.is_consumed = true;
+  axisManager.T0_T1_simultaneously_move = true;
+  axisManager.T0_T1_simultaneously_move_req = false;
+  moves++;
+  return E_SUCCESS;
+}
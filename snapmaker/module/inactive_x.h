@@ -0,0 +1,84 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef INACTIVE_X_H
+#define INACTIVE_X_H
+
+/*
+ Motion channel of the inactive X carriage in full control mode.
+
+ Moves of the inactive carriage are queued by move_to() from G-code
+ (M2000 S200 X) and SACP (SYS_ID_MOVE_INACTIVE_X) and run one after the
+ other through the async X axis, axis_t0_t1 of the axis manager, while
+ the active carriage keeps printing. loop() starts the next move from the
+ Marlin task.
+
+ A target is clamped to stay EXTRUDERS_MIN_DISTANCE away from the X
+ envelope of the active carriage, its current position and the planned
+ blocks. While a move runs inactive_extruder_x holds the end of the move
+ nearest to the active carriage, so apply_motion_limits() keeps the moves
+ planned after it clear as well. The ISR sets the final position when the
+ move ends.
+
+ The queue is dropped when the print is no longer running or the tools
+ are changed.
+*/
+
+#include "../J1/common_type.h"
+#include "src/inc/MarlinConfigPre.h"
+
+#define INACTIVE_X_QUEUE_SIZE     4
+#define INACTIVE_X_ENTRY_SPEED    5.0f    // mm/s
+#define INACTIVE_X_SPEED_DEFAULT  200.0f  // mm/s
+#define INACTIVE_X_ACCEL_DEFAULT  6000.0f // mm/s^2
+
+typedef struct {
+  uint8_t tool;
+  float x;       // native position
+  float speed;   // mm/s
+  float accel;   // mm/s^2
+} inactive_x_move_t;
+
+class InactiveX {
+  public:
+    ErrCode move_to(float x, float speed, float accel);
+    void loop();
+    void clear();
+    void reset();
+    bool busy();
+    void report();
+
+    uint32_t moves = 0;
+    uint32_t clamped = 0;
+
+  private:
+    void envelope(float &min, float &max);
+    ErrCode start(inactive_x_move_t &move);
+
+    inactive_x_move_t queue_[INACTIVE_X_QUEUE_SIZE];
+    volatile uint8_t head_ = 0;
+    volatile uint8_t tail_ = 0;
+};
+
+extern InactiveX inactive_x;
+
+#endif
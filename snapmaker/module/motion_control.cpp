@@ -30,6 +30,9 @@
 #include "src/module/stepper/indirection.h"
 #include "../../Marlin/src/feature/tmc_util.h"
 #include "system.h"
+#include "print_control.h"
+#include "inactive_x.h"
+#include "../J1/switch_detect.h"
 #include "HAL.h"
 
 MotionControl motion_control;
@@ -416,20 +419,23 @@ void MotionControl::init_stall_guard() {
   sg_enable_status = 0xf;
 }
 
+// The writes of the thresholds are queued, they have reached the drivers
+// before the trigger is cleared and the EXTI armed
 void MotionControl::enable_stall_guard(uint8_t axis, uint8_t sg_value, uint8_t x_index) {
   #define ENABLE_SG(AXIS) do{\
                             stepper##AXIS.SGTHRS(sg_value); \
                             stepper##AXIS.TPWMTHRS(1); \
                             stepper##AXIS.TCOOLTHRS(0xFFFFF); \
+                            while (stepper##AXIS.SGTHRS() != sg_value) {\
+                              stepper##AXIS.SGTHRS(sg_value); \
+                              LOG_I("reset sg value\r\n");\
+                            }\
+                            TMC2208Stepper::uart_flush(); \
                             if (system_service.get_hw_version() != HW_VER_1) { \
                               set_sg_trigger(SG_##AXIS, false); \
                               set_sg_enable(SG_##AXIS, true); \
                               EnableExtiInterrupt(TMC_STALL_GUARD_##AXIS##_PIN); \
                             } \
-                            while (stepper##AXIS.SGTHRS() != sg_value) {\
-                              stepper##AXIS.SGTHRS(sg_value); \
-                              LOG_I("reset sg value\r\n");\
-                            }\
                           } while(0)
 
   switch (axis) {
@@ -478,6 +484,9 @@ void MotionControl::disable_stall_guard(uint8_t axis) {
       DISABLE_SG(Z);
       break;
   }
+  // The thresholds are off in the drivers before the next user of the
+  // DIAG lines clears its trigger
+  TMC2208Stepper::uart_flush();
 }
 
 void MotionControl::enable_stall_guard_only_axis(uint8_t axis, uint8_t sg_value, uint8_t x_index) {
@@ -491,6 +500,16 @@ void MotionControl::disable_stall_guard_all() {
   }
 }
 
+// Park the inactive X carriage with the async T0/T1 axis while the active
+// head keeps printing, speed in mm/s and accel in mm/s^2
+ErrCode MotionControl::park_inactive_x(float speed, float accel) {
+  ErrCode ret = inactive_x.move_to(x_home_pos(!active_extruder), speed, accel);
+  if (ret == E_SUCCESS) {
+    inactive_x.loop();
+  }
+  return ret;
+}
+
 void MotionControl::wait_G28() {
   do {
     if (!motion_is_homing) {
@@ -542,6 +561,16 @@ extern "C" {
   }
 
   void __irq_exti9_5() {
+    if(ExitGetITStatus(X0_CAL_PIN)) {
+      ExtiClearITPendingBit(X0_CAL_PIN);
+      switch_detect.capture_probe_edge(0);
+    }
+
+    if(ExitGetITStatus(X1_CAL_PIN)) {
+      ExtiClearITPendingBit(X1_CAL_PIN);
+      switch_detect.capture_probe_edge(1);
+    }
+
     if(ExitGetITStatus(TMC_STALL_GUARD_Z_PIN)) {
       ExtiClearITPendingBit(TMC_STALL_GUARD_Z_PIN);
       // if (stepper.axis_is_moving(Z_AXIS) && motion_control.is_sg_enable(SG_Z)) {
@@ -40,6 +40,21 @@ PowerLoss power_loss;
 
 extern feedRate_t fast_move_feedrate;
 
+void PowerLoss::stash_state() {
+  stash_data.active_extruder = active_extruder;
+  stash_data.feedrate_percentage = feedrate_percentage;
+  stash_data.travel_feadrate = fast_move_feedrate;
+  stash_data.axis_relative = gcode.axis_relative;
+  stash_data.home_offset = home_offset;
+  stash_data.print_offset = print_control.xyz_offset;
+  stash_data.noise_mode = print_control.get_noise_mode();
+  HOTEND_LOOP() {
+    stash_data.extruder_dual_enable[e] = fdm_head.is_duplication_enabled(e);
+    stash_data.extruder_temperature_lock[e] = print_control.temperature_lock(e);
+    stash_data.flow_percentage[e] = planner.flow_percentage[e];
+  }
+}
+
 void PowerLoss::stash_print_env() {
 
   xyze_pos_t cur_position;
@@ -61,17 +76,11 @@ void PowerLoss::stash_print_env() {
 
   stash_data.dual_x_carriage_mode = dual_x_carriage_mode;
   stash_data.print_feadrate = feedrate_mm_s;
-  stash_data.feedrate_percentage = feedrate_percentage;
-  stash_data.active_extruder = active_extruder;
   // stash_data.motion_extruder = cur_extruder;
-  stash_data.travel_feadrate = fast_move_feedrate;
-  stash_data.axis_relative = gcode.axis_relative;
   stash_data.print_mode = print_control.mode_;
   stash_data.duplicate_extruder_x_offset = duplicate_extruder_x_offset;
-  stash_data.home_offset = home_offset;
-  stash_data.print_offset = print_control.xyz_offset;
   stash_data.work_time = print_control.get_work_time();
-  stash_data.noise_mode = print_control.get_noise_mode();
+  stash_state();
 
   stash_data.bed_temp = thermalManager.degTargetBed();
   HOTEND_LOOP() {
@@ -81,12 +90,9 @@ void PowerLoss::stash_print_env() {
     else {
       stash_data.nozzle_temp[e] = 0;
     }
-    stash_data.extruder_dual_enable[e] = fdm_head.is_duplication_enabled(e);
-    stash_data.extruder_temperature_lock[e] = print_control.temperature_lock(e);
     for (uint8_t i = 0; i < 2; i++) {
       fdm_head.get_fan_speed(e, i, stash_data.fan[e][i]);
     }
-    stash_data.flow_percentage[e] = planner.flow_percentage[e];
   }
 
 }
@@ -231,6 +237,7 @@ ErrCode PowerLoss::extrude_before_resume() {
   // resume dual_x_carriage_mode
   dual_x_carriage_mode = (DualXMode)stash_data.dual_x_carriage_mode;
   idex_set_mirrored_mode(dual_x_carriage_mode == DXC_MIRRORED_MODE);
+  axisManager.input_shaper_select(axisManager.input_shaper_profile_of(active_extruder));
 
   return ret;
 }
@@ -297,27 +304,189 @@ void PowerLoss::resume_print_env() {
   next_req = cur_line = line_number_sum = stash_data.file_position;
 }
 
+void PowerLoss::pack_job(pl_job_t &job) {
+  memset(&job, 0, sizeof(job));
+  job.gcode_file_name_len = stash_data.gcode_file_name_len;
+  job.gcode_file_md5_len = stash_data.gcode_file_md5_len;
+  job.print_mode = stash_data.print_mode;
+  job.dual_x_carriage_mode = stash_data.dual_x_carriage_mode;
+  memcpy(job.gcode_file_name, stash_data.gcode_file_name, GCODE_FILE_NAME_SIZE);
+  memcpy(job.gcode_file_md5, stash_data.gcode_file_md5, GCODE_MD5_LENGTH);
+  job.duplicate_extruder_x_offset = stash_data.duplicate_extruder_x_offset;
+}
+
+void PowerLoss::write_job() {
+  pl_job_t job;
+  pack_job(job);
+  job_written_ = log.append(PL_RECORD_JOB, &job, sizeof(job));
+  state_journaled_ = false;
+}
+
+/**
+ * The job record of a print, once the file name and md5 are set. It starts
+ * the page not in use, the records of the last print stay until it holds the job.
+ */
+void PowerLoss::start_job() {
+  stash_data.print_mode = print_control.mode_;
+  stash_data.dual_x_carriage_mode = dual_x_carriage_mode;
+  stash_data.duplicate_extruder_x_offset = duplicate_extruder_x_offset;
+  pl_job_t job;
+  pack_job(job);
+  job_written_ = log.start_page() && log.keep(PL_RECORD_JOB, &job, sizeof(job)) && log.start_page_done();
+  state_journaled_ = false;
+  if (!job_written_ && log.clear()) {
+    write_job();
+  }
+}
+
+void PowerLoss::pack_state(pl_state_t &state) {
+  memset(&state, 0, sizeof(state));
+  state.travel_feadrate = stash_data.travel_feadrate;
+  state.feedrate_percentage = stash_data.feedrate_percentage;
+  HOTEND_LOOP() {
+    state.flow_percentage[e] = stash_data.flow_percentage[e];
+    state.extruder_dual_enable[e] = stash_data.extruder_dual_enable[e];
+    state.extruder_temperature_lock[e] = stash_data.extruder_temperature_lock[e];
+  }
+  state.active_extruder = stash_data.active_extruder;
+  state.axis_relative = stash_data.axis_relative;
+  state.noise_mode = stash_data.noise_mode;
+  state.home_offset = stash_data.home_offset;
+  state.print_offset = stash_data.print_offset;
+}
+
+/**
+ * Journal the state of the print when it changes, outside the power-fail path
+ */
+void PowerLoss::journal() {
+  if (!job_written_ || system_service.get_status() != SYSTEM_STATUE_PRINTING ||
+      PENDING(millis(), next_journal_ms_)) {
+    return;
+  }
+  next_journal_ms_ = millis() + PL_JOURNAL_INTERVAL_MS;
+
+  pl_state_t state;
+  stash_state();
+  pack_state(state);
+  if (state_journaled_ && !memcmp(&state, &journaled_state_, sizeof(state))) {
+    return;
+  }
+  // Keep room for a state and a delta in the power-fail path. The job and the
+  // state move to the page not in use, the page in use is not erased.
+  if (log.free_space() < sizeof(pl_state_t) + sizeof(pl_delta_t) + 8 + sizeof(pl_state_t) + 4) {
+    LOG_I("PL: move power loss log to the next page\n");
+    pl_job_t job;
+    pack_job(job);
+    if (log.start_page() && log.keep(PL_RECORD_JOB, &job, sizeof(job)) &&
+        log.keep(PL_RECORD_STATE, &state, sizeof(state)) && log.start_page_done()) {
+      journaled_state_ = state;
+      state_journaled_ = true;
+    }
+    return;
+  }
+  if (log.append(PL_RECORD_STATE, &state, sizeof(state))) {
+    journaled_state_ = state;
+    state_journaled_ = true;
+  }
+}
+
  /**
  * save the power panic data to flash
  */
 void PowerLoss::write_flash(void)
 {
-  uint32_t addr = FLASH_MARLIN_POWERPANIC;
-	uint32_t u32data;
-	uint8_t *buff = (uint8_t *)&stash_data;
+  if (!job_written_) {
+    write_job();
+  }
+
+  pl_state_t state;
+  pack_state(state);
+  if (!state_journaled_ || memcmp(&state, &journaled_state_, sizeof(state))) {
+    if (log.append(PL_RECORD_STATE, &state, sizeof(state))) {
+      journaled_state_ = state;
+      state_journaled_ = true;
+    }
+  }
+
+  pl_delta_t delta;
+  memset(&delta, 0, sizeof(delta));
+  delta.file_position = stash_data.file_position;
+  delta.position = stash_data.position;
+  delta.work_time = stash_data.work_time;
+  HOTEND_LOOP() {
+    delta.nozzle_temp[e] = stash_data.nozzle_temp[e];
+    delta.fan[e][0] = stash_data.fan[e][0];
+    delta.fan[e][1] = stash_data.fan[e][1];
+  }
+  delta.bed_temp = stash_data.bed_temp;
+  delta.print_feadrate = LROUND(stash_data.print_feadrate * 10);
+  if (log.append(PL_RECORD_DELTA, &delta, sizeof(delta))) {
+    stash_data.state = PL_WAIT_RESUME;
+  }
+}
+
+bool PowerLoss::load_log() {
+  const pl_job_t *job = (const pl_job_t *)log.newest(PL_RECORD_JOB, sizeof(pl_job_t));
+  const pl_state_t *state = (const pl_state_t *)log.newest(PL_RECORD_STATE, sizeof(pl_state_t));
+  const pl_delta_t *delta = (const pl_delta_t *)log.newest(PL_RECORD_DELTA, sizeof(pl_delta_t));
+  if (!job || !state || !delta) {
+    return false;
+  }
+
+  stash_data.gcode_file_name_len = job->gcode_file_name_len;
+  stash_data.gcode_file_md5_len = job->gcode_file_md5_len;
+  memcpy(stash_data.gcode_file_name, job->gcode_file_name, GCODE_FILE_NAME_SIZE);
+  memcpy(stash_data.gcode_file_md5, job->gcode_file_md5, GCODE_MD5_LENGTH);
+  stash_data.print_mode = job->print_mode;
+  stash_data.dual_x_carriage_mode = job->dual_x_carriage_mode;
+  stash_data.duplicate_extruder_x_offset = job->duplicate_extruder_x_offset;
+
+  stash_data.travel_feadrate = state->travel_feadrate;
+  stash_data.feedrate_percentage = state->feedrate_percentage;
+  stash_data.active_extruder = state->active_extruder;
+  stash_data.axis_relative = state->axis_relative;
+  stash_data.noise_mode = state->noise_mode;
+  stash_data.home_offset = state->home_offset;
+  stash_data.print_offset = state->print_offset;
+
+  stash_data.file_position = delta->file_position;
+  stash_data.position = delta->position;
+  stash_data.work_time = delta->work_time;
+  stash_data.bed_temp = delta->bed_temp;
+  stash_data.print_feadrate = delta->print_feadrate / 10.0f;
+  HOTEND_LOOP() {
+    stash_data.flow_percentage[e] = state->flow_percentage[e];
+    stash_data.extruder_dual_enable[e] = state->extruder_dual_enable[e];
+    stash_data.extruder_temperature_lock[e] = state->extruder_temperature_lock[e];
+    stash_data.nozzle_temp[e] = delta->nozzle_temp[e];
+    stash_data.fan[e][0] = delta->fan[e][0];
+    stash_data.fan[e][1] = delta->fan[e][1];
+  }
   stash_data.state = PL_WAIT_RESUME;
-  stash_data.check_num = 0;
-  for (uint32_t i = 0; i < sizeof(power_loss_t) - 4; i++) {
-    stash_data.check_num += buff[i];
-  }
-
-	FLASH_Unlock();
-	for (uint32_t i = 0; i < sizeof(power_loss_t); i = i + 4) {
-		u32data = (buff[i + 3] << 24) | (buff[i + 2] << 16) | (buff[i + 1] << 8) | buff[i];
-		FLASH_ProgramWord(addr, u32data);
-		addr = addr + 4;
-	}
-	FLASH_Lock();
+  return true;
+}
+
+// power_loss_t as written by firmware before the power-loss log
+bool PowerLoss::load_legacy() {
+  uint8_t *flash_addr = (uint8_t *)FLASH_MARLIN_POWERPANIC;
+  uint8_t *ram_addr = (uint8_t *)&stash_data;
+  uint32_t check_num = 0;
+
+  for (uint32_t i = 0; i < sizeof(power_loss_t); i++) {
+    ram_addr[i] = flash_addr[i];
+    if (i < sizeof(power_loss_t) - 4) {
+      check_num += flash_addr[i];
+    }
+  }
+  if (stash_data.state != PL_WAIT_RESUME) {
+    return false;
+  }
+  if (check_num != stash_data.check_num) {
+    stash_data.state = PL_NO_DATE;
+    SERIAL_ECHOLNPAIR("PL: Unavailable data!, checknum:", check_num, "-", stash_data.check_num);
+    return false;
+  }
+  return true;
 }
 
 void PowerLoss::show_power_loss_info() {
@@ -348,27 +517,14 @@ void PowerLoss::show_power_loss_info() {
 }
 
 void PowerLoss::init() {
-  uint8_t *flash_addr = (uint8_t *)FLASH_MARLIN_POWERPANIC;
-  uint8_t *ram_addr = (uint8_t *)&stash_data;
-  uint32_t check_num = 0;
-
   SET_INPUT_PULLUP(HW_1_2(POWER_LOST_220V_HW1_PIN, POWER_LOST_220V_HW2_PIN));
 
-  for (uint32_t i = 0; i < sizeof(power_loss_t); i++) {
-    ram_addr[i] = flash_addr[i];
-    if (i < sizeof(power_loss_t) - 4) {
-      check_num += flash_addr[i];
-    }
-  }
-  if (stash_data.state == PL_WAIT_RESUME) {
-    if (check_num == stash_data.check_num) {
-      SERIAL_ECHOLNPAIR("PL: Got available data!");
-      // show_power_loss_info();
-    } else {
-      stash_data.state = PL_NO_DATE;
-      SERIAL_ECHOLNPAIR("PL: Unavailable data!, checknum:", check_num, "-", stash_data.check_num);
-    }
+  log.init(FLASH_MARLIN_POWERPANIC, POWERLOSS_DATA_SIZE, DATA_FLASH_PAGE_SIZE);
+  if (load_log() || load_legacy()) {
+    SERIAL_ECHOLNPAIR("PL: Got available data!");
+    // show_power_loss_info();
   } else {
+    stash_data.state = PL_NO_DATE;
     SERIAL_ECHOLNPAIR("PL: No data!");
   }
 
@@ -381,16 +537,16 @@ void PowerLoss::init() {
 
 void PowerLoss::clear() {
   SERIAL_ECHOLNPGM("PL: clear power loss data!");
-  uint8_t *flash_addr = (uint8_t *)FLASH_MARLIN_POWERPANIC;
-  for (uint32_t i = 0; i < sizeof(power_loss_t); i++) {
-    if (flash_addr[i] != 0xff) {
-      SERIAL_ECHOLNPGM("PL: erase flash data!");
-      FLASH_Unlock();
-      FLASH_ErasePage(FLASH_MARLIN_POWERPANIC);
-      FLASH_Lock();
-      break;
+  // A clear record hides the data, the page not in use is only started when
+  // the page in use is full
+  if (!log.empty() && !log.clear()) {
+    SERIAL_ECHOLNPGM("PL: start a new power loss page!");
+    if (!log.start_page() || !log.start_page_done()) {
+      SERIAL_ECHOLNPGM("PL: clear failed!");
     }
   }
+  job_written_ = false;
+  state_journaled_ = false;
   stash_data.state = PL_NO_DATE;
 }
 
@@ -436,6 +592,7 @@ ErrCode PowerLoss::power_loss_resume() {
   next_req = cur_line = line_number_sum = stash_data.file_position;
   update_workspace_offset(Z_AXIS);
   clear();
+  write_job();
   print_control.set_work_time(stash_data.work_time);
   print_control.mode_ = (print_mode_e)stash_data.print_mode;
   print_control.set_noise_mode(print_noise_mode_e(stash_data.noise_mode & 0xFF));
@@ -23,6 +23,7 @@
 #define POWER_LOSS_H
 #include "../J1/common_type.h"
 #include "src/core/types.h"
+#include "power_loss_log.h"
 
 #define GCODE_MD5_LENGTH 64
 #define GCODE_FILE_NAME_SIZE 128
@@ -31,6 +32,13 @@
 #define PL_WORKING      0x55
 #define PL_WAIT_RESUME  0xAA
 
+// Records of the power-loss log
+#define PL_RECORD_JOB     0x01
+#define PL_RECORD_STATE   0x02
+#define PL_RECORD_DELTA   0x03
+
+#define PL_JOURNAL_INTERVAL_MS  1000
+
 #define Z_DOWN_SAFE_DISTANCE      2  // mm
 #define PRINT_RETRACK_DISTANCE    1  // mm
 #define Z_LIVE_OFFSET_RETRACE_D   0.2  // mm
@@ -85,6 +93,47 @@ typedef struct {
 
 #pragma pack()
 
+/*
+ The flash copy of power_loss_t is split into three records:
+ the job, written once when the print starts, the state that changes
+ now and then, journaled when it does, and the delta appended in the
+ power-fail path. Resume takes the newest valid one of each.
+*/
+# pragma pack(4)
+typedef struct {
+  uint8_t gcode_file_name_len;
+  uint8_t gcode_file_md5_len;
+  uint8_t print_mode;
+  uint8_t dual_x_carriage_mode;
+  uint8_t gcode_file_name[GCODE_FILE_NAME_SIZE];
+  uint8_t gcode_file_md5[GCODE_MD5_LENGTH];
+  float duplicate_extruder_x_offset;
+} pl_job_t;
+
+typedef struct {
+  float travel_feadrate;
+  int16_t feedrate_percentage;
+  int16_t flow_percentage[EXTRUDERS];
+  uint8_t extruder_dual_enable[EXTRUDERS];
+  uint8_t extruder_temperature_lock[EXTRUDERS];
+  uint8_t active_extruder;
+  uint8_t axis_relative;
+  uint8_t noise_mode;
+  xyz_pos_t home_offset;
+  xyz_pos_t print_offset;
+} pl_state_t;
+
+typedef struct {
+  uint32_t file_position;
+  xyze_pos_t position;
+  uint32_t work_time;
+  uint16_t nozzle_temp[EXTRUDERS];
+  uint16_t bed_temp;
+  uint16_t print_feadrate;  // 0.1 mm/s
+  uint8_t fan[EXTRUDERS][2];
+} pl_delta_t;
+#pragma pack()
+
 class PowerLoss {
   public:
     AT_END_OF_TEXT void init();
@@ -106,8 +155,16 @@ class PowerLoss {
     void close_peripheral_power();
     void process();
     void write_flash(void);
+    void start_job();
+    void journal();
   private:
     bool wait_temp_resume();
+    void stash_state();
+    void pack_job(pl_job_t &job);
+    void write_job();
+    void pack_state(pl_state_t &state);
+    bool load_log();
+    bool load_legacy();
 
   public:
     uint32_t cur_line = 0;
@@ -119,6 +176,13 @@ class PowerLoss {
     bool is_trigger = false;
     bool is_inited = false;
     power_loss_t stash_data;
+    PowerLossLog log;
+
+  private:
+    bool job_written_ = false;
+    pl_state_t journaled_state_;
+    bool state_journaled_ = false;
+    uint32_t next_journal_ms_ = 0;
 };
 
 extern PowerLoss power_loss;
@@ -0,0 +1,267 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include <libmaple/libmaple_types.h>
+#include "power_loss_log.h"
+#include "flash_stm32.h"
+
+#ifdef __PLAT_LINUX__
+  // Host flash simulator of snapmaker/host
+  extern const uint8_t *flash_sim_map(uint32_t addr);
+  #define PL_LOG_PTR(addr) flash_sim_map(addr)
+  static inline uint32_t irq_save() { return 0; }
+  static inline void irq_restore(uint32_t) {}
+#else
+  #define PL_LOG_PTR(addr) ((const uint8_t *)(addr))
+  static inline uint32_t irq_save() {
+    uint32_t primask;
+    __asm volatile ("mrs %0, primask\n cpsid i" : "=r" (primask) :: "memory");
+    return primask;
+  }
+  static inline void irq_restore(uint32_t primask) {
+    __asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+  }
+#endif
+
+static inline uint32_t read_word(uint32_t addr) {
+  uint32_t word;
+  memcpy(&word, PL_LOG_PTR(addr), sizeof(word));
+  return word;
+}
+
+void PowerLossLog::init(uint32_t base, uint32_t size, uint32_t page_size) {
+  base_ = base;
+  size_ = size;
+  page_size_ = page_size;
+  scan();
+}
+
+uint16_t PowerLossLog::check(uint8_t type, uint8_t words, const uint8_t *data) {
+  uint16_t a = type, b = words;
+  for (uint32_t i = 0; i < words * 4U; i++) {
+    a += data[i];
+    b += a;
+  }
+  // Never 0xFFFF, the check of a blank head
+  uint16_t sum = (b << 8) ^ a;
+  return sum == 0xFFFF ? 0 : sum;
+}
+
+// Sequence number of a started page, false for a page not started
+bool PowerLossLog::page_seq(uint32_t page, uint32_t &seq) {
+  uint32_t word = read_word(page);
+  seq = read_word(page + 4);
+  pl_log_head_t head;
+  memcpy(&head, &word, sizeof(head));
+  return head.type == PL_LOG_PAGE && head.words == 1 && head.check == check(PL_LOG_PAGE, 1, (const uint8_t *)&seq);
+}
+
+// Finds the first blank word of a page, a broken head ends the log. The
+// records before the last clear record are hidden.
+uint32_t PowerLossLog::scan_page(uint32_t page) {
+  uint32_t addr = page + 8;
+  uint32_t end = page + page_size_;
+  visible_ = addr;
+  while (addr + 4 <= end) {
+    uint32_t word = read_word(addr);
+    if (word == PL_LOG_BLANK) {
+      break;
+    }
+    pl_log_head_t head;
+    memcpy(&head, &word, sizeof(head));
+    uint32_t next = addr + 4 + head.words * 4U;
+    if (!head.words || next > end) {
+      addr = end;
+      break;
+    }
+    if (head.type == PL_LOG_CLEAR && head.check == check(head.type, head.words, PL_LOG_PTR(addr + 4))) {
+      visible_ = next;
+    }
+    addr = next;
+  }
+  return addr;
+}
+
+// The page in use is the started one with the newest sequence
+void PowerLossLog::scan() {
+  page_ = 0;
+  for (uint32_t page = base_; page + page_size_ <= base_ + size_; page += page_size_) {
+    uint32_t seq;
+    if (page_seq(page, seq) && (!page_ || (int32_t)(seq - seq_) > 0)) {
+      page_ = page;
+      seq_ = seq;
+    }
+  }
+  if (page_) {
+    free_ = scan_page(page_);
+  } else {
+    free_ = visible_ = 0;
+  }
+}
+
+// Head and payload words of a record, the flash is unlocked
+void PowerLossLog::program(uint32_t addr, uint8_t type, const void *data, uint16_t len) {
+  const uint8_t *buf = (const uint8_t *)data;
+  pl_log_head_t head;
+  head.type = type;
+  head.words = len / 4;
+  head.check = check(type, head.words, buf);
+  uint32_t word;
+  memcpy(&word, &head, sizeof(word));
+  FLASH_ProgramWord(addr, word);
+  for (uint16_t i = 0; i < len; i += 4) {
+    addr += 4;
+    memcpy(&word, buf + i, sizeof(word));
+    FLASH_ProgramWord(addr, word);
+  }
+  words_programmed += head.words + 1;
+}
+
+// Also called from the stepper ISR in the power-fail path. The space is
+// taken and the head programmed with interrupts off, so a record appended
+// from the ISR always follows a complete head.
+bool PowerLossLog::append(uint8_t type, const void *data, uint16_t len) {
+  if ((len & 3) || !len || len / 4 > 0xFF) {
+    return false;
+  }
+  const uint8_t *buf = (const uint8_t *)data;
+  pl_log_head_t head;
+  head.type = type;
+  head.words = len / 4;
+  head.check = check(type, head.words, buf);
+  uint32_t word;
+  memcpy(&word, &head, sizeof(word));
+
+  uint32_t primask = irq_save();
+  if (free_space() < len + 4U) {
+    irq_restore(primask);
+    return false;
+  }
+  uint32_t addr = free_;
+  free_ += len + 4;
+  FLASH_Unlock();
+  FLASH_ProgramWord(addr, word);
+  irq_restore(primask);
+
+  for (uint16_t i = 0; i < len; i += 4) {
+    addr += 4;
+    memcpy(&word, buf + i, sizeof(word));
+    FLASH_ProgramWord(addr, word);
+  }
+  FLASH_Lock();
+  words_programmed += head.words + 1;
+  return true;
+}
+
+bool PowerLossLog::clear() {
+  uint32_t none = 0;
+  if (!append(PL_LOG_CLEAR, &none, sizeof(none))) {
+    return false;
+  }
+  visible_ = free_;
+  return true;
+}
+
+// Erases the page after the one in use, never the page in use itself
+bool PowerLossLog::start_page() {
+  next_page_ = page_ ? page_ + page_size_ : base_;
+  if (next_page_ + page_size_ > base_ + size_) {
+    next_page_ = base_;
+  }
+  if (next_page_ == page_) {
+    next_page_ = 0;
+    return false;
+  }
+  start_free_ = free_;
+  FLASH_Unlock();
+  for (uint32_t addr = next_page_; addr < next_page_ + page_size_; addr += 4) {
+    if (read_word(addr) != PL_LOG_BLANK) {
+      FLASH_ErasePage(next_page_);
+      pages_erased++;
+      break;
+    }
+  }
+  FLASH_Lock();
+  next_free_ = next_page_ + 8;
+  return true;
+}
+
+bool PowerLossLog::keep(uint8_t type, const void *data, uint16_t len) {
+  if (!next_page_ || (len & 3) || !len || len / 4 > 0xFF || next_free_ + 4 + len > next_page_ + page_size_) {
+    return false;
+  }
+  FLASH_Unlock();
+  program(next_free_, type, data, len);
+  FLASH_Lock();
+  next_free_ += len + 4;
+  return true;
+}
+
+// The sequence record makes the started page the one in use. Dropped when
+// the power-fail path appended to the page in use since start_page().
+bool PowerLossLog::start_page_done() {
+  if (!next_page_) {
+    return false;
+  }
+  uint32_t seq = page_ ? seq_ + 1 : 1;
+  uint32_t primask = irq_save();
+  if (free_ != start_free_) {
+    irq_restore(primask);
+    next_page_ = 0;
+    return false;
+  }
+  pl_log_head_t head;
+  head.type = PL_LOG_PAGE;
+  head.words = 1;
+  head.check = check(PL_LOG_PAGE, 1, (const uint8_t *)&seq);
+  uint32_t word;
+  memcpy(&word, &head, sizeof(word));
+  // The sequence first, a cut before the head leaves the page not started
+  FLASH_Unlock();
+  FLASH_ProgramWord(next_page_ + 4, seq);
+  FLASH_ProgramWord(next_page_, word);
+  FLASH_Lock();
+  page_ = next_page_;
+  seq_ = seq;
+  visible_ = page_ + 8;
+  free_ = next_free_;
+  next_page_ = 0;
+  irq_restore(primask);
+  words_programmed += 2;
+  return true;
+}
+
+const void *PowerLossLog::newest(uint8_t type, uint16_t len) {
+  const void *found = NULL;
+  for (uint32_t addr = visible_; addr < free_; ) {
+    uint32_t word = read_word(addr);
+    pl_log_head_t head;
+    memcpy(&head, &word, sizeof(head));
+    const uint8_t *data = PL_LOG_PTR(addr + 4);
+    if (head.type == type && head.words * 4U == len && head.check == check(type, head.words, data)) {
+      found = data;
+    }
+    addr += 4 + head.words * 4U;
+  }
+  return found;
+}
@@ -0,0 +1,108 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef POWER_LOSS_LOG_H
+#define POWER_LOSS_LOG_H
+
+/*
+ Append only record log in the pre-erased power-loss flash pages.
+
+ A record is a head word and the payload:
+
+   | type | words | check | payload ... |
+
+ words is the payload size in words and check a 16 bit sum over type,
+ words and the payload bytes. A record is appended at the first blank word,
+ one torn by a power cut fails its check and is skipped. The newest valid
+ record of a type is the last one in the log after the last clear record.
+
+ Records go to one page at a time, the page in use. Its first record holds
+ a sequence number and the page with the newest valid one is in use. A new
+ page is started outside the power-fail path: the page not in use is erased,
+ the records to keep are written after its blank first record, and only
+ then the sequence record is programmed. Until that word the page in use
+ stays valid, so a cut while a page is started leaves the old records, and
+ the page in use is never erased. A start is dropped when the power-fail
+ path appended to the page in use meanwhile.
+
+ An append is always a plain word program of a few words. An append from
+ the power-fail path that interrupts one from the task goes after it, the
+ torn one is skipped.
+*/
+
+#include <stdint.h>
+
+#define PL_LOG_BLANK        0xFFFFFFFFUL
+// First record of a page, the payload is its sequence number
+#define PL_LOG_PAGE         0xFE
+// Hides the records before it
+#define PL_LOG_CLEAR        0xFD
+
+typedef struct {
+  uint8_t type;
+  uint8_t words;
+  uint16_t check;
+} pl_log_head_t;
+
+class PowerLossLog {
+  public:
+    void init(uint32_t base, uint32_t size, uint32_t page_size);
+    void scan();
+    bool append(uint8_t type, const void *data, uint16_t len);
+    // Hides the records so far, false when the page in use is full
+    bool clear();
+    // Starts the page not in use, records written with keep() go to it and
+    // it is used from start_page_done() on
+    bool start_page();
+    bool keep(uint8_t type, const void *data, uint16_t len);
+    bool start_page_done();
+    // Payload of the newest valid record of type with len bytes, NULL without one
+    const void *newest(uint8_t type, uint16_t len);
+    // A started page without records since the last clear
+    bool empty() { return page_ && free_ == visible_; }
+    uint32_t free_space() { return page_ ? page_ + page_size_ - free_ : 0; }
+
+    uint32_t words_programmed = 0;
+    uint32_t pages_erased = 0;
+
+  private:
+    uint16_t check(uint8_t type, uint8_t words, const uint8_t *data);
+    bool page_seq(uint32_t page, uint32_t &seq);
+    uint32_t scan_page(uint32_t page);
+    void program(uint32_t addr, uint8_t type, const void *data, uint16_t len);
+
+    uint32_t base_;
+    uint32_t size_;
+    uint32_t page_size_;
+    // Page in use, 0 before a page is started, its sequence, the first record
+    // after the last clear and the first blank word
+    uint32_t page_ = 0;
+    uint32_t seq_ = 0;
+    uint32_t visible_ = 0;
+    volatile uint32_t free_ = 0;
+    // Page being started and its next blank word
+    uint32_t next_page_ = 0;
+    uint32_t next_free_ = 0;
+    uint32_t start_free_ = 0;
+};
+
+#endif
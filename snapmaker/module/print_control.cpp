@@ -34,6 +34,8 @@
 #include "power_loss.h"
 #include "../module/filament_sensor.h"
 #include "exception.h"
+#include "tool_lookahead.h"
+#include "inactive_x.h"
 
 bool is_hmi_printing = false;  // Default to false (not HMI)
 
@@ -47,6 +49,11 @@ uint16_t buffer_head = 0;
 uint16_t buffer_tail = 0;
 static uint8_t gcode_buffer[GCODE_BUFFER_SIZE];
 
+#if DISABLED(FASTER_GCODE_PARSER)
+  #error "Binary gcode packs need FASTER_GCODE_PARSER"
+#endif
+static_assert(MAX_CMD_SIZE >= GCODE_BIN_CMD_MAX, "MAX_CMD_SIZE is too small for binary gcode");
+
 void PrintControl::init() {
   print_noise_mode = NOISE_NOIMAL_MODE;
   pnm_param.max_acc = 3000;
@@ -156,6 +163,10 @@ bool PrintControl::get_commands(uint8_t *cmd, uint32_t &line, uint16_t max_len)
     return false;
   }
 
+  if (gcode_format_ == GCODE_FORMAT_BINARY) {
+    return get_bin_commands(cmd, line, max_len);
+  }
+
   while (buffer_head != buffer_tail) {
     if (gcode_buffer[buffer_tail] == ' ' || gcode_buffer[buffer_tail] == '\n') {
       if (gcode_buffer[buffer_tail] == '\n') {
@@ -187,7 +198,112 @@ bool PrintControl::get_commands(uint8_t *cmd, uint32_t &line, uint16_t max_len)
   return false;
 }
 
+bool PrintControl::get_bin_commands(uint8_t *cmd, uint32_t &line, uint16_t max_len) {
+  while (buffer_head != buffer_tail) {
+    if (gcode_buffer[buffer_tail] == GCODE_BIN_OP_SYNC) {
+      // A new pack, its deltas start from zero
+      gcode_bin_reset(bin_ctx_);
+      buffer_tail = (buffer_tail + 1) % GCODE_BUFFER_SIZE;
+      continue;
+    }
+
+    gcode_bin_reader_t reader = {gcode_buffer, GCODE_BUFFER_SIZE, buffer_tail, (uint16_t)get_buf_used()};
+    int16_t len = gcode_bin_decode(reader, bin_ctx_, (char *)cmd, max_len);
+    if (len < 0) {
+      // Packs are checked by push_bin_gcode(), so the buffer itself is broken
+      LOG_E("binary gcode broken at line %d\r\n", power_loss.line_number_sum + 1);
+      buffer_tail = buffer_head;
+      return false;
+    }
+    buffer_tail = reader.pos;
+    power_loss.line_number_sum++;
+    if (len) {
+      line = power_loss.line_number_sum;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Walk the commands not taken yet, G records of binary packs are passed as empty lines
+void PrintControl::scan_buffer(gcode_line_visit_f visit, void *arg) {
+  char cmd[GCODE_BIN_CMD_MAX];
+  uint32_t line = power_loss.line_number_sum;
+  uint16_t head = buffer_head;
+  uint16_t pos = buffer_tail;
+  uint16_t left = (head + GCODE_BUFFER_SIZE - pos) % GCODE_BUFFER_SIZE;
+
+  if (gcode_format_ == GCODE_FORMAT_BINARY) {
+    gcode_bin_reader_t reader = {gcode_buffer, GCODE_BUFFER_SIZE, pos, left};
+    while (reader.left) {
+      if (gcode_buffer[reader.pos] == GCODE_BIN_OP_SYNC) {
+        reader.pos = (reader.pos + 1) % GCODE_BUFFER_SIZE;
+        reader.left--;
+        continue;
+      }
+      int16_t len = gcode_bin_skip(reader, cmd, sizeof(cmd));
+      if (len < 0 || !visit(len ? cmd : "", ++line, arg)) {
+        return;
+      }
+    }
+    return;
+  }
+
+  uint16_t n = 0;
+  for (; left; left--) {
+    char ch = gcode_buffer[pos];
+    pos = (pos + 1) % GCODE_BUFFER_SIZE;
+    if (ch == '\n') {
+      cmd[n] = 0;
+      n = 0;
+      if (!visit(cmd, ++line, arg)) {
+        return;
+      }
+    } else if (n < sizeof(cmd) - 1) {
+      cmd[n++] = ch;
+    }
+  }
+}
+
+ErrCode PrintControl::push_bin_gcode(uint32_t start_line, uint32_t end_line, uint8_t *data, uint16_t size) {
+  uint32_t gcode_count = 0;
+  uint32_t free = get_buf_free();
+
+  // One more byte for the sync mark and one to tell full from empty
+  if (free < (uint32_t)size + 2) {
+    SERIAL_ECHOLNPAIR("gcode no memory ,free:", free, " cur:", size);
+    return E_NO_MEM;
+  }
+
+  if (power_loss.next_req != start_line) {
+    LOG_E("HIM gcode start line is NOT equal req, req %d, get %d\r\n", power_loss.next_req, start_line);
+    return E_PARAM;
+  }
+
+  if (!gcode_bin_check(data, size, gcode_count) || (end_line - start_line + 1) != gcode_count) {
+    SERIAL_ECHOLNPAIR("failed bin line start:", start_line, " end:", end_line, " count:", gcode_count, " next_req:", power_loss.next_req);
+    return E_PARAM;
+  }
+
+  gcode_buffer[buffer_head] = GCODE_BIN_OP_SYNC;
+  buffer_head = (buffer_head + 1) % GCODE_BUFFER_SIZE;
+  uint16_t first = GCODE_BUFFER_SIZE - buffer_head;
+  if (first > size) {
+    first = size;
+  }
+  memcpy(&gcode_buffer[buffer_head], data, first);
+  memcpy(gcode_buffer, data + first, size - first);
+  buffer_head = (buffer_head + size) % GCODE_BUFFER_SIZE;
+  power_loss.next_req = end_line + 1;
+
+  return E_SUCCESS;
+}
+
 ErrCode PrintControl::push_gcode(uint32_t start_line, uint32_t end_line, uint8_t *data, uint16_t size) {
+  if (gcode_format_ == GCODE_FORMAT_BINARY) {
+    return push_bin_gcode(start_line, end_line, data, size);
+  }
+
   uint8_t gcode_count = 0;
   uint32_t free = get_buf_free();
 
@@ -322,6 +438,9 @@ ErrCode PrintControl::start() {
   }
   
   is_hmi_printing = true; // Set for HMI-initiated prints
+  planner.shaped_stats_reset();
+  tool_lookahead.reset();
+  inactive_x.reset();
 
   if (homing_needed()) {
     motion_control.home();
@@ -592,6 +711,9 @@ ErrCode PrintControl::stop() {
     set_feedrate_percentage(100);
     set_print_offset(0, 0, 0);
     stop_work_time();
+    planner.shaped_stats_report();
+    tool_lookahead.report();
+    inactive_x.report();
   }
   // reset to normal
   print_control.set_noise_mode(NOISE_NOIMAL_MODE);
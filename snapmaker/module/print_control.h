@@ -23,6 +23,7 @@
 #define PRINT_CONTROL_H
 #include "../J1/common_type.h"
 #include "src/core/types.h"
+#include "../protocol/gcode_binary.h"
 
 extern bool is_hmi_printing; // Global flag for print source
 
@@ -66,6 +67,9 @@ typedef struct {
   uint32_t err_line;
 } print_err_info_t;
 
+// Visits a command waiting in the gcode buffer with its line number, false stops the scan
+typedef bool (*gcode_line_visit_f)(const char *cmd, uint32_t line, void *arg);
+
 class PrintControl {
   public:
     void init();
@@ -90,6 +94,9 @@ class PrintControl {
     bool is_backup_mode();
     bool filament_check();
     bool get_commands(uint8_t *cmd, uint32_t &line, uint16_t max_len);
+    void scan_buffer(gcode_line_visit_f visit, void *arg);
+    void set_gcode_format(gcode_format_e format) {gcode_format_ = format;}
+    gcode_format_e get_gcode_format() {return gcode_format_;}
     void commands_lock() {commands_lock_ = true;}
     void commands_unlock() {commands_lock_ = false;}
     void loop();
@@ -114,9 +121,13 @@ class PrintControl {
   private:
     void start_work_time();
     void stop_work_time();
+    ErrCode push_bin_gcode(uint32_t start_line, uint32_t end_line, uint8_t *data, uint16_t size);
+    bool get_bin_commands(uint8_t *cmd, uint32_t &line, uint16_t max_len);
 
   public:
     print_mode_e mode_ = PRINT_FULL_MODE;
+    gcode_format_e gcode_format_ = GCODE_FORMAT_TEXT;
+    gcode_bin_ctx_t bin_ctx_;
     bool temperature_lock_status[EXTRUDERS] = {false, false};
     bool commands_lock_ = false;
     print_err_info_t print_err_info = {0};
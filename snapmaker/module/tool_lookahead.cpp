@@ -0,0 +1,274 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "tool_lookahead.h"
+#include "src/gcode/queue.h"
+#include "src/module/motion.h"
+#include "src/module/planner.h"
+#include "src/module/AxisManager.h"
+#include "src/module/tool_change.h"
+#include "../../Marlin/src/module/temperature.h"
+#include "../debug/debug.h"
+#include "motion_control.h"
+#include "print_control.h"
+#include "power_loss.h"
+#include "system.h"
+
+ToolLookahead tool_lookahead;
+
+typedef struct {
+  uint8_t from;
+  int8_t tool;                    // -1 until a change is found
+  uint32_t line;
+  int16_t temp;
+  int16_t set_temp[EXTRUDERS];    // M104/M109 T<n> seen before the change
+  uint8_t after;
+  bool done;
+} change_scan_t;
+
+static inline bool is_digit(char ch) {
+  return ch >= '0' && ch <= '9';
+}
+
+static bool is_code(const char *p, const char *code) {
+  while (*code) {
+    if (*p++ != *code++) {
+      return false;
+    }
+  }
+  return !is_digit(*p);
+}
+
+// Integer part of a parameter, false if the command does not have it
+static bool param_value(const char *p, char letter, int32_t &value) {
+  for (; *p; p++) {
+    if (*p == ' ' && p[1] == letter && (is_digit(p[2]) || p[2] == '-')) {
+      value = atoi(p + 2);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Target of an M104/M109 for its tool, or default_tool without a T
+static bool temperature_command(const char *p, uint8_t default_tool, uint8_t &tool, int16_t &temp) {
+  if (!is_code(p, "M104") && !is_code(p, "M109")) {
+    return false;
+  }
+  int32_t value;
+  if (!param_value(p, 'S', value) && !param_value(p, 'R', value)) {
+    return false;
+  }
+  temp = value;
+  tool = param_value(p, 'T', value) ? value : default_tool;
+  return tool < EXTRUDERS;
+}
+
+static bool change_visit(const char *cmd, uint32_t line, void *arg) {
+  change_scan_t &s = *(change_scan_t *)arg;
+  while (*cmd == ' ') {
+    cmd++;
+  }
+  uint8_t tool;
+  int16_t temp;
+
+  if (s.tool < 0) {
+    if (cmd[0] == 'T' && is_digit(cmd[1])) {
+      tool = atoi(cmd + 1);
+      if (tool < EXTRUDERS && tool != s.from) {
+        s.tool = tool;
+        s.line = line;
+        s.temp = s.set_temp[tool];
+      }
+    } else if (temperature_command(cmd, s.from, tool, temp)) {
+      s.set_temp[tool] = temp;
+    }
+    return true;
+  }
+
+  // A few lines past the change for the temperature the new tool gets
+  if (temperature_command(cmd, s.tool, tool, temp) && tool == s.tool) {
+    if (temp > 0) {
+      s.temp = temp;
+    }
+    s.done = true;
+  } else if (cmd[0] == 'T' || ++s.after >= TOOL_SCAN_AFTER_LINES) {
+    s.done = true;
+  }
+  return !s.done;
+}
+
+bool ToolLookahead::active() {
+  return is_hmi_printing && system_service.get_status() == SYSTEM_STATUE_PRINTING &&
+         dual_x_carriage_mode == DXC_FULL_CONTROL_MODE;
+}
+
+void ToolLookahead::reset() {
+  memset(&dwell, 0, sizeof(dwell));
+  memset(print_temp_, 0, sizeof(print_temp_));
+  ms_per_line_ = 0;
+  rate_line_ = 0;
+  rate_ms_ = 0;
+  heating_ = -1;
+}
+
+void ToolLookahead::report() {
+  LOG_I("tool changes:%u, change dwell:%u ms, heat wait:%u ms, preheats:%u, parks:%u\n",
+        dwell.changes, dwell.change_ms, dwell.heat_wait_ms, dwell.preheats, dwell.parks);
+}
+
+void ToolLookahead::tool_changed(uint8_t old_tool, uint32_t ms) {
+  if (!is_hmi_printing || system_service.get_status() != SYSTEM_STATUE_PRINTING || old_tool == active_extruder) {
+    return;
+  }
+  dwell.changes++;
+  dwell.change_ms += ms;
+  if (early_park_ && active()) {
+    motion_control.park_inactive_x(TOOL_PARK_SPEED, TOOL_PARK_ACCEL);
+    if (axisManager.T0_T1_simultaneously_move) {
+      dwell.parks++;
+    }
+  }
+}
+
+void ToolLookahead::heat_waited(uint32_t ms) {
+  if (is_hmi_printing && system_service.get_status() == SYSTEM_STATUE_PRINTING) {
+    dwell.heat_wait_ms += ms;
+  }
+}
+
+void ToolLookahead::update_rates() {
+  millis_t now = millis();
+  uint32_t line = power_loss.cur_line;
+  if (line != rate_line_) {
+    // A stall such as a heat wait is not part of the line rate
+    if (rate_ms_ && line > rate_line_ && PENDING(now, rate_ms_ + 2000)) {
+      float sample = (float)(now - rate_ms_) / (line - rate_line_);
+      ms_per_line_ = ms_per_line_ ? ms_per_line_ + (sample - ms_per_line_) / 4 : sample;
+    }
+    rate_line_ = line;
+    rate_ms_ = now;
+  } else if (ELAPSED(now, rate_ms_ + 2000)) {
+    rate_ms_ = now;
+  }
+
+  int16_t target = thermalManager.degTargetHotend(active_extruder);
+  if (target >= EXTRUDE_MINTEMP) {
+    print_temp_[active_extruder] = target;
+  }
+
+  if (heating_ >= 0) {
+    if (thermalManager.degTargetHotend(heating_) != heating_to_) {
+      heating_ = -1;
+    } else if (thermalManager.degHotend(heating_) >= heating_to_ - TEMP_HYSTERESIS) {
+      float seconds = (now - heating_ms_) / 1000.0f;
+      float rate = (heating_to_ - heating_from_) / seconds;
+      if (seconds > 2 && rate > 0.2f) {
+        heat_rate_[heating_] = (heat_rate_[heating_] + rate) / 2;
+      }
+      heating_ = -1;
+    }
+  }
+}
+
+bool ToolLookahead::find_next_change(uint8_t &tool, uint32_t &line, int16_t &temp) {
+  change_scan_t s;
+  memset(&s, 0, sizeof(s));
+  s.from = active_extruder;
+  s.tool = -1;
+
+  GCodeQueue::RingBuffer &ring = queue.ring_buffer;
+  uint8_t index = ring.index_r;
+  for (uint8_t i = 0; i < ring.length && !s.done; i++) {
+    GCodeQueue::CommandLine &command = ring.commands[index];
+    change_visit(command.buffer[0] == GCODE_BIN_MARK ? "" : command.buffer, command.lines, &s);
+    index = (index + 1) % BUFSIZE;
+  }
+  if (!s.done) {
+    print_control.scan_buffer(change_visit, &s);
+  }
+
+  if (s.tool < 0) {
+    return false;
+  }
+  tool = s.tool;
+  line = s.line;
+  temp = s.temp ? s.temp : print_temp_[tool];
+  return true;
+}
+
+// Blocks in the planner at their nominal speed, then the lines up to line at the line rate
+uint32_t ToolLookahead::time_to_line(uint32_t line) {
+  float ms = 0;
+  uint32_t last = power_loss.cur_line;
+  for (uint8_t b = planner.block_buffer_tail; b != planner.block_buffer_head; b = BLOCK_MOD(b + 1)) {
+    block_t &block = planner.block_buffer[b];
+    if (block.nominal_speed > 0) {
+      ms += block.millimeters / block.nominal_speed * 1000;
+    }
+    if (block.file_position > last) {
+      last = block.file_position;
+    }
+  }
+  if (line > last) {
+    ms += (line - last) * ms_per_line_;
+  }
+  return ms;
+}
+
+void ToolLookahead::update() {
+  if (!active()) {
+    return;
+  }
+  millis_t now = millis();
+  if (PENDING(now, next_scan_)) {
+    return;
+  }
+  next_scan_ = now + TOOL_SCAN_INTERVAL_MS;
+  update_rates();
+
+  uint8_t tool;
+  uint32_t line;
+  int16_t temp;
+  if (!preheat_ || tool_changeing || !ms_per_line_ || !find_next_change(tool, line, temp)) {
+    return;
+  }
+  if (temp < EXTRUDE_MINTEMP || print_control.temperature_lock(tool) || thermalManager.degTargetHotend(tool) >= temp) {
+    return;
+  }
+
+  float rise = temp - thermalManager.degHotend(tool);
+  uint32_t heat_ms = TOOL_PREHEAT_MARGIN_MS + (rise > 0 ? rise / heat_rate_[tool] * 1000 : 0);
+  uint32_t left = time_to_line(line);
+  if (left > heat_ms) {
+    return;
+  }
+
+  thermalManager.setTargetHotend(temp, tool);
+  dwell.preheats++;
+  heating_ = tool;
+  heating_from_ = thermalManager.degHotend(tool);
+  heating_to_ = temp;
+  heating_ms_ = now;
+  LOG_I("preheat T%d to %d for line %u in %u ms\n", tool, temp, line, left);
+}
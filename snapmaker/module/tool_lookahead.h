@@ -0,0 +1,102 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOOL_LOOKAHEAD_H
+#define TOOL_LOOKAHEAD_H
+
+/*
+ Look-ahead tool change scheduler for HMI prints in full control mode.
+
+ update() runs in the Marlin task each time commands are taken from the
+ HMI buffer. It finds the next T command in the command queue and the HMI
+ buffer and the temperature the new tool prints at: an M104/M109 for it
+ before the T, one right after the T, or the last one it printed with. The
+ time until the T runs is the planned blocks plus the lines in between at
+ the measured line rate. The idle hotend is heated once that time is down
+ to its heat-up time, so it is at temperature when the change runs.
+
+ With early park on, the old head is parked by the async X axis right
+ after a tool change while the new head prints.
+
+ Tool change dwell and heat waits of a print are logged when it stops.
+*/
+
+#include "../J1/common_type.h"
+#include "src/inc/MarlinConfigPre.h"
+#include "src/core/millis_t.h"
+
+// Heat-up rate until one is measured, degree per second
+#define TOOL_PREHEAT_RATE_DEFAULT   2.0f
+// Margin on the heat-up time
+#define TOOL_PREHEAT_MARGIN_MS      5000
+// Lines after a T searched for the temperature of the new tool
+#define TOOL_SCAN_AFTER_LINES       8
+#define TOOL_SCAN_INTERVAL_MS       100
+#define TOOL_PARK_SPEED             200.0f
+#define TOOL_PARK_ACCEL             6000.0f
+
+typedef struct {
+  uint32_t changes;
+  uint32_t change_ms;     // time spent in tool_change()
+  uint32_t heat_wait_ms;  // time spent in M109 waits
+  uint32_t preheats;
+  uint32_t parks;
+} tool_dwell_t;
+
+class ToolLookahead {
+  public:
+    void reset();
+    void report();
+    void update();
+    void tool_changed(uint8_t old_tool, uint32_t ms);
+    void heat_waited(uint32_t ms);
+    void set_preheat(bool enable) { preheat_ = enable; }
+    bool preheat() { return preheat_; }
+    void set_early_park(bool enable) { early_park_ = enable; }
+    bool early_park() { return early_park_; }
+
+    tool_dwell_t dwell;
+
+  private:
+    bool active();
+    void update_rates();
+    bool find_next_change(uint8_t &tool, uint32_t &line, int16_t &temp);
+    uint32_t time_to_line(uint32_t line);
+
+    bool preheat_ = true;
+    bool early_park_ = false;
+    millis_t next_scan_ = 0;
+    // Line rate of the print, ms per line
+    float ms_per_line_ = 0;
+    uint32_t rate_line_ = 0;
+    millis_t rate_ms_ = 0;
+    float heat_rate_[EXTRUDERS] = {TOOL_PREHEAT_RATE_DEFAULT, TOOL_PREHEAT_RATE_DEFAULT};
+    int16_t print_temp_[EXTRUDERS];
+    // Preheat in progress, timed to learn the heat-up rate
+    int8_t heating_ = -1;
+    float heating_from_;
+    int16_t heating_to_;
+    millis_t heating_ms_;
+};
+
+extern ToolLookahead tool_lookahead;
+
+#endif
@@ -0,0 +1,353 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gcode_binary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char gcode_bin_letters[GCODE_BIN_PARAM_COUNT] = {'X', 'Y', 'Z', 'E', 'F', 'I', 'J', 'R'};
+const int32_t gcode_bin_scale[GCODE_BIN_PARAM_COUNT] = {1000, 1000, 1000, 100000, 1000, 1000, 1000, 1000};
+
+// Op code of the G codes sent as binary records, index is op - GCODE_BIN_OP_G0
+static const uint8_t gcode_bin_codenum[] = {0, 1, 2, 3, 92};
+#define GCODE_BIN_OP_LAST (GCODE_BIN_OP_G0 + sizeof(gcode_bin_codenum) - 1)
+
+// Longest varint of a 64 bit value
+#define GCODE_BIN_VARINT_MAX 10
+
+static inline uint8_t reader_get(gcode_bin_reader_t &r) {
+  uint8_t ch = r.buf[r.pos];
+  r.pos = (r.pos + 1 == r.size) ? 0 : r.pos + 1;
+  r.left--;
+  return ch;
+}
+
+static bool reader_varint(gcode_bin_reader_t &r, int64_t &value) {
+  uint64_t v = 0;
+  for (uint8_t shift = 0; shift < 7 * GCODE_BIN_VARINT_MAX; shift += 7) {
+    if (!r.left) {
+      return false;
+    }
+    uint8_t ch = reader_get(r);
+    v |= (uint64_t)(ch & 0x7F) << shift;
+    if (!(ch & 0x80)) {
+      value = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint8_t write_varint(int64_t value, uint8_t *out) {
+  uint64_t v = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  uint8_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)v | 0x80;
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+static inline uint8_t bit_count(uint8_t mask) {
+  uint8_t n = 0;
+  for (; mask; mask &= mask - 1) n++;
+  return n;
+}
+
+// Exact float of fixed / scale, the same value strtof() gives for the text
+static inline float fixed_to_float(int64_t fixed, int32_t scale) {
+  if (fixed > -(1L << 24) && fixed < (1L << 24)) {
+    // Both operands are exact floats, the division rounds once
+    return (float)(int32_t)fixed / (float)scale;
+  }
+  return (float)((double)fixed / scale);
+}
+
+// Parse a plain decimal number into fixed point, false if it is not exact
+static bool parse_fixed(const char *&p, const char *end, int32_t scale, int64_t &fixed) {
+  bool neg = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    neg = *p++ == '-';
+  }
+  int64_t mantissa = 0;
+  uint8_t digits = 0, decimals = 0;
+  bool point = false;
+  for (; p < end && *p != ' '; p++) {
+    if (*p == '.' && !point) {
+      point = true;
+    } else if (*p >= '0' && *p <= '9') {
+      if (++digits > 15) {
+        return false;
+      }
+      mantissa = mantissa * 10 + (*p - '0');
+      decimals += point;
+    } else {
+      return false;
+    }
+  }
+  if (!digits) {
+    return false;
+  }
+  for (; decimals; decimals--) {
+    if (scale % 10) {
+      return false;
+    }
+    scale /= 10;
+  }
+  fixed = mantissa * scale;
+  if (neg) {
+    // -0 would come back as +0
+    if (!fixed) {
+      return false;
+    }
+    fixed = -fixed;
+  }
+  return true;
+}
+
+static int16_t encode_text(const char *line, uint16_t len, uint8_t *out, uint16_t max) {
+  if (len + 2 > max) {
+    return -1;
+  }
+  out[0] = GCODE_BIN_OP_TEXT;
+  out[1] = (uint8_t)len;
+  memcpy(&out[2], line, len);
+  return len + 2;
+}
+
+int16_t gcode_bin_encode(const char *line, uint16_t len, uint8_t *out, uint16_t max, gcode_bin_ctx_t &ctx) {
+  while (len && (line[len - 1] == ' ' || line[len - 1] == '\r' || line[len - 1] == '\n')) {
+    len--;
+  }
+  if (len >= GCODE_BIN_CMD_MAX || (len && line[0] == GCODE_BIN_MARK) || memchr(line, '\0', len) || memchr(line, '\n', len)) {
+    return -1;
+  }
+
+  const char *p = line, *end = line + len;
+  uint8_t op = 0;
+  if (len >= 2 && p[0] == 'G') {
+    uint16_t codenum = 0;
+    for (p++; p < end && *p >= '0' && *p <= '9' && codenum < 1000; p++) {
+      codenum = codenum * 10 + (*p - '0');
+    }
+    if (p > line + 1 && (p == end || *p == ' ')) {
+      for (uint8_t i = 0; i < sizeof(gcode_bin_codenum); i++) {
+        if (gcode_bin_codenum[i] == codenum) {
+          op = GCODE_BIN_OP_G0 + i;
+        }
+      }
+    }
+  }
+  if (!op) {
+    return encode_text(line, len, out, max);
+  }
+
+  int64_t value[GCODE_BIN_PARAM_COUNT];
+  uint8_t mask = 0;
+  while (p < end) {
+    if (*p == ' ') {
+      p++;
+      continue;
+    }
+    const char *letter = (const char *)memchr(gcode_bin_letters, *p, GCODE_BIN_PARAM_COUNT);
+    if (!letter) {
+      return encode_text(line, len, out, max);
+    }
+    uint8_t i = letter - gcode_bin_letters;
+    const char *number = ++p;
+    if ((mask & (1 << i)) || !parse_fixed(p, end, gcode_bin_scale[i], value[i])) {
+      return encode_text(line, len, out, max);
+    }
+    // value_long() truncates the float, it must give the integer part of the text
+    float f = fixed_to_float(value[i], gcode_bin_scale[i]);
+    int64_t whole = value[i] / gcode_bin_scale[i];
+    if (whole <= -(1L << 24) || whole >= (1L << 24) || (int32_t)f != whole) {
+      return encode_text(line, len, out, max);
+    }
+    // Past 2^24 the decoder rounds twice, keep the value only if it still matches
+    if (value[i] <= -(1L << 24) || value[i] >= (1L << 24)) {
+      char text[24];
+      memcpy(text, number, p - number);
+      text[p - number] = 0;
+      float t = strtof(text, nullptr);
+      if (memcmp(&f, &t, sizeof(f))) {
+        return encode_text(line, len, out, max);
+      }
+    }
+    mask |= 1 << i;
+  }
+
+  uint8_t record[2 + GCODE_BIN_PARAM_COUNT * GCODE_BIN_VARINT_MAX];
+  uint16_t n = 0;
+  record[n++] = op;
+  record[n++] = mask;
+  for (uint8_t i = 0; i < GCODE_BIN_PARAM_COUNT; i++) {
+    if (mask & (1 << i)) {
+      n += write_varint(value[i] - ctx.last[i], &record[n]);
+    }
+  }
+  // Text is the smaller one for short lines with long numbers
+  if (n > len + 2) {
+    return encode_text(line, len, out, max);
+  }
+  if (n > max) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < GCODE_BIN_PARAM_COUNT; i++) {
+    if (mask & (1 << i)) {
+      ctx.last[i] = value[i];
+    }
+  }
+  memcpy(out, record, n);
+  return n;
+}
+
+bool gcode_bin_check(const uint8_t *data, uint16_t size, uint32_t &lines) {
+  gcode_bin_reader_t r = {data, size, 0, size};
+  lines = 0;
+  while (r.left) {
+    uint8_t op = reader_get(r);
+    if (op == GCODE_BIN_OP_TEXT) {
+      if (!r.left) {
+        return false;
+      }
+      uint8_t len = reader_get(r);
+      if (len >= GCODE_BIN_CMD_MAX || len > r.left || (len && r.buf[r.pos] == GCODE_BIN_MARK)) {
+        return false;
+      }
+      // A text line is one nul terminated command
+      if (memchr(&r.buf[r.pos], '\0', len) || memchr(&r.buf[r.pos], '\n', len)) {
+        return false;
+      }
+      r.pos += len;
+      r.left -= len;
+    } else if (op >= GCODE_BIN_OP_G0 && op <= GCODE_BIN_OP_LAST) {
+      if (!r.left) {
+        return false;
+      }
+      int64_t v;
+      for (uint8_t count = bit_count(reader_get(r)); count; count--) {
+        if (!reader_varint(r, v)) {
+          return false;
+        }
+      }
+    } else {
+      return false;
+    }
+    lines++;
+  }
+  return true;
+}
+
+int16_t gcode_bin_decode(gcode_bin_reader_t &r, gcode_bin_ctx_t &ctx, char *cmd, uint16_t max) {
+  if (!r.left) {
+    return -1;
+  }
+  uint8_t op = reader_get(r);
+  if (op == GCODE_BIN_OP_TEXT) {
+    if (!r.left) {
+      return -1;
+    }
+    uint8_t len = reader_get(r);
+    if (len > r.left || len >= max) {
+      return -1;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      cmd[i] = reader_get(r);
+    }
+    cmd[len] = 0;
+    return len;
+  }
+
+  if (op < GCODE_BIN_OP_G0 || op > GCODE_BIN_OP_LAST || !r.left) {
+    return -1;
+  }
+  uint8_t mask = reader_get(r);
+  uint16_t n = GCODE_BIN_HEAD_SIZE;
+  if (n + bit_count(mask) * GCODE_BIN_VALUE_SIZE > max) {
+    return -1;
+  }
+  uint8_t codenum = gcode_bin_codenum[op - GCODE_BIN_OP_G0];
+  cmd[0] = GCODE_BIN_MARK;
+  cmd[1] = 'G';
+  cmd[2] = codenum;
+  cmd[3] = 0;
+  cmd[4] = bit_count(mask);
+  for (uint8_t i = 0; i < GCODE_BIN_PARAM_COUNT; i++) {
+    if (mask & (1 << i)) {
+      int64_t delta;
+      if (!reader_varint(r, delta)) {
+        return -1;
+      }
+      ctx.last[i] += delta;
+      float value = fixed_to_float(ctx.last[i], gcode_bin_scale[i]);
+      cmd[n] = gcode_bin_letters[i];
+      memcpy(&cmd[n + 1], &value, sizeof(value));
+      n += GCODE_BIN_VALUE_SIZE;
+    }
+  }
+  return n;
+}
+
+int16_t gcode_bin_skip(gcode_bin_reader_t &r, char *text, uint16_t max) {
+  if (!r.left) {
+    return -1;
+  }
+  uint8_t op = reader_get(r);
+  if (op == GCODE_BIN_OP_TEXT) {
+    if (!r.left) {
+      return -1;
+    }
+    uint8_t len = reader_get(r);
+    if (len > r.left || len >= max) {
+      return -1;
+    }
+    for (uint8_t i = 0; i < len; i++) {
+      text[i] = reader_get(r);
+    }
+    text[len] = 0;
+    return len;
+  }
+
+  if (op < GCODE_BIN_OP_G0 || op > GCODE_BIN_OP_LAST || !r.left) {
+    return -1;
+  }
+  int64_t v;
+  for (uint8_t count = bit_count(reader_get(r)); count; count--) {
+    if (!reader_varint(r, v)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+uint16_t gcode_bin_to_text(const char *cmd, char *text, uint16_t max) {
+  int n = snprintf(text, max, "%c%u", cmd[1], (uint8_t)cmd[2] | (uint8_t)cmd[3] << 8);
+  const char *v = cmd + GCODE_BIN_HEAD_SIZE;
+  for (uint8_t count = cmd[4]; count && n > 0 && n < max; count--, v += GCODE_BIN_VALUE_SIZE) {
+    float value;
+    memcpy(&value, v + 1, sizeof(value));
+    n += snprintf(text + n, max - n, " %c%.9g", v[0], (double)value);
+  }
+  return n < 0 ? 0 : (n < max ? n : max - 1);
+}
@@ -0,0 +1,103 @@
+/*
+ * Snapmaker 3D Printer Firmware
+ * Copyright (C) 2023 Snapmaker [https://github.com/Snapmaker]
+ *
+ * This file is part of SnapmakerController-IDEX
+ * (see https://github.com/Snapmaker/SnapmakerController-IDEX)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GCODE_BINARY_H
+#define GCODE_BINARY_H
+
+/*
+ Binary G-code transport, negotiated at PRINTER_ID_START_WORK.
+
+ The data of a G-code pack is a run of records, one per G-code line:
+
+   GCODE_BIN_OP_TEXT  len, len bytes of text without the newline
+   GCODE_BIN_OP_G0..  mask, one varint per bit set in mask
+
+ Bit i of mask stands for the parameter letter gcode_bin_letters[i]. The
+ varint is the zigzag LEB128 difference of the value, in fixed point of
+ gcode_bin_scale[i], to the previous value of that letter. Each pack starts
+ from zero so a resent range decodes the same. A value that is not exact in
+ fixed point sends the whole line as text.
+
+ The firmware decodes a record into a pre-parsed command that
+ GCodeParser::parse() takes without tokenising:
+
+   GCODE_BIN_MARK, letter, codenum (LE16), count, count * { letter, float }
+
+ Kept free of Marlin headers so the host tests build it as is.
+*/
+
+#include <stdint.h>
+
+typedef enum : uint8_t {
+  GCODE_FORMAT_TEXT,
+  GCODE_FORMAT_BINARY,
+} gcode_format_e;
+
+enum : uint8_t {
+  GCODE_BIN_OP_TEXT = 0x00,
+  GCODE_BIN_OP_G0   = 0x01,
+  GCODE_BIN_OP_G1   = 0x02,
+  GCODE_BIN_OP_G2   = 0x03,
+  GCODE_BIN_OP_G3   = 0x04,
+  GCODE_BIN_OP_G92  = 0x05,
+  GCODE_BIN_OP_SYNC = 0xFF,  // Local only, marks a pack start in the firmware buffer
+};
+
+#define GCODE_BIN_PARAM_COUNT 8
+// First byte of a pre-parsed command, never the start of a text line
+#define GCODE_BIN_MARK        0x01
+#define GCODE_BIN_HEAD_SIZE   5
+#define GCODE_BIN_VALUE_SIZE  5
+// Largest command, text or pre-parsed, including the terminating nul
+#define GCODE_BIN_CMD_MAX     96
+
+extern const char gcode_bin_letters[GCODE_BIN_PARAM_COUNT];
+extern const int32_t gcode_bin_scale[GCODE_BIN_PARAM_COUNT];
+
+typedef struct {
+  int64_t last[GCODE_BIN_PARAM_COUNT];
+} gcode_bin_ctx_t;
+
+// Reads a linear buffer or a ring of size bytes from pos, left bytes are valid
+typedef struct {
+  const uint8_t *buf;
+  uint16_t size;
+  uint16_t pos;
+  uint16_t left;
+} gcode_bin_reader_t;
+
+inline void gcode_bin_reset(gcode_bin_ctx_t &ctx) {
+  for (auto &v : ctx.last) v = 0;
+}
+
+// Encode one line, returns the record size or -1 if it does not fit in max
+int16_t gcode_bin_encode(const char *line, uint16_t len, uint8_t *out, uint16_t max, gcode_bin_ctx_t &ctx);
+// Check a pack and count its lines, false if a record is broken or too long
+bool gcode_bin_check(const uint8_t *data, uint16_t size, uint32_t &lines);
+// Decode the next record into cmd, returns the command length, 0 for an empty line or -1 if broken
+int16_t gcode_bin_decode(gcode_bin_reader_t &r, gcode_bin_ctx_t &ctx, char *cmd, uint16_t max);
+// Step over the next record without decoding it, a text record is copied into text.
+// Returns the text length, 0 for a G record or -1 if broken
+int16_t gcode_bin_skip(gcode_bin_reader_t &r, char *text, uint16_t max);
+// Write a pre-parsed command back as text, for echo and tests
+uint16_t gcode_bin_to_text(const char *cmd, char *text, uint16_t max);
+
+#endif
@@ -21,96 +21,156 @@
 
 #include "protocol_sacp.h"
 #include <functional>
+#include <string.h>
 #include "HAL.h"
 #include "../../Marlin/src/core/serial.h"
 
 ProtocolSACP protocol_sacp;
 
-static uint8_t sacp_calc_crc8(uint8_t *buffer, uint16_t len) {
-  int crc = 0x00;
-  int poly = 0x07;
-  for (int i = 0; i < len; i++) {
-    for (int j = 0; j < 8; j++) {
-      bool bit = ((buffer[i] >> (7 - j) & 1) == 1);
-      bool c07 = ((crc >> 7 & 1) == 1);
-      crc <<= 1;
-      if (c07 ^ bit) {
-        crc ^= poly;
-      }
-    }
+// CRC-8 of every byte value, polynomial 0x07, MSB first
+static const uint8_t sacp_crc8_table[256] = {
+  0x00, 0x07, 0x0e, 0x09, 0x1c, 0x1b, 0x12, 0x15, 0x38, 0x3f, 0x36, 0x31, 0x24, 0x23, 0x2a, 0x2d,
+  0x70, 0x77, 0x7e, 0x79, 0x6c, 0x6b, 0x62, 0x65, 0x48, 0x4f, 0x46, 0x41, 0x54, 0x53, 0x5a, 0x5d,
+  0xe0, 0xe7, 0xee, 0xe9, 0xfc, 0xfb, 0xf2, 0xf5, 0xd8, 0xdf, 0xd6, 0xd1, 0xc4, 0xc3, 0xca, 0xcd,
+  0x90, 0x97, 0x9e, 0x99, 0x8c, 0x8b, 0x82, 0x85, 0xa8, 0xaf, 0xa6, 0xa1, 0xb4, 0xb3, 0xba, 0xbd,
+  0xc7, 0xc0, 0xc9, 0xce, 0xdb, 0xdc, 0xd5, 0xd2, 0xff, 0xf8, 0xf1, 0xf6, 0xe3, 0xe4, 0xed, 0xea,
+  0xb7, 0xb0, 0xb9, 0xbe, 0xab, 0xac, 0xa5, 0xa2, 0x8f, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9d, 0x9a,
+  0x27, 0x20, 0x29, 0x2e, 0x3b, 0x3c, 0x35, 0x32, 0x1f, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0d, 0x0a,
+  0x57, 0x50, 0x59, 0x5e, 0x4b, 0x4c, 0x45, 0x42, 0x6f, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7d, 0x7a,
+  0x89, 0x8e, 0x87, 0x80, 0x95, 0x92, 0x9b, 0x9c, 0xb1, 0xb6, 0xbf, 0xb8, 0xad, 0xaa, 0xa3, 0xa4,
+  0xf9, 0xfe, 0xf7, 0xf0, 0xe5, 0xe2, 0xeb, 0xec, 0xc1, 0xc6, 0xcf, 0xc8, 0xdd, 0xda, 0xd3, 0xd4,
+  0x69, 0x6e, 0x67, 0x60, 0x75, 0x72, 0x7b, 0x7c, 0x51, 0x56, 0x5f, 0x58, 0x4d, 0x4a, 0x43, 0x44,
+  0x19, 0x1e, 0x17, 0x10, 0x05, 0x02, 0x0b, 0x0c, 0x21, 0x26, 0x2f, 0x28, 0x3d, 0x3a, 0x33, 0x34,
+  0x4e, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5c, 0x5b, 0x76, 0x71, 0x78, 0x7f, 0x6a, 0x6d, 0x64, 0x63,
+  0x3e, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2c, 0x2b, 0x06, 0x01, 0x08, 0x0f, 0x1a, 0x1d, 0x14, 0x13,
+  0xae, 0xa9, 0xa0, 0xa7, 0xb2, 0xb5, 0xbc, 0xbb, 0x96, 0x91, 0x98, 0x9f, 0x8a, 0x8d, 0x84, 0x83,
+  0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3,
+};
+
+uint8_t sacp_calc_crc8(uint8_t *buffer, uint16_t len) {
+  uint8_t crc = 0x00;
+  for (uint16_t i = 0; i < len; i++) {
+    crc = sacp_crc8_table[crc ^ buffer[i]];
   }
-  crc &= 0xff;
   return crc;
 }
 
-uint16_t calc_checksum(uint8_t *buffer, uint16_t length) {
-  uint32_t volatile checksum = 0;
+/*
+ One's complement sum of big endian 16 bit words, an odd last byte is added
+ as is. The sum does not depend on byte order, so the words are summed as
+ they load on this little endian core, 32 bits at a time, and the result is
+ swapped back.
+*/
+uint16_t sacp_calc_checksum(uint8_t *buffer, uint16_t length) {
+  uint32_t checksum = 0;
 
   if (!length || !buffer)
     return 0;
 
-  for (int j = 0; j < (length - 1); j = j + 2)
-    checksum += (uint32_t)(buffer[j] << 8 | buffer[j + 1]);
+  uint16_t i = 0;
+  for (; i + 4 <= length; i += 4) {
+    uint32_t word;
+    memcpy(&word, &buffer[i], 4);
+    checksum += (word & 0xffff) + (word >> 16);
+  }
+
+  if (i + 2 <= length) {
+    uint16_t half;
+    memcpy(&half, &buffer[i], 2);
+    checksum += half;
+    i += 2;
+  }
 
-  if (length % 2)
-    checksum += buffer[length - 1];
+  if (i < length)
+    checksum += buffer[i] << 8;
 
   while (checksum > 0xffff)
-    checksum = ((checksum >> 16) & 0xffff) + (checksum & 0xffff);
+    checksum = (checksum >> 16) + (checksum & 0xffff);
+
+  checksum = ((checksum & 0xff) << 8) | (checksum >> 8);
+
+  return (uint16_t)~checksum;
+}
 
-  checksum = ~checksum;
+// Length of the whole packet, sof to checksum
+static inline uint16_t sacp_total_len(uint8_t *head) {
+  return (head[3] << 8 | head[2]) + 7;
+}
+
+static bool sacp_head_valid(uint8_t *head) {
+  uint16_t data_len = head[3] << 8 | head[2];
+  return sacp_calc_crc8(head, 6) == head[6] && data_len >= 8 && data_len + 7 <= PACK_PARSE_MAX_SIZE;
+}
 
-  return (uint16_t)checksum;
+static ErrCode sacp_check(uint8_t *packet) {
+  uint16_t data_len = packet[3] << 8 | packet[2];
+  uint16_t total_len = data_len + 7;
+  uint16_t checksum = sacp_calc_checksum(&packet[7], data_len - 2);
+  uint16_t checksum1 = (packet[total_len - 1] << 8) | packet[total_len - 2];
+  return checksum == checksum1 ? E_SUCCESS : E_PARAM;
 }
 
-ErrCode ProtocolSACP::parse(uint8_t *data, uint16_t len, SACP_param_t &out) {
+ErrCode ProtocolSACP::parse(uint8_t *data, uint16_t len, SACP_param_t &out, uint16_t &used, SACP_struct_t *&packet) {
   uint8_t *parse_buff = out.buff;
-  if (parse_buff[0] != SACP_PDU_SOF_H) {
-    out.lenght = 0;
-  }
-  for (uint16_t i = 0; i < len; i++) {
-    uint8_t ch = data[i];
+  uint16_t i = 0;
+  while (i < len) {
     if (out.lenght == 0) {
-      if (ch == SACP_PDU_SOF_H) {
-        parse_buff[out.lenght++] = ch;
+      uint8_t *sof = (uint8_t *)memchr(data + i, SACP_PDU_SOF_H, len - i);
+      if (!sof) {
+        break;
+      }
+      i = sof - data;
+      uint16_t left = len - i;
+      if (left >= 2 && sof[1] != SACP_PDU_SOF_L) {
+        i++;
+        continue;
+      }
+      if (left >= 7) {
+        if (!sacp_head_valid(sof)) {
+          i++;
+          continue;
+        }
+        uint16_t total_len = sacp_total_len(sof);
+        if (total_len <= left) {
+          // Whole packet in this run, check it where it lies
+          used = i + total_len;
+          packet = (SACP_struct_t *)sof;
+          return sacp_check(sof);
+        }
+      }
+      // The packet goes on in the next run, gather it
+      memcpy(parse_buff, sof, left);
+      out.lenght = left;
+      i = len;
+    } else if (out.lenght < 7) {
+      uint16_t n = len - i;
+      if (n > 7 - out.lenght) {
+        n = 7 - out.lenght;
       }
-    } else if (out.lenght == 1) {
-      if (ch == SACP_PDU_SOF_L) {
-        parse_buff[out.lenght++] = ch;
-      } else {
+      memcpy(&parse_buff[out.lenght], &data[i], n);
+      out.lenght += n;
+      i += n;
+      if (out.lenght == 7 && (parse_buff[1] != SACP_PDU_SOF_L || !sacp_head_valid(parse_buff))) {
         out.lenght = 0;
       }
     } else {
-      parse_buff[out.lenght++] = ch;
-    }
-
-    if (out.lenght < 7) {
-      break;
-    }
-    else if (out.lenght == 7) {
-      if (sacp_calc_crc8(parse_buff, 6) != parse_buff[6]) {
-        out.lenght = 0;
+      uint16_t total_len = sacp_total_len(parse_buff);
+      uint16_t n = len - i;
+      if (n > total_len - out.lenght) {
+        n = total_len - out.lenght;
       }
-    }
-    else {
-      uint16_t data_len = (parse_buff[3] << 8 | parse_buff[2]);
-      uint16_t total_len = data_len + 7;
+      memcpy(&parse_buff[out.lenght], &data[i], n);
+      out.lenght += n;
+      i += n;
       if (out.lenght == total_len) {
-        uint16_t checksum = calc_checksum(&parse_buff[7], data_len - 2);
-        uint16_t checksum1 = (parse_buff[total_len - 1] << 8) | parse_buff[total_len - 2];
-        if (checksum == checksum1) {
-          out.lenght = 0;
-          return E_SUCCESS;
-        } else {
-          out.lenght = 0;
-          return E_PARAM;
-        }
-      } else if (out.lenght > total_len) {
         out.lenght = 0;
-        return E_PARAM;
+        used = i;
+        packet = &out.sacp;
+        return sacp_check(parse_buff);
       }
     }
   }
+  used = len;
   return E_IN_PROGRESS;
 }
 
@@ -129,10 +189,8 @@ uint16_t ProtocolSACP::package(SACP_head_base_t head, uint8_t *in_data, uint16_t
   out->sequence = head.sequence;
   out->command_set = head.command_set;
   out->command_id = head.command_id;
-  for (uint16_t i = 0; i < length; i++) {
-    out->data[i] = in_data[i];
-  }
-  uint16_t checksum = calc_checksum(&out_data[7], data_len - 2);  // - checknum 2 byte
+  memcpy(out->data, in_data, length);
+  uint16_t checksum = sacp_calc_checksum(&out_data[7], data_len - 2);  // - checknum 2 byte
   length = sizeof(SACP_struct_t) + length;
   out_data[length++] = (uint8_t)(checksum & 0x00FF);
   out_data[length++] = (uint8_t)(checksum>>8);
@@ -76,9 +76,20 @@ typedef struct {
 
 #pragma pack()
 
+// Header CRC and payload checksum, shared by package() and parse()
+uint8_t sacp_calc_crc8(uint8_t *buffer, uint16_t len);
+uint16_t sacp_calc_checksum(uint8_t *buffer, uint16_t length);
+
 class ProtocolSACP {
   public:
-    ErrCode parse(uint8_t *data, uint16_t len, SACP_param_t &out);
+    /*
+     Frame packets out of a run of received bytes, stops after the first whole
+     packet and returns in used how many bytes were taken. A packet that lies
+     whole in data is checked in place and packet points into data, a packet
+     split across runs is gathered in out and packet points there.
+     E_SUCCESS: packet is valid, E_PARAM: bad checksum, E_IN_PROGRESS: no packet
+    */
+    ErrCode parse(uint8_t *data, uint16_t len, SACP_param_t &out, uint16_t &used, SACP_struct_t *&packet);
     // Package the incoming data
     uint16_t package(SACP_head_base_t head, uint8_t *in_data, uint16_t length, uint8_t *out_data);
     uint16_t sequence_pop() {return sequence++;}
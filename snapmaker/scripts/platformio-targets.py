@@ -89,3 +89,16 @@ env.AddCustomTarget(
   title="Pack",
   description="Pack major Firmware"
 )
+
+# Static RAM per buffer, from the map the link writes with -Wl,-Map,output.map
+ram_audit_script = join(project_dir, 'snapmaker', 'scripts', 'ram_audit.py')
+
+env.AddCustomTarget(
+  name="ram_audit",
+  dependencies=join("$BUILD_DIR", "${PROGNAME}.elf"),
+  actions=[
+    "python {} {}".format(ram_audit_script, join(project_dir, "output.map"))
+  ],
+  title="RAM audit",
+  description="Static RAM footprint of every buffer"
+)
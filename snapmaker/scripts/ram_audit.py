@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# Static RAM footprint of the firmware from the GNU ld link map.
+#
+# Every input section placed in .data, .bss and COMMON is listed with its
+# size and the object it comes from, the largest first, followed by the
+# totals per object and per output section against the RAM region. With
+# -fdata-sections each static buffer is its own input section, so this is
+# the size of every buffer the firmware keeps in SRAM.
+#
+# The GD32F105 env links with -Wl,-Map,output.map, `pio run -t ram_audit`
+# runs this on it after the build.
+#
+# usage: ram_audit.py [-n 40] [-m 64] output.map
+#
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+RAM_SECTIONS = ('.data', '.bss', 'COMMON')
+
+# " .bss._ZN7Planner12block_bufferE" optionally followed on the same line by
+# "0x20001234 0x1580 path/planner.cpp.o"
+INPUT_RE = re.compile(r'^ (\S+)(?:\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+))?$')
+PLACEMENT_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.+)$')
+OUTPUT_RE = re.compile(r'^(\.\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)')
+SYMBOL_RE = re.compile(r'^\s+(0x[0-9a-fA-F]+)\s+([A-Za-z_][^\s=]*)\s*$')
+REGION_RE = re.compile(r'^(\S+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)')
+
+
+def demangle(names):
+    try:
+        out = subprocess.run(['c++filt'], input='\n'.join(names), stdout=subprocess.PIPE,
+                             universal_newlines=True, check=True).stdout.split('\n')
+        return dict(zip(names, out))
+    except (OSError, subprocess.CalledProcessError):
+        return {n: n for n in names}
+
+
+def parse(path):
+    regions = {}
+    sections = {}
+    buffers = []
+    output = None
+    pending = None
+    in_regions = False
+    in_map = False
+
+    with open(path, 'r', errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if line.startswith('Memory Configuration'):
+                in_regions = True
+                continue
+            if line.startswith('Linker script and memory map'):
+                in_regions = False
+                in_map = True
+                continue
+            if in_regions:
+                m = REGION_RE.match(line)
+                if m and m.group(1) != 'Name':
+                    regions[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16))
+                continue
+            if not in_map:
+                continue
+
+            m = OUTPUT_RE.match(line)
+            if m:
+                output = m.group(1)
+                sections[output] = (int(m.group(2), 16), int(m.group(3), 16))
+                pending = None
+                continue
+            if line and not line[0].isspace():
+                # Output section whose address is on the next line, or a new block
+                output = line.split()[0]
+                pending = None
+                continue
+
+            if pending:
+                # Address, size and object of a long section name on the line after it
+                m = PLACEMENT_RE.match(line)
+                if m:
+                    add_buffer(buffers, output, pending, m.group(1), m.group(2), m.group(3))
+                pending = None
+                continue
+
+            m = SYMBOL_RE.match(line)
+            if m and buffers and buffers[-1]['addr'] == int(m.group(1), 16) and not buffers[-1]['symbol']:
+                buffers[-1]['symbol'] = m.group(2)
+                continue
+
+            m = INPUT_RE.match(line)
+            if m and output in ('.data', '.bss'):
+                name = m.group(1)
+                if not name.startswith(RAM_SECTIONS):
+                    continue
+                if m.group(2):
+                    add_buffer(buffers, output, name, m.group(2), m.group(3), m.group(4))
+                else:
+                    pending = name
+    return regions, sections, buffers
+
+
+def add_buffer(buffers, output, name, addr, size, obj):
+    size = int(size, 16)
+    if not size or obj.startswith('load address'):
+        return
+    for prefix in RAM_SECTIONS:
+        if name.startswith(prefix + '.'):
+            name = name[len(prefix) + 1:]
+            break
+    buffers.append({'output': output, 'name': name, 'addr': int(addr, 16), 'size': size,
+                    'object': os.path.basename(obj.strip()), 'symbol': None})
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Static RAM footprint from a GNU ld map file')
+    parser.add_argument('map', help='link map, e.g. output.map')
+    parser.add_argument('-n', '--top', type=int, default=40, help='buffers listed, 0 for all')
+    parser.add_argument('-m', '--min', type=int, default=64, help='smallest buffer listed in bytes')
+    args = parser.parse_args()
+
+    regions, sections, buffers = parse(args.map)
+    if not buffers:
+        print('no .data/.bss input sections in {}'.format(args.map))
+        return 1
+
+    names = sorted({b['symbol'] or b['name'] for b in buffers})
+    readable = demangle(names)
+    buffers.sort(key=lambda b: b['size'], reverse=True)
+
+    listed = [b for b in buffers if b['size'] >= args.min]
+    if args.top:
+        listed = listed[:args.top]
+    print('{:>8}  {:<6} {:<48} {}'.format('bytes', 'sect', 'buffer', 'object'))
+    for b in listed:
+        name = readable.get(b['symbol'] or b['name'], b['name'])
+        print('{:>8}  {:<6} {:<48} {}'.format(b['size'], b['output'][:6], name[:48], b['object']))
+
+    per_object = {}
+    for b in buffers:
+        per_object[b['object']] = per_object.get(b['object'], 0) + b['size']
+    print('\nper object:')
+    for obj, size in sorted(per_object.items(), key=lambda kv: kv[1], reverse=True)[:args.top or None]:
+        print('{:>8}  {}'.format(size, obj))
+
+    total = sum(b['size'] for b in buffers)
+    print('\n{:>8}  in {} buffers'.format(total, len(buffers)))
+    for name in ('.data', '.bss'):
+        if name in sections:
+            print('{:>8}  {}'.format(sections[name][1], name))
+    ram = regions.get('ram', regions.get('RAM'))
+    if ram:
+        used = sum(size for addr, size in sections.values() if ram[0] <= addr < ram[0] + ram[1])
+        print('{:>8}  of {} bytes RAM, {} left for heap and stack'.format(used, ram[1], ram[1] - used))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# Stand in for the HMI and stream a G-code file to the controller over SACP.
+#
+# The controller is driven through its PC port: `M2000 S5` switches the port
+# to SACP, then a print is started and every PRINTER_ID_REQ_GCODE (stop-and-wait)
+# or PRINTER_ID_REQ_GCODE_RANGE (sliding window) request is answered from the
+# file. At the end the sustained lines/second seen by the host is printed, the
+# controller logs its own figure as "gcode stream: ...".
+#
+# usage: sacp_gcode_loopback.py -p /dev/ttyACM0 -w 3 test.gcode
+#
+
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+SOF_H = 0xAA
+SOF_L = 0x55
+SACP_VERSION = 0x01
+SACP_ID_PC = 0
+SACP_ID_CONTROLLER = 1
+SACP_ATTR_REQ = 0
+SACP_ATTR_ACK = 1
+
+COMMAND_SET_PRINTER = 0xAC
+PRINTER_ID_REPORT_STATUS = 0x01
+PRINTER_ID_REQ_GCODE = 0x02
+PRINTER_ID_START_WORK = 0x03
+PRINTER_ID_SET_GCODE_WINDOW = 0x1e
+PRINTER_ID_REQ_GCODE_RANGE = 0x1f
+
+PRINT_RESULT_GCODE_RECV_DONE_E = 201
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def checksum(data):
+    s = 0
+    for i in range(0, len(data) - 1, 2):
+        s += (data[i] << 8) | data[i + 1]
+    if len(data) % 2:
+        s += data[-1]
+    while s > 0xFFFF:
+        s = (s >> 16) + (s & 0xFFFF)
+    return ~s & 0xFFFF
+
+
+def package(attr, sequence, cmd_set, cmd_id, payload):
+    head = struct.pack('<BBHBB', SOF_H, SOF_L, len(payload) + 8, SACP_VERSION, SACP_ID_CONTROLLER)
+    body = struct.pack('<BBHBB', SACP_ID_PC, attr, sequence, cmd_set, cmd_id) + payload
+    return head + bytes([crc8(head)]) + body + struct.pack('<H', checksum(body))
+
+
+class SacpReader:
+    def __init__(self, port):
+        self.port = port
+        self.buf = bytearray()
+
+    def frames(self):
+        self.buf += self.port.read(self.port.in_waiting or 1)
+        while True:
+            start = self.buf.find(bytes([SOF_H, SOF_L]))
+            if start < 0:
+                del self.buf[:-1]
+                return
+            del self.buf[:start]
+            if len(self.buf) < 7:
+                return
+            if crc8(self.buf[:6]) != self.buf[6]:
+                del self.buf[:1]
+                continue
+            length = self.buf[2] | (self.buf[3] << 8)
+            if len(self.buf) < length + 7:
+                return
+            frame = bytes(self.buf[:length + 7])
+            del self.buf[:length + 7]
+            if checksum(frame[7:-2]) != struct.unpack('<H', frame[-2:])[0]:
+                continue
+            _, attr, seq, cmd_set, cmd_id = struct.unpack('<BBHBB', frame[7:13])
+            yield attr, seq, cmd_set, cmd_id, frame[13:-2]
+
+
+def load_lines(path):
+    lines = []
+    with open(path, 'r', errors='ignore') as f:
+        for line in f:
+            line = line.split(';', 1)[0].strip()
+            if line:
+                lines.append(line.encode() + b'\n')
+    return lines
+
+
+def gcode_pack(lines, start, count, max_size):
+    data = b''
+    end = start
+    while end < len(lines) and end - start < count and len(data) + len(lines[end]) <= max_size:
+        data += lines[end]
+        end += 1
+    flag = PRINT_RESULT_GCODE_RECV_DONE_E if start >= len(lines) else 0
+    return struct.pack('<BIIH', flag, start, (end - 1) & 0xFFFFFFFF, len(data)) + data, end - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description='SACP G-code streaming loopback')
+    parser.add_argument('-p', '--port', required=True)
+    parser.add_argument('-b', '--baud', type=int, default=115200)
+    parser.add_argument('-w', '--window', type=int, default=1, help='1 keeps stop-and-wait')
+    parser.add_argument('gcode')
+    args = parser.parse_args()
+
+    lines = load_lines(args.gcode)
+    port = serial.Serial(args.port, args.baud, timeout=0.01)
+    reader = SacpReader(port)
+    seq = 1
+
+    port.write(b'M2000 S5\n')
+    time.sleep(0.5)
+    port.reset_input_buffer()
+
+    port.write(package(SACP_ATTR_REQ, seq, COMMAND_SET_PRINTER, PRINTER_ID_SET_GCODE_WINDOW,
+                       bytes([args.window])))
+    seq += 1
+    name = args.gcode.encode()[-64:]
+    start_info = struct.pack('<H', 32) + b'0' * 32 + struct.pack('<H', len(name)) + name
+    port.write(package(SACP_ATTR_REQ, seq, COMMAND_SET_PRINTER, PRINTER_ID_START_WORK, start_info))
+
+    sent = 0
+    first_req = None
+    done = False
+    while not done:
+        for attr, rseq, cmd_set, cmd_id, data in reader.frames():
+            if cmd_set != COMMAND_SET_PRINTER:
+                continue
+            if cmd_id == PRINTER_ID_REQ_GCODE and attr == SACP_ATTR_REQ:
+                start, max_size = struct.unpack('<IH', data[:6])
+                count = len(lines)
+            elif cmd_id == PRINTER_ID_REQ_GCODE_RANGE and attr == SACP_ATTR_REQ:
+                start, count, max_size = struct.unpack('<IHH', data[:8])
+            elif cmd_id == PRINTER_ID_REPORT_STATUS:
+                done = True
+                continue
+            else:
+                continue
+            if first_req is None:
+                first_req = time.time()
+            pack, n = gcode_pack(lines, start, count, max_size)
+            port.write(package(SACP_ATTR_ACK, rseq, COMMAND_SET_PRINTER, cmd_id, pack))
+            sent += n
+            if start >= len(lines):
+                elapsed = time.time() - first_req
+                print('{} lines in {:.2f} s, {:.0f} lines/s, window {}'.format(
+                      sent, elapsed, sent / elapsed if elapsed else 0, args.window))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())